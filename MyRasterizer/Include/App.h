@@ -1,9 +1,11 @@
 #pragma once
 #include "Matrix/Matrix4.h"
+#include "AssetRegistry.h"
 #include "Rasterizer.h"
 #include "Camera.h"
 #include "Scene.h"
 #include "Texture.h"
+#include "TextureLoader.h"
 #include "Angle/Degree.h"
 
 namespace My
@@ -37,12 +39,14 @@ namespace My
 	private:
 		const float				MOVE_SPEED = 1.f;
 		const LibMath::Degree	ROTATION_SPEED = 10_deg;
-		const Texture			CONTAINER_TEXTURE = Texture("../img/container.png");
 
-		Texture		m_renderTexture;
-		Rasterizer	m_rasterizer;
-		Camera		m_camera;
-		Scene		m_scene;
+		Texture			m_renderTexture;
+		Rasterizer		m_rasterizer;
+		Camera			m_camera;
+		Scene			m_scene;
+		AssetRegistry	m_assets;
+		TextureLoader	m_textureLoader;
+		TextureHandle	m_containerTexture;
 
 		/**
 		 * \brief Creates or resets the scene to render
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "Mesh.h"
+#include "Texture.h"
+
+namespace My
+{
+	class AssetRegistry
+	{
+	public:
+		typedef std::function<Mesh*()> MeshFactory;
+
+		AssetRegistry() = default;
+		AssetRegistry(const AssetRegistry& p_other) = delete;
+		AssetRegistry(AssetRegistry&& p_other) = delete;
+
+		/**
+		 * \brief Forgets the cached assets. Assets still in use live until their last handle is released
+		 */
+		~AssetRegistry() = default;
+
+		AssetRegistry& operator=(const AssetRegistry& p_other) = delete;
+		AssetRegistry& operator=(AssetRegistry&& p_other) = delete;
+
+		/**
+		 * \brief Gives the texture stored in the given image, only loading it if no live texture was loaded
+		 * from the same path or from an image of identical content. Safe to call from any thread
+		 * \param p_imagePath The path of the image to load
+		 * \param p_layout The layout in which the pixels should be stored
+		 * \return A handle keeping the texture alive. Meshes only point to their texture, so the handle must
+		 * be kept as long as meshes use it
+		 */
+		std::shared_ptr<const Texture>	loadTexture(const std::string& p_imagePath,
+			ETextureLayout p_layout = ETextureLayout::E_TILED);
+
+		/**
+		 * \brief Gives the mesh stored in the given OBJ or PLY file, only loading it if no live mesh was
+		 * loaded from the same path. Safe to call from any thread
+		 * \param p_path The path of the mesh to load
+		 * \return A handle keeping the mesh alive, which can be shared with scenes
+		 */
+		std::shared_ptr<const Mesh>		loadMesh(const std::string& p_path);
+
+		/**
+		 * \brief Gives the mesh registered under the given key, creating it if no live mesh uses the key.
+		 * Used for procedural meshes, keyed by their parameters. Safe to call from any thread
+		 * \param p_key The name identifying the mesh
+		 * \param p_factory Creates the mesh with new, the registry taking ownership of it
+		 * \return A handle keeping the mesh alive, which can be shared with scenes
+		 */
+		std::shared_ptr<const Mesh>		findOrCreateMesh(const std::string& p_key, const MeshFactory& p_factory);
+
+		/**
+		 * \brief Forgets the assets which were released by all their users
+		 */
+		void	purge();
+
+		/**
+		 * \brief Gives the number of cached textures still in use
+		 * \return The number of live textures
+		 */
+		size_t	getTextureCount() const;
+
+		/**
+		 * \brief Gives the number of cached meshes still in use
+		 * \return The number of live meshes
+		 */
+		size_t	getMeshCount() const;
+
+	private:
+		// Images are identified by the hash and size of their content, along with their layout
+		typedef std::pair<uint64_t, size_t>	ContentKey;
+
+		/**
+		 * \brief Finds the live asset of the given key
+		 * \return A handle to the asset (empty if the asset isn't cached or was released)
+		 */
+		template <typename TAsset, typename TKey>
+		static std::shared_ptr<const TAsset>	find(const std::map<TKey, std::weak_ptr<const TAsset>>& p_assets,
+			const TKey& p_key);
+
+		/**
+		 * \brief Counts the live assets of the given cache
+		 */
+		template <typename TAsset, typename TKey>
+		static size_t	countLive(const std::map<TKey, std::weak_ptr<const TAsset>>& p_assets);
+
+		std::map<std::pair<std::string, ETextureLayout>, std::weak_ptr<const Texture>>	m_texturesByPath;
+		std::map<std::pair<ContentKey, ETextureLayout>, std::weak_ptr<const Texture>>	m_texturesByContent;
+		std::map<std::pair<ContentKey, ETextureLayout>, std::string>					m_contentPaths;	// The image each texture by content was decoded from
+		std::map<std::string, std::weak_ptr<const Mesh>>								m_meshes;
+		mutable std::mutex																m_mutex;
+	};
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "Color.h"
+
+namespace My
+{
+	enum class ETextureCompression : uint8_t
+	{
+		E_NONE,
+		E_BC1,	// 4 bits per texel, opaque or with binary alpha
+		E_BC3	// 8 bits per texel, with smooth alpha
+	};
+
+	struct BC1Block
+	{
+		uint16_t	m_color0;	// RGB 565 endpoints
+		uint16_t	m_color1;
+		uint32_t	m_indices;	// 2 bits per texel, in row-major order
+	};
+
+	struct BC3Block
+	{
+		uint8_t		m_alpha0;
+		uint8_t		m_alpha1;
+		uint8_t		m_alphaIndices[6];	// 3 bits per texel, in row-major order
+		BC1Block	m_color;			// Always uses four colors
+	};
+
+	static_assert(sizeof(BC1Block) == 8, "BC1 blocks should take 8 bytes");
+	static_assert(sizeof(BC3Block) == 16, "BC3 blocks should take 16 bytes");
+
+	class BlockCompression
+	{
+	public:
+		// Width and height of a block, in texels
+		static constexpr uint32_t BLOCK_SIZE = 4;
+
+		// Number of texels of a block
+		static constexpr uint32_t BLOCK_TEXEL_COUNT = BLOCK_SIZE * BLOCK_SIZE;
+
+		/**
+		 * \brief Gives the size of a block of the given format
+		 * \param p_compression The block format (must not be E_NONE)
+		 * \return The number of bytes of a block
+		 */
+		static size_t getBlockByteCount(ETextureCompression p_compression);
+
+		/**
+		 * \brief Compresses the given texels, using the three color mode for texels whose alpha is below half
+		 * \param p_texels The block's texels, in row-major order
+		 * \return The compressed block
+		 */
+		static BC1Block encodeBC1(const Color p_texels[BLOCK_TEXEL_COUNT]);
+
+		/**
+		 * \brief Compresses the given texels' colors and alpha separately
+		 * \param p_texels The block's texels, in row-major order
+		 * \return The compressed block
+		 */
+		static BC3Block encodeBC3(const Color p_texels[BLOCK_TEXEL_COUNT]);
+
+		/**
+		 * \brief Decompresses the given block
+		 * \param p_block The block to decode
+		 * \param p_texels Receives the block's texels, in row-major order
+		 */
+		static void decodeBC1(const BC1Block& p_block, Color p_texels[BLOCK_TEXEL_COUNT]);
+
+		/**
+		 * \brief Decompresses the given block
+		 * \param p_block The block to decode
+		 * \param p_texels Receives the block's texels, in row-major order
+		 */
+		static void decodeBC3(const BC3Block& p_block, Color p_texels[BLOCK_TEXEL_COUNT]);
+
+	private:
+		/**
+		 * \brief Fits the endpoints of the given texels' colors to their inset bounding box and picks the closest
+		 * of the interpolated colors for each texel
+		 * \param p_texels The block's texels
+		 * \param p_hasTransparency Whether the texels whose alpha is below half should use the transparent index
+		 * \return The color part of the block
+		 */
+		static BC1Block encodeColors(const Color p_texels[BLOCK_TEXEL_COUNT], bool p_hasTransparency);
+
+		/**
+		 * \brief Decodes the color part of a block
+		 * \param p_block The color part to decode
+		 * \param p_isFourColors Whether the block always uses four colors, as BC3 blocks do
+		 * \param p_texels Receives the block's texels
+		 */
+		static void decodeColors(const BC1Block& p_block, bool p_isFourColors, Color p_texels[BLOCK_TEXEL_COUNT]);
+	};
+}
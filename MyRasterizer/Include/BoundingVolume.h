@@ -0,0 +1,62 @@
+#pragma once
+#include "Matrix/Matrix4.h"
+#include "Vector/Vector3.h"
+
+namespace My
+{
+	struct BoundingSphere
+	{
+		LibMath::Vector3	m_center;
+		float				m_radius = 0.f;
+
+		/**
+		 * \brief Computes the sphere containing this one once transformed by the given matrix
+		 * \param p_transform The transformation matrix to apply
+		 * \return The transformed bounding sphere
+		 */
+		BoundingSphere transformed(const LibMath::Matrix4& p_transform) const;
+	};
+
+	struct AABB
+	{
+		LibMath::Vector3	m_min;
+		LibMath::Vector3	m_max;
+
+		/**
+		 * \brief Computes the axis aligned box containing this one once transformed by the given matrix
+		 * \param p_transform The transformation matrix to apply
+		 * \return The transformed bounding box
+		 */
+		AABB transformed(const LibMath::Matrix4& p_transform) const;
+
+		/**
+		 * \brief Gives the center of the box
+		 * \return The point halfway between the box's min and max corners
+		 */
+		LibMath::Vector3 getCenter() const;
+
+		/**
+		 * \brief Gives the half size of the box on each axis
+		 * \return The distance between the box's center and its max corner
+		 */
+		LibMath::Vector3 getExtents() const;
+
+		/**
+		 * \brief Gives the total area of the box's faces
+		 * \return The surface area of the box
+		 */
+		float getSurfaceArea() const;
+
+		/**
+		 * \brief Grows the box to contain the given one
+		 * \param p_other The box to include
+		 */
+		void expand(const AABB& p_other);
+
+		/**
+		 * \brief Creates an empty box which contains the first box it is expanded with
+		 * \return A box with an infinite min corner and a negative infinite max corner
+		 */
+		static AABB empty();
+	};
+}
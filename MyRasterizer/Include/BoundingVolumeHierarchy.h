@@ -0,0 +1,151 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "BoundingVolume.h"
+#include "Vector/Vector3.h"
+
+namespace My
+{
+	class Frustum;
+
+	class BoundingVolumeHierarchy
+	{
+		using Vec3 = LibMath::Vector3;
+
+	public:
+		typedef std::function<bool(const AABB& p_bounds)>	NodeFilter;
+		typedef std::function<void(size_t p_item)>			ItemVisitor;
+
+		/**
+		 * \brief Rebuilds the whole tree over the given items using the surface area heuristic
+		 * \param p_itemBounds The bounding box of each item
+		 */
+		void build(const std::vector<AABB>& p_itemBounds);
+
+		/**
+		 * \brief Removes every item from the tree
+		 */
+		void clear();
+
+		/**
+		 * \brief Gives the number of items in the tree
+		 * \return The number of items the tree was built with
+		 */
+		size_t getItemCount() const;
+
+		/**
+		 * \brief Gives read access to the bounding box of the given item
+		 * \param p_item The index of the item
+		 * \return The item's bounding box
+		 */
+		const AABB& getItemBounds(size_t p_item) const;
+
+		/**
+		 * \brief Changes the bounding box of the given item.
+		 * The tree is only updated on the next call to refit
+		 * \param p_item The index of the item
+		 * \param p_bounds The item's new bounding box
+		 */
+		void updateItem(size_t p_item, const AABB& p_bounds);
+
+		/**
+		 * \brief Checks whether some items were updated since the last refit
+		 * \return True if the tree needs to be refit. False otherwise
+		 */
+		bool needsRefit() const;
+
+		/**
+		 * \brief Grows or shrinks the nodes containing the updated items
+		 * and rebuilds the tree if its quality degraded too much
+		 */
+		void refit();
+
+		/**
+		 * \brief Finds the items whose bounding box is at least partially inside the given frustum
+		 * \param p_frustum The frustum to test the items against
+		 * \param p_items The vector to which the visible items' indices are appended
+		 */
+		void queryFrustum(const Frustum& p_frustum, std::vector<size_t>& p_items) const;
+
+		/**
+		 * \brief Finds the closest item whose bounding box is hit by the given ray
+		 * \param p_origin The ray's starting point
+		 * \param p_direction The ray's direction
+		 * \param p_item The index of the hit item (unchanged if nothing is hit)
+		 * \param p_distance The hit distance in multiples of the direction's length (unchanged if nothing is hit)
+		 * \return True if an item was hit. False otherwise
+		 */
+		bool raycast(const Vec3& p_origin, const Vec3& p_direction, size_t& p_item, float& p_distance) const;
+
+		/**
+		 * \brief Walks the tree, skipping the branches rejected by the given filter
+		 * \param p_nodeFilter Returns whether the node with the given bounds should be visited
+		 * \param p_itemVisitor Called for each item whose own bounds pass the filter
+		 */
+		void traverse(const NodeFilter& p_nodeFilter, const ItemVisitor& p_itemVisitor) const;
+
+		/**
+		 * \brief Gives the surface area heuristic cost of the tree, relative to its root's area
+		 * \return The expected cost of a ray traversal
+		 */
+		float getCost() const;
+
+	private:
+		struct Node
+		{
+			AABB		m_bounds;
+			uint32_t	m_first;	// First item for leaves, left child for internal nodes
+			uint32_t	m_count;	// 0 for internal nodes
+		};
+
+		static constexpr uint32_t	INVALID_NODE = UINT32_MAX;
+		static constexpr uint32_t	MAX_LEAF_SIZE = 16;
+		static constexpr size_t		BIN_COUNT = 12;
+
+		// Rebuild once refitting made traversals this much more expensive than after the last build
+		static constexpr float		REBUILD_THRESHOLD = 1.5f;
+
+		/**
+		 * \brief Splits the given node along the cheapest binned plane if that beats keeping it as a leaf
+		 * \param p_nodeIndex The index of the node to split
+		 * \param p_centroids The center of each item's bounding box
+		 * \return True if the node was split. False otherwise
+		 */
+		bool splitNode(uint32_t p_nodeIndex, const std::vector<Vec3>& p_centroids);
+
+		/**
+		 * \brief Recomputes the bounds of the given node from its children or items
+		 * \param p_nodeIndex The index of the node to refit
+		 */
+		void refitNode(uint32_t p_nodeIndex);
+
+		/**
+		 * \brief Computes the surface area heuristic cost of the tree
+		 * \return The tree's cost relative to its root's area
+		 */
+		float computeCost() const;
+
+		/**
+		 * \brief Computes the distance at which the given ray enters the given box
+		 * \param p_bounds The box to test
+		 * \param p_origin The ray's starting point
+		 * \param p_invDirection The inverse of each component of the ray's direction
+		 * \param p_maxDistance The distance after which hits are ignored
+		 * \return The entry distance or infinity if the box is missed
+		 */
+		static float intersectRay(const AABB& p_bounds, const Vec3& p_origin,
+			const Vec3& p_invDirection, float p_maxDistance);
+
+		std::vector<Node>		m_nodes;
+		std::vector<uint32_t>	m_parents;
+		std::vector<uint32_t>	m_items;		// Item indices sorted so that each leaf's items are contiguous
+		std::vector<uint32_t>	m_itemLeaves;
+		std::vector<AABB>		m_itemBounds;
+		std::vector<uint32_t>	m_updatedItems;
+		std::vector<uint8_t>	m_isItemUpdated;
+		float					m_buildCost = 0.f;
+		float					m_cost = 0.f;
+	};
+}
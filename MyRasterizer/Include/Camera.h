@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Frustum.h"
 #include "ITransformable.h"
 
 namespace My
@@ -36,6 +37,12 @@ namespace My
 		 */
 		void setProjectionMatrix(const Mat4& p_projection);
 
+		/**
+		 * \brief Computes the world space planes of the camera's view frustum
+		 * \return The camera's frustum
+		 */
+		Frustum getFrustum() const;
+
 	private:
 		Mat4	m_projectionMatrix;
 	};
@@ -1,4 +1,5 @@
 #pragma once
+#include "BoundingVolume.h"
 #include "ITransformable.h"
 #include "Matrix/Matrix4.h"
 #include "Matrix/Matrix3.h"
@@ -9,6 +10,7 @@
 namespace My
 {
 	class Mesh;
+	class Scene;
 
 	class Entity : public ITransformable
 	{
@@ -21,8 +23,8 @@ namespace My
 		#pragma region Constructors
 		explicit	Entity(const Mesh& p_mesh, const Mat4& p_transform = Mat4()); // TODO : Finish Entity comments
 		Entity(const Mesh& p_mesh, float p_transparency, const Mat4& p_transform = Mat4());
-		Entity(const Entity& p_other) = default;
-		Entity(Entity&& p_other) = default;
+		Entity(const Entity& p_other);
+		Entity(Entity&& p_other);
 		~Entity() = default;
 		#pragma endregion
 
@@ -44,27 +46,51 @@ namespace My
 		/// </summary>
 		/// <returns>True if the entity is fully opaque. False otherwise</returns>
 		bool isOpaque() const;
+
+		/// <summary>
+		/// Get the entity's mesh bounding box in world space
+		/// </summary>
+		/// <returns>The axis aligned box containing the transformed mesh</returns>
+		AABB getBoundingBox() const;
+
+		/// <summary>
+		/// Get the entity's mesh bounding sphere in world space
+		/// </summary>
+		/// <returns>The sphere containing the transformed mesh</returns>
+		BoundingSphere getBoundingSphere() const;
 		#pragma endregion
 
 		#pragma region Operators
 		/// <summary>
-		/// Copy operator
+		/// Copy operator - the entity stays in its own scene
 		/// </summary>
 		/// <param name="p_other"></param>
 		/// <returns></returns>
-		Entity& operator=(const Entity& p_other) = default;
+		Entity& operator=(const Entity& p_other);
 
 		/// <summary>
-		/// Move operator
+		/// Move operator - the entity stays in its own scene
 		/// </summary>
 		/// <param name="p_other"></param>
 		/// <returns></returns>
-		Entity& operator=(Entity&& p_other) = default;
+		Entity& operator=(Entity&& p_other);
 #pragma endregion
 
+	protected:
+		/// <summary>
+		/// Notifies the owning scene that the entity's bounds have to be updated
+		/// </summary>
+		void onTransformChanged() override;
+
 	private:
+		friend class Scene;
+
 		const Mesh* m_mesh = nullptr;
 		float		m_transparency;
+
+		// Set by the scene holding the entity - copies and moved-to entities don't belong to any scene
+		Scene*		m_scene = nullptr;
+		size_t		m_sceneIndex = 0;
 	};
 }
 
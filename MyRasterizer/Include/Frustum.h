@@ -0,0 +1,52 @@
+#pragma once
+#include "BoundingVolume.h"
+#include "Matrix/Matrix4.h"
+
+namespace My
+{
+	class Frustum
+	{
+	public:
+		Frustum() = default;
+
+		/**
+		 * \brief Extracts the frustum planes from the given view-projection matrix
+		 * \param p_viewProjection The matrix used to transform points from world space to clip space
+		 */
+		explicit Frustum(const LibMath::Matrix4& p_viewProjection);
+
+		/**
+		 * \brief Checks whether the given sphere is at least partially inside the frustum
+		 * \param p_sphere The sphere to test (in the frustum's space)
+		 * \return True if the sphere isn't entirely behind one of the planes. False otherwise
+		 */
+		bool intersects(const BoundingSphere& p_sphere) const;
+
+		/**
+		 * \brief Checks whether the given box is at least partially inside the frustum
+		 * \param p_box The box to test (in the frustum's space)
+		 * \return True if the box isn't entirely behind one of the planes. False otherwise
+		 */
+		bool intersects(const AABB& p_box) const;
+
+		/**
+		 * \brief Checks whether the given box is entirely inside the frustum
+		 * \param p_box The box to test (in the frustum's space)
+		 * \return True if the box is in front of every plane. False otherwise
+		 */
+		bool contains(const AABB& p_box) const;
+
+	private:
+		static constexpr size_t PLANE_COUNT = 6;
+		static constexpr size_t PADDED_PLANE_COUNT = 8;
+
+		/*
+		 * The planes are stored as separate component arrays so they can be tested four at a time.
+		 * The padding planes have a null normal and a positive distance so they never reject anything.
+		 */
+		alignas(16) float	m_normalX[PADDED_PLANE_COUNT] = {};
+		alignas(16) float	m_normalY[PADDED_PLANE_COUNT] = {};
+		alignas(16) float	m_normalZ[PADDED_PLANE_COUNT] = {};
+		alignas(16) float	m_distance[PADDED_PLANE_COUNT] = { 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f };
+	};
+}
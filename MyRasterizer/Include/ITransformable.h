@@ -232,6 +232,11 @@ namespace My
 	protected:
 		ITransformable(Mat4 p_transform);
 
+		/// <summary>
+		/// Called after every change of the transformation matrix
+		/// </summary>
+		virtual void onTransformChanged();
+
 	private:
 		Mat4		m_transform;
 
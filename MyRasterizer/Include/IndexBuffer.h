@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace My
+{
+	enum class EIndexType : uint8_t
+	{
+		E_UINT16,
+		E_UINT32
+	};
+
+	class IndexBuffer
+	{
+	public:
+		IndexBuffer() = default;
+
+		/**
+		 * \brief Stores the given indices using the smallest type able to address every vertex
+		 * \param p_indices The indices to store
+		 * \param p_vertexCount The number of vertices the indices refer to
+		 */
+		IndexBuffer(const std::vector<size_t>& p_indices, size_t p_vertexCount);
+
+		/**
+		 * \brief Takes over the given 32 bit indices, narrowing them to 16 bits if possible
+		 * \param p_indices The indices to store
+		 * \param p_vertexCount The number of vertices the indices refer to
+		 */
+		IndexBuffer(std::vector<uint32_t>&& p_indices, size_t p_vertexCount);
+
+		/**
+		 * \brief Refers to indices stored elsewhere, such as in a mapped file, without copying them.
+		 * The indices must outlive the buffer and its copies
+		 * \param p_type The type in which the indices are stored
+		 * \param p_indices The first index
+		 * \param p_count The number of indices
+		 */
+		IndexBuffer(EIndexType p_type, const void* p_indices, size_t p_count);
+
+		/**
+		 * \brief Gives the type in which the indices are stored
+		 * \return 16 bit indices for meshes of up to 65536 vertices, 32 bit indices otherwise
+		 */
+		EIndexType getType() const;
+
+		/**
+		 * \brief Gives the number of indices in the buffer
+		 * \return The number of indices
+		 */
+		size_t size() const;
+
+		/**
+		 * \brief Checks whether the buffer holds no index
+		 * \return True if the buffer is empty. False otherwise
+		 */
+		bool empty() const;
+
+		/**
+		 * \brief Gives read access to the given index. Prefer visit in loops
+		 * \param p_position The position of the index in the buffer
+		 * \return The index of the vertex
+		 */
+		size_t operator[](size_t p_position) const;
+
+		/**
+		 * \brief Copies the indices into a vector of size_t
+		 * \return The buffer's indices
+		 */
+		std::vector<size_t> toVector() const;
+
+		/**
+		 * \brief Calls the given function with a pointer to the indices in their stored type
+		 * so that the loops over them are compiled once for each index width
+		 * \param p_func The function to call with either a const uint16_t* or a const uint32_t*
+		 * \return The value returned by the function
+		 */
+		template <typename TFunc>
+		decltype(auto) visit(TFunc&& p_func) const
+		{
+			if (m_type == EIndexType::E_UINT16)
+				return p_func(m_externalIndices != nullptr ? static_cast<const uint16_t*>(m_externalIndices) : m_indices16.data());
+
+			return p_func(m_externalIndices != nullptr ? static_cast<const uint32_t*>(m_externalIndices) : m_indices32.data());
+		}
+
+		/**
+		 * \brief Checks whether the indices are stored outside of the buffer
+		 * \return True if the buffer refers to external indices. False if it owns them
+		 */
+		bool isExternal() const;
+
+	private:
+		std::vector<uint16_t>	m_indices16;
+		std::vector<uint32_t>	m_indices32;
+		const void*				m_externalIndices = nullptr;
+		size_t					m_externalCount = 0;
+		EIndexType				m_type = EIndexType::E_UINT16;
+	};
+}
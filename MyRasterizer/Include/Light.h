@@ -14,6 +14,9 @@ namespace My
 		using Rad =  LibMath::Radian;
 
 	public:
+		// Shininess used when none is given to the reflection models
+		static constexpr int DEFAULT_SHININESS = 20;
+
 		/// <summary>
 		/// Light source to illuminate entities at p_position.
 		/// Components are percents that must add to 1
@@ -40,6 +43,24 @@ namespace My
 
 		~Light() = default;
 
+		/**
+		 * \brief Gives read access to the light's position
+		 * \return The light's world position
+		 */
+		const Vec3& getPosition() const;
+
+		/**
+		 * \brief Gives the light's ambient, diffuse and specular components
+		 * \return The components' percents, in this order
+		 */
+		Vec3 getComponents() const;
+
+		/**
+		 * \brief Gives read access to the light's intensity
+		 * \return The intensity of the light's red, green and blue components
+		 */
+		const Vec3& getIntensity() const;
+
 		/// <summary>
 		/// Calculate the luminosity/color of a vertex based on the Phong method
 		/// </summary>
@@ -60,7 +81,7 @@ namespace My
 		 */
 		Color calculateLightingBlinnPhong(const Vec3& p_position,
 			const Color& p_color, const Vec3& p_normal, const Vec3& p_viewPos,
-			int p_shininess = 20) const;
+			int p_shininess = DEFAULT_SHININESS) const;
 
 		//Color static ApplyLightToColor(const Color& p_color, float lightValue);
 
@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+
+namespace My
+{
+	class MappedFile
+	{
+	public:
+		/**
+		 * \brief Maps the given file in memory for reading. The pages are only loaded when touched
+		 * \param p_path The path of the file to map
+		 * \param p_isCopyOnWrite Whether the mapping can be written to. Written pages are copied
+		 * in private memory and never reach the file (false by default)
+		 */
+		explicit MappedFile(const std::string& p_path, bool p_isCopyOnWrite = false);
+
+		MappedFile(const MappedFile& p_other) = delete;
+
+		/**
+		 * \brief Takes over the mapping of the given file
+		 * \param p_other The mapped file to move
+		 */
+		MappedFile(MappedFile&& p_other) noexcept;
+
+		/**
+		 * \brief Unmaps and closes the file
+		 */
+		~MappedFile();
+
+		MappedFile& operator=(const MappedFile& p_other) = delete;
+
+		/**
+		 * \brief Unmaps the current file then takes over the mapping of the given one
+		 * \param p_other The mapped file to move
+		 */
+		MappedFile& operator=(MappedFile&& p_other) noexcept;
+
+		/**
+		 * \brief Gives read access to the content of the file
+		 * \return A pointer to the first byte of the file (nullptr if the file is empty)
+		 */
+		const char* getData() const;
+
+		/**
+		 * \brief Gives write access to the content of the file. Throws if the mapping isn't copy-on-write
+		 * \return A pointer to the first byte of the file (nullptr if the file is empty)
+		 */
+		char* getWritableData();
+
+		/**
+		 * \brief Gives the size of the file
+		 * \return The number of bytes of the file
+		 */
+		size_t getSize() const;
+
+	private:
+		/**
+		 * \brief Unmaps and closes the file, if any
+		 */
+		void close();
+
+		char*		m_data = nullptr;
+		size_t		m_size = 0;
+		bool		m_isCopyOnWrite = false;
+
+#ifdef _WIN32
+		void*		m_file = nullptr;
+		void*		m_mapping = nullptr;
+#else
+		int			m_file = -1;
+#endif
+	};
+}
@@ -1,7 +1,12 @@
 #pragma once
 #include <vector>
+#include "BoundingVolume.h"
+#include "IndexBuffer.h"
+#include "PackedVertex.h"
 #include "Vertex.h"
+#include "VertexStreams.h"
 #include "Texture.h"
+#include "Trigonometry.h"
 #include "Vector/Vector3.h"
 
 namespace My
@@ -47,6 +52,27 @@ namespace My
 		 */
 		Mesh(const std::vector<Vertex>& p_vertices, const std::vector<size_t>& p_indices, const Texture* p_texture = nullptr);
 
+		/**
+		 * \brief Creates a mesh taking over the given buffers, without copying them
+		 * \param p_vertices The vertex buffer of the mesh
+		 * \param p_indices The index buffer of the mesh
+		 * \param p_texture The texture of the mesh (nullptr by default)
+		 */
+		Mesh(std::vector<Vertex>&& p_vertices, IndexBuffer&& p_indices, const Texture* p_texture = nullptr);
+
+		/**
+		 * \brief Creates a mesh referring to buffers stored elsewhere, such as in a mapped scene pack, without
+		 * copying them. The buffers must outlive the mesh and its copies, and are only copied once the mesh is modified
+		 * \param p_vertices The vertex buffer of the mesh
+		 * \param p_indices The index buffer of the mesh
+		 * \param p_normals The normal of each triangle
+		 * \param p_boundingBox The smallest axis aligned box containing every vertex
+		 * \param p_boundingSphere A sphere containing every vertex
+		 * \param p_texture The texture of the mesh (nullptr by default)
+		 */
+		Mesh(StreamView<Vertex> p_vertices, const IndexBuffer& p_indices, StreamView<Vec3> p_normals,
+			const AABB& p_boundingBox, const BoundingSphere& p_boundingSphere, const Texture* p_texture = nullptr);
+
 		/**
 		 * \brief Creates a copy of the given mesh
 		 * \param p_other The mesh to copy
@@ -79,32 +105,123 @@ namespace My
 
 		/**
 		 * \brief Gives read access to the vertex buffer of the mesh
-		 * \return The mesh's vertex buffer
+		 * \return The mesh's vertex buffer (empty if the vertices are compressed or stored in separate streams)
+		 */
+		StreamView<Vertex>	getVertices() const;
+
+		/**
+		 * \brief Gives read access to the compressed vertex buffer of the mesh
+		 * \return The mesh's packed vertices (empty if the vertices aren't compressed)
+		 */
+		const std::vector<PackedVertex>&	getPackedVertices() const;
+
+		/**
+		 * \brief Gives read access to the per attribute vertex streams of the mesh
+		 * \return The mesh's vertex streams (empty unless the layout is separate)
+		 */
+		const VertexStreams&	getVertexStreams() const;
+
+		/**
+		 * \brief Gives the way the full precision vertices are laid out in memory
+		 * \return Interleaved for a buffer of Vertex, separate for one stream per attribute component
+		 */
+		EVertexLayout getVertexLayout() const;
+
+		/**
+		 * \brief Lays the vertices of the mesh and of its levels of detail out as the given layout.
+		 * Separate streams let the passes that only need positions skip the other attributes.
+		 * Compressed vertices are decompressed first since packed vertices are always interleaved
+		 * \param p_layout The layout the vertices should be stored in
+		 */
+		void setVertexLayout(EVertexLayout p_layout);
+
+		/**
+		 * \brief Gives read access to the mapping between the packed and the full precision vertices
+		 * \return The quantization used to compress the vertices
 		 */
-		std::vector<Vertex>	getVertices() const;
+		const VertexQuantization&	getVertexQuantization() const;
+
+		/**
+		 * \brief Gives the number of vertices of the mesh, whether they are compressed or not
+		 * \return The number of vertices
+		 */
+		size_t getVertexCount() const;
+
+		/**
+		 * \brief Copies the vertices of the mesh, decompressing them if needed
+		 * \return The mesh's vertices in full precision
+		 */
+		std::vector<Vertex> decodeVertices() const;
+
+		/**
+		 * \brief Checks whether the vertices are stored in the packed format
+		 * \return True if the vertices are compressed. False otherwise
+		 */
+		bool hasCompressedVertices() const;
+
+		/**
+		 * \brief Packs the vertices of the mesh and of its levels of detail in 16 bytes instead of 40:
+		 * positions in 16 bit fixed point inside the bounding box, octahedral normals and half float UVs.
+		 * Vertices stored in separate streams are interleaved first
+		 */
+		void compressVertices();
+
+		/**
+		 * \brief Unpacks the vertices of the mesh and of its levels of detail (the lost precision isn't recovered)
+		 */
+		void decompressVertices();
 
 		/**
 		 * \brief Gives read access to the index buffer of the mesh
-		 * \return The mesh's index buffer
+		 * \return The mesh's index buffer, stored in 16 bits when the mesh has few enough vertices
 		 */
-		std::vector<size_t>	getIndices() const;
+		const IndexBuffer&	getIndices() const;
 
 		/// <summary>
 		/// Gives read acces to the mesh's normal buffer
 		/// </summary>
 		/// <returns></returns>
-		std::vector<LibMath::Vector3> getNormals() const;
+		StreamView<LibMath::Vector3> getNormals() const;
 
 		/**
-		* \brief Calculates the normal of each Vertex based on triangle normals
-		*/
-		void calculateVertexNormals();
+		 * \brief Checks whether the mesh's buffers are stored outside of it
+		 * \return True if the mesh still refers to external buffers. False if it owns them
+		 */
+		bool hasExternalBuffers() const;
+
+		/**
+		 * \brief Calculates the normal of each vertex as the angle weighted average of the normals of the
+		 * triangles around its position, so that vertices split along UV or color seams stay smooth.
+		 * Triangles further than the smoothing angle from the vertex's own triangles are left out to keep hard edges
+		 * \param p_smoothingAngle The largest angle between triangles smoothed together (all of them by default)
+		 */
+		void calculateVertexNormals(const LibMath::Radian& p_smoothingAngle = LibMath::Radian(LibMath::g_pi));
 
 		/**
 		* \brief Calculates the normal of each Triangle
 		*/
 		void calculateTriangleNormals();
 
+		/**
+		 * \brief Gives read access to the mesh's local space bounding box
+		 * \return The smallest axis aligned box containing every vertex of the mesh
+		 */
+		const AABB& getBoundingBox() const;
+
+		/**
+		 * \brief Gives read access to the mesh's local space bounding sphere
+		 * \return A sphere containing every vertex of the mesh
+		 */
+		const BoundingSphere& getBoundingSphere() const;
+
+		/**
+		 * \brief Reorders the triangles for the post-transform vertex cache, then in clusters sorted from the
+		 * most outward facing to reduce overdraw, and finally the vertices in the order they are first used.
+		 * The levels of detail are optimized as well
+		 * \param p_overdrawThreshold How much the clustering may raise the cache miss ratio (1.05 allows 5%)
+		 */
+		void optimize(float p_overdrawThreshold = 1.05f);
+
 		/**
 		 * \brief Creates a cube of side 1
 		 * \param p_color The color of the cube (white by default)
@@ -113,9 +230,10 @@ namespace My
 		static Mesh* createCube(const Color& p_color = Color::white);
 
 		/**
-		 * \brief Creates a sphere of radius 1 with the given number of subdivisions
-		 * \param p_latitudeCount The number of vertical subdivisions
-		 * \param p_longitudeCount The number of horizontal subdivisions
+		 * \brief Creates a sphere of radius 1 with the given number of subdivisions.
+		 * Coarser levels of detail are generated by halving the subdivisions down to a bipyramid
+		 * \param p_latitudeCount The number of vertical subdivisions (at least 2)
+		 * \param p_longitudeCount The number of horizontal subdivisions (at least 3)
 		 * \param p_color The color of the sphere (white by default)
 		 * \return A pointer to the created sphere mesh
 		 */
@@ -134,11 +252,123 @@ namespace My
 		 */
 		void setTexture(const Texture* p_texture);
 
+		/**
+		 * \brief Checks whether the mesh is drawn in the occlusion buffer when its entity is opaque
+		 * \return True if the mesh hides what is behind it during occlusion culling. False otherwise
+		 */
+		bool isOccluder() const;
+
+		/**
+		 * \brief Sets whether the mesh is drawn in the occlusion buffer when its entity is opaque.
+		 * Occluders should be simple, closed meshes
+		 * \param p_isOccluder Whether the mesh should hide what is behind it during occlusion culling
+		 */
+		void setOccluder(bool p_isOccluder);
+
+		/**
+		 * \brief Appends a coarser level of detail to the mesh.
+		 * Levels must be added from the finest to the coarsest
+		 * \param p_lod A simplified version of the mesh
+		 */
+		void addLod(const Mesh& p_lod);
+
+		/**
+		 * \brief Gives the number of levels of detail of the mesh
+		 * \return The number of levels, including the mesh itself
+		 */
+		size_t getLodCount() const;
+
+		/**
+		 * \brief Gives read access to the given level of detail
+		 * \param p_level The level to get (0 being the mesh itself)
+		 * \return The mesh of the given level
+		 */
+		const Mesh& getLod(size_t p_level) const;
+
+		/**
+		 * \brief Gives the projected diameter, in pixels, from which the given level can be used.
+		 * The threshold grows with the level's triangle count to keep triangles from getting too small
+		 * \param p_level The level whose threshold should be returned
+		 * \return The smallest screen size at which the level should be drawn
+		 */
+		float getLodScreenSize(size_t p_level) const;
+
+		/**
+		 * \brief Replaces the mesh's levels of detail by simplified versions of it. Each level is
+		 * simplified from the previous one and keeps its vertices' colors, normals and UVs
+		 * \param p_triangleRatios The fraction of the triangles each level should keep, from the finest to the coarsest
+		 */
+		void generateLods(const std::vector<float>& p_triangleRatios);
+
 	private:
-		std::vector<Vertex>	m_vertices;
-		std::vector<size_t>	m_indices;
-		std::vector<Vec3>	m_normals;
-		const Texture*		m_texture;
+		// Average projected area, in pixels, a triangle of the selected level of detail should cover
+		static constexpr float PIXELS_PER_TRIANGLE = 4.f;
+
+		// Distance under which positions are welded, relative to the largest side of the bounding box
+		static constexpr float WELD_TOLERANCE = 1e-5f;
+
+		// Smallest number of triangles or vertices processed by a task when generating normals
+		static constexpr size_t NORMAL_CHUNK_SIZE = 4096;
+
+		/**
+		 * \brief Gives each vertex the index of the first vertex closer than the weld tolerance, using a hash grid
+		 * \return The index of the vertex sharing each vertex's position
+		 */
+		std::vector<uint32_t> weldPositions() const;
+
+		/**
+		 * \brief Computes the bounding box and sphere of the vertex buffer
+		 */
+		void calculateBounds();
+
+		/**
+		 * \brief Copies the external buffers into the mesh so that they can be modified
+		 */
+		void copyExternalBuffers();
+
+		/**
+		 * \brief Moves the mesh's own vertices to the packed buffer
+		 */
+		void packVertices();
+
+		/**
+		 * \brief Moves the mesh's own vertices back to the full precision buffer
+		 */
+		void unpackVertices();
+
+		/**
+		 * \brief Moves the mesh's own vertices to separate streams
+		 */
+		void splitVertices();
+
+		/**
+		 * \brief Moves the mesh's own vertices back from separate streams to the interleaved buffer
+		 */
+		void interleaveVertices();
+
+		/**
+		 * \brief Creates a sphere of radius 1 without any level of detail
+		 * \param p_latitudeCount The number of vertical subdivisions
+		 * \param p_longitudeCount The number of horizontal subdivisions
+		 * \param p_color The color of the sphere
+		 * \return The created sphere mesh
+		 */
+		static Mesh buildSphere(uint32_t p_latitudeCount, uint32_t p_longitudeCount, const Color& p_color);
+
+		std::vector<Vertex>			m_vertices;
+		std::vector<PackedVertex>	m_packedVertices;
+		VertexStreams				m_vertexStreams;
+		VertexQuantization			m_quantization;
+		IndexBuffer					m_indices;
+		std::vector<Vec3>			m_normals;
+		StreamView<Vertex>			m_externalVertices;
+		StreamView<Vec3>			m_externalNormals;
+		bool						m_hasExternalBuffers = false;
+		const Texture*				m_texture;
+		AABB						m_boundingBox;
+		BoundingSphere				m_boundingSphere;
+		bool						m_isOccluder = false;
+		std::vector<Mesh>			m_lods;
 	};
 
 }
\ No newline at end of file
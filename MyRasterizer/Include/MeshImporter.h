@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "Mesh.h"
+
+namespace My
+{
+	class MeshImporter
+	{
+	public:
+		struct Statistics
+		{
+			size_t	m_byteCount = 0;
+			size_t	m_vertexCount = 0;
+			size_t	m_triangleCount = 0;
+			double	m_seconds = 0.;
+
+			/**
+			 * \brief Gives the load speed
+			 * \return The number of megabytes read per second
+			 */
+			double getThroughput() const;
+		};
+
+		/**
+		 * \brief Loads the mesh stored in the given OBJ or binary PLY file, chosen from its extension.
+		 * The file is memory mapped and parsed in parallel on the default thread pool.
+		 * Vertex normals are generated if the file has none
+		 * \param p_path The path of the file to load
+		 * \param p_statistics Receives the size of the file and how long loading it took (optional)
+		 * \return The loaded mesh
+		 */
+		static Mesh load(const std::string& p_path, Statistics* p_statistics = nullptr);
+
+		/**
+		 * \brief Parses the given Wavefront OBJ data. Polygons are split in triangle fans and every distinct
+		 * combination of position, texture coordinates and normal becomes a vertex.
+		 * Vertex colors are read from the "v x y z r g b" extension
+		 * \param p_data The content of the file
+		 * \param p_size The number of bytes of the content
+		 * \return The parsed mesh
+		 */
+		static Mesh parseObj(const char* p_data, size_t p_size);
+
+		/**
+		 * \brief Parses the given binary (little or big endian) PLY data. Positions, normals, colors and
+		 * texture coordinates are read from the vertex element and polygons are split in triangle fans
+		 * \param p_data The content of the file
+		 * \param p_size The number of bytes of the content
+		 * \return The parsed mesh
+		 */
+		static Mesh parsePly(const char* p_data, size_t p_size);
+
+	private:
+		// Approximate number of bytes of OBJ data parsed by a task
+		static constexpr size_t OBJ_CHUNK_SIZE = 1 << 20;
+
+		// Smallest number of vertices, corners or faces processed by a task
+		static constexpr size_t ELEMENT_CHUNK_SIZE = 1 << 16;
+	};
+}
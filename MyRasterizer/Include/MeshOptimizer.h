@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Vertex.h"
+
+namespace My
+{
+	class MeshOptimizer
+	{
+	public:
+		static constexpr size_t	DEFAULT_CACHE_SIZE = 16;
+
+		/**
+		 * \brief Reorders the triangles so that they reuse the recently transformed vertices
+		 * (Tom Forsyth's linear-speed vertex cache optimisation)
+		 * \param p_indices The index buffer to reorder
+		 * \param p_vertexCount The number of vertices referenced by the index buffer
+		 */
+		static void optimizeVertexCache(std::vector<size_t>& p_indices, size_t p_vertexCount);
+
+		/**
+		 * \brief Splits the triangles into clusters that keep most of the cache locality and sorts
+		 * them from the most outward facing to the most inward facing so the front triangles tend to be drawn first
+		 * \param p_indices The cache optimized index buffer to reorder
+		 * \param p_vertices The vertices referenced by the index buffer
+		 * \param p_threshold How much higher than the input's the cache miss ratio of a cluster may get (1.05 allows 5%)
+		 */
+		static void optimizeOverdraw(std::vector<size_t>& p_indices, const std::vector<Vertex>& p_vertices,
+			float p_threshold);
+
+		/**
+		 * \brief Reorders the vertices in the order the index buffer first uses them and remaps the indices.
+		 * The unused vertices are moved to the end of the buffer
+		 * \param p_vertices The vertex buffer to reorder
+		 * \param p_indices The index buffer to remap
+		 */
+		static void optimizeVertexFetch(std::vector<Vertex>& p_vertices, std::vector<size_t>& p_indices);
+
+		/**
+		 * \brief Simulates a first in first out post-transform cache over the given index buffer
+		 * \param p_indices The index buffer to analyze
+		 * \param p_vertexCount The number of vertices referenced by the index buffer
+		 * \param p_cacheSize The number of vertices the cache holds
+		 * \return The average number of vertices transformed per triangle (between 0.5 and 3 for most meshes)
+		 */
+		static float getCacheMissRatio(const std::vector<size_t>& p_indices, size_t p_vertexCount,
+			size_t p_cacheSize = DEFAULT_CACHE_SIZE);
+
+	private:
+		// Least recently used cache emulated by the vertex cache optimisation
+		static constexpr size_t	MAX_CACHE_SIZE = 32;
+
+		// Overdraw clusters are never split below this number of triangles
+		static constexpr size_t	MIN_CLUSTER_SIZE = 32;
+
+		/**
+		 * \brief Computes how much drawing the given vertex next would benefit the cache
+		 * \param p_cachePosition The vertex's position in the cache (-1 if it isn't in the cache)
+		 * \param p_liveTriangleCount The number of triangles still using the vertex
+		 * \return The vertex's score, higher meaning it should be used sooner
+		 */
+		static float getVertexScore(int p_cachePosition, uint32_t p_liveTriangleCount);
+
+		/**
+		 * \brief Finds the triangles after which a first in first out cache holds none of the next triangle's vertices
+		 * \param p_indices The index buffer to analyze
+		 * \param p_vertexCount The number of vertices referenced by the index buffer
+		 * \param p_clusters The index of each cluster's first triangle, followed by the triangle count
+		 */
+		static void findCacheRestarts(const std::vector<size_t>& p_indices, size_t p_vertexCount,
+			std::vector<size_t>& p_clusters);
+	};
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Vertex.h"
+
+namespace My
+{
+	class Mesh;
+
+	class MeshSimplifier
+	{
+	public:
+		/**
+		 * \brief Prepares the given mesh for simplification. Vertices sharing a position are welded
+		 * for the error computation but keep their own attributes
+		 * \param p_mesh The mesh to simplify
+		 */
+		explicit MeshSimplifier(const Mesh& p_mesh);
+
+		/**
+		 * \brief Gives the number of triangles left in the simplified mesh
+		 * \return The current number of triangles
+		 */
+		size_t getTriangleCount() const;
+
+		/**
+		 * \brief Gives the largest error introduced by the collapses so far
+		 * \return The largest root mean square distance to the original surface, relative to the mesh's size
+		 */
+		float getError() const;
+
+		/**
+		 * \brief Collapses edges, cheapest first, until the mesh has at most the given number of triangles.
+		 * Open borders and UV seams only collapse along themselves and locked vertices never move.
+		 * Stops early when no more edge can be collapsed without folding a triangle over
+		 * \param p_targetTriangleCount The wanted number of triangles
+		 */
+		void simplify(size_t p_targetTriangleCount);
+
+		/**
+		 * \brief Creates a mesh from the remaining triangles, keeping only the vertices they use
+		 * \return The simplified mesh
+		 */
+		Mesh createMesh() const;
+
+	private:
+		enum class EVertexKind : uint8_t
+		{
+			E_MANIFOLD,	// Surrounded by triangles sharing a single set of attributes
+			E_BORDER,	// On a single open border
+			E_SEAM,		// On a single seam between two sets of attributes
+			E_LOCKED	// Corners, non-manifold vertices and intersecting borders or seams
+		};
+
+		// Flags of the half-edge going from a triangle corner to the next
+		enum EEdgeFlag : uint8_t
+		{
+			E_OPEN_EDGE = 1,	// No triangle shares the edge
+			E_SEAM_EDGE = 2,	// The neighbouring triangle uses other vertices at the same positions
+			E_COMPLEX_EDGE = 4	// Shared by more than two triangles
+		};
+
+		// Sum of squared distances to planes as x^T * A * x + 2 * b^T * x + c, in double precision
+		// since the errors of dense meshes are many orders of magnitude below the planes' distances
+		struct Quadric
+		{
+			double	m_a00 = 0.;
+			double	m_a11 = 0.;
+			double	m_a22 = 0.;
+			double	m_a01 = 0.;
+			double	m_a02 = 0.;
+			double	m_a12 = 0.;
+			double	m_b0 = 0.;
+			double	m_b1 = 0.;
+			double	m_b2 = 0.;
+			double	m_c = 0.;
+			double	m_weight = 0.;
+		};
+
+		struct Collapse
+		{
+			uint32_t	m_source;	// Moved onto the target's position
+			uint32_t	m_target;
+			float		m_error;
+		};
+
+		static constexpr uint32_t	INVALID_INDEX = UINT32_MAX;
+
+		// Keeps the borders and seams from drifting away from their original path
+		static constexpr float		EDGE_WEIGHT = 10.f;
+
+		// How much more than the pass' expected error a collapse can cost before waiting for the next pass
+		static constexpr float		PASS_ERROR_MARGIN = 1.5f;
+
+		/**
+		 * \brief Lists the triangles around each position
+		 */
+		void buildAdjacency();
+
+		/**
+		 * \brief Finds each half-edge's twin in parallel and sorts the positions by the collapses they allow
+		 */
+		void classifyVertices();
+
+		/**
+		 * \brief Sums the planes of the triangles and of the borders and seams around each position
+		 */
+		void initQuadrics();
+
+		/**
+		 * \brief Computes the cheapest allowed collapse of every edge in parallel
+		 * and sorts the ones worth doing in this pass
+		 * \param p_targetTriangleCount The wanted number of triangles
+		 * \param p_isErrorLimited Whether the collapses much more expensive than the pass' expected error are skipped
+		 */
+		void collectCollapses(size_t p_targetTriangleCount, bool p_isErrorLimited);
+
+		/**
+		 * \brief Applies the sorted collapses that don't touch an already moved position
+		 * \param p_targetTriangleCount The wanted number of triangles
+		 * \return The number of triangles removed by the collapses
+		 */
+		size_t performCollapses(size_t p_targetTriangleCount);
+
+		/**
+		 * \brief Makes sure moving the source position onto the target keeps the surface manifold
+		 * and doesn't flip any triangle
+		 * \param p_source The position to move
+		 * \param p_target The position to move it to
+		 * \param p_removedCount The number of triangles the collapse removes
+		 * \return True if the collapse can be applied. False otherwise
+		 */
+		bool isCollapseValid(uint32_t p_source, uint32_t p_target, size_t& p_removedCount);
+
+		/**
+		 * \brief Rewrites the index buffer with the collapses of the pass and removes degenerate triangles
+		 */
+		void applyCollapses();
+
+		/**
+		 * \brief Gives the position a position was moved to during the current pass
+		 * \param p_position The position to resolve
+		 * \return The position's current representative
+		 */
+		uint32_t resolve(uint32_t p_position) const;
+
+		std::vector<Vertex>			m_vertices;
+		std::vector<uint32_t>		m_indices;
+		std::vector<float>			m_positions;			// Normalized to the unit cube, 3 floats per vertex
+		std::vector<uint32_t>		m_positionIds;			// First vertex sharing each vertex's position
+		std::vector<uint32_t>		m_adjacencyOffsets;		// Per position, into m_adjacency
+		std::vector<uint32_t>		m_adjacency;			// Triangles around each position
+		std::vector<uint8_t>		m_edgeFlags;			// Per triangle corner
+		std::vector<EVertexKind>	m_kinds;				// Per position
+		std::vector<Quadric>		m_quadrics;				// Per position
+		std::vector<Collapse>		m_collapses;
+		std::vector<uint32_t>		m_vertexRemap;
+		std::vector<uint32_t>		m_positionRemap;
+		std::vector<uint8_t>		m_isLocked;
+		std::vector<uint32_t>		m_sourceNeighbours;
+		std::vector<uint32_t>		m_targetNeighbours;
+		float						m_error = 0.f;
+		bool						m_isAdjacencyValid = false;
+	};
+}
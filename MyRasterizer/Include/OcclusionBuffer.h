@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "BoundingVolume.h"
+#include "Matrix/Matrix4.h"
+
+namespace My
+{
+	class Mesh;
+
+	class OcclusionBuffer
+	{
+		using Mat4 = LibMath::Matrix4;
+
+	public:
+		static constexpr uint32_t DEFAULT_WIDTH = 256;
+		static constexpr uint32_t DEFAULT_HEIGHT = 128;
+
+		/**
+		 * \brief Creates a low resolution occlusion depth buffer
+		 * \param p_width The width of the buffer (must be a multiple of 4)
+		 * \param p_height The height of the buffer
+		 */
+		explicit OcclusionBuffer(uint32_t p_width = DEFAULT_WIDTH, uint32_t p_height = DEFAULT_HEIGHT);
+
+		/**
+		 * \brief Gives read access to the buffer's width
+		 * \return The number of columns of the buffer
+		 */
+		uint32_t getWidth() const;
+
+		/**
+		 * \brief Gives read access to the buffer's height
+		 * \return The number of rows of the buffer
+		 */
+		uint32_t getHeight() const;
+
+		/**
+		 * \brief Removes every occluder from the buffer and sets the view used by the next draws and tests
+		 * \param p_viewProjection The matrix used to transform points from world space to clip space
+		 */
+		void clear(const Mat4& p_viewProjection);
+
+		/**
+		 * \brief Writes the pixels fully covered by the given mesh's triangles to the buffer.
+		 * Each triangle uses its furthest vertex's depth so the buffer never hides more than the mesh does
+		 * \param p_mesh The occluder's mesh
+		 * \param p_transform The occluder's world transform
+		 */
+		void rasterizeOccluder(const Mesh& p_mesh, const Mat4& p_transform);
+
+		/**
+		 * \brief Checks whether any part of the given box's screen rectangle is in front of the occluders
+		 * \param p_bounds The world space box to test
+		 * \return False if the box is fully hidden by the occluders. True otherwise
+		 */
+		bool isVisible(const AABB& p_bounds) const;
+
+	private:
+		struct ScreenVertex
+		{
+			float	m_x;
+			float	m_y;
+			float	m_depth;
+		};
+
+		/**
+		 * \brief Transforms the given point to buffer coordinates
+		 * \param p_matrix The row major model view projection matrix
+		 * \param p_x The point's x coordinate
+		 * \param p_y The point's y coordinate
+		 * \param p_z The point's z coordinate
+		 * \param p_vertex The buffer coordinates and view depth of the point
+		 * \return False if the point is in front of the near plane. True otherwise
+		 */
+		bool project(const float p_matrix[16], float p_x, float p_y, float p_z, ScreenVertex& p_vertex) const;
+
+		/**
+		 * \brief Writes the given depth to the pixels fully covered by the triangle, four pixels at a time
+		 * \param p_a The triangle's first vertex
+		 * \param p_b The triangle's second vertex
+		 * \param p_c The triangle's third vertex
+		 */
+		void rasterizeTriangle(const ScreenVertex& p_a, const ScreenVertex& p_b, const ScreenVertex& p_c);
+
+		std::vector<float>	m_depths;
+		float				m_viewProjection[16] = {};
+		uint32_t			m_width;
+		uint32_t			m_height;
+	};
+}
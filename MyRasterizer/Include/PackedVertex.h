@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+
+#include "BoundingVolume.h"
+#include "Color.h"
+#include "Vertex.h"
+#include "Vector/Vector3.h"
+
+namespace My
+{
+	struct PackedVertex
+	{
+		uint16_t	m_position[3];	// Fixed point inside the mesh's bounding box
+		int8_t		m_normal[2];	// Octahedral encoding
+		Color		m_color;
+		uint16_t	m_uv[2];		// Half floats
+	};
+
+	static_assert(sizeof(PackedVertex) == 16, "Packed vertices should take 16 bytes");
+
+	class VertexQuantization
+	{
+	public:
+		VertexQuantization() = default;
+
+		/**
+		 * \brief Creates the quantization mapping the given box to the full range of the packed positions
+		 * \param p_bounds The bounding box of the vertices to pack
+		 */
+		explicit VertexQuantization(const AABB& p_bounds);
+
+		/**
+		 * \brief Compresses the given vertex
+		 * \param p_vertex The vertex to pack (must be inside the quantization's box)
+		 * \return The packed vertex
+		 */
+		PackedVertex encode(const Vertex& p_vertex) const;
+
+		/**
+		 * \brief Decompresses the given vertex
+		 * \param p_vertex The vertex to unpack
+		 * \return The vertex with full precision attributes
+		 */
+		Vertex decode(const PackedVertex& p_vertex) const;
+
+		/**
+		 * \brief Decompresses the given vertex's position only
+		 * \param p_vertex The vertex whose position should be unpacked
+		 * \return The vertex's position
+		 */
+		LibMath::Vector3 decodePosition(const PackedVertex& p_vertex) const;
+
+		/**
+		 * \brief Converts a float to the closest half precision float
+		 * \param p_value The value to convert
+		 * \return The bits of the half float
+		 */
+		static uint16_t floatToHalf(float p_value);
+
+		/**
+		 * \brief Converts a half precision float to a float
+		 * \param p_half The bits of the half float
+		 * \return The value of the half float
+		 */
+		static float halfToFloat(uint16_t p_half);
+
+	private:
+		float	m_offset[3] = { 0.f, 0.f, 0.f };
+		float	m_scale[3] = { 0.f, 0.f, 0.f };
+	};
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "PixelFormat.h"
+#include "Texture.h"
+
+namespace My
+{
+	/**
+	 * \brief A row-major buffer of pixels stored in the given format, for the targets which don't need
+	 * a full texture, such as masks, depth buffers or low precision previews
+	 * \tparam TFormat The pixel format, such as FormatR8 or FormatD32F
+	 */
+	template <typename TFormat>
+	class PixelBuffer
+	{
+	public:
+		typedef TFormat						Format;
+		typedef typename TFormat::Storage	Storage;
+
+		PixelBuffer() = default;
+
+		/**
+		 * \brief Creates a buffer of the given size whose pixels are zeroed
+		 * \param p_width The width of the buffer
+		 * \param p_height The height of the buffer
+		 */
+		PixelBuffer(const uint32_t p_width, const uint32_t p_height) :
+			m_width(p_width), m_height(p_height), m_pixels(static_cast<size_t>(p_width) * p_height, Storage {})
+		{
+		}
+
+		/**
+		 * \brief Converts the first level of the given texture to the buffer's format
+		 * \param p_texture The texture to convert, which can't be a virtual texture view
+		 */
+		explicit PixelBuffer(const Texture& p_texture) :
+			PixelBuffer(p_texture.getWidth(), p_texture.getHeight())
+		{
+			static_assert(!TFormat::IS_DEPTH, "Textures hold colors, not depths");
+
+			for (uint32_t y = 0; y < m_height; y++)
+			{
+				for (uint32_t x = 0; x < m_width; x++)
+					m_pixels[static_cast<size_t>(y) * m_width + x] = TFormat::fromColor(p_texture.getPixelColor(x, y));
+			}
+		}
+
+		uint32_t getWidth() const { return m_width; }
+		uint32_t getHeight() const { return m_height; }
+
+		/**
+		 * \brief Resizes the buffer then sets all of its pixels to the given value
+		 * \param p_width The new width of the buffer
+		 * \param p_height The new height of the buffer
+		 * \param p_value The stored value of every pixel
+		 */
+		void reset(const uint32_t p_width, const uint32_t p_height, const Storage& p_value)
+		{
+			m_width = p_width;
+			m_height = p_height;
+			m_pixels.assign(static_cast<size_t>(p_width) * p_height, p_value);
+		}
+
+		/**
+		 * \brief Gives the color of the given pixel, converted from the buffer's format
+		 */
+		Color getColor(const uint32_t p_x, const uint32_t p_y) const
+		{
+			static_assert(!TFormat::IS_DEPTH, "Depth buffers hold depths, not colors");
+			return TFormat::toColor(m_pixels[getIndex(p_x, p_y)]);
+		}
+
+		/**
+		 * \brief Converts the given color to the buffer's format and stores it in the given pixel
+		 */
+		void setColor(const uint32_t p_x, const uint32_t p_y, const Color& p_color)
+		{
+			static_assert(!TFormat::IS_DEPTH, "Depth buffers hold depths, not colors");
+			m_pixels[getIndex(p_x, p_y)] = TFormat::fromColor(p_color);
+		}
+
+		/**
+		 * \brief Gives the depth of the given pixel, converted from the buffer's format
+		 */
+		float getDepth(const uint32_t p_x, const uint32_t p_y) const
+		{
+			static_assert(TFormat::IS_DEPTH, "Color buffers hold colors, not depths");
+			return TFormat::toDepth(m_pixels[getIndex(p_x, p_y)]);
+		}
+
+		/**
+		 * \brief Converts the given depth to the buffer's format and stores it in the given pixel
+		 */
+		void setDepth(const uint32_t p_x, const uint32_t p_y, const float p_depth)
+		{
+			static_assert(TFormat::IS_DEPTH, "Color buffers hold colors, not depths");
+			m_pixels[getIndex(p_x, p_y)] = TFormat::fromDepth(p_depth);
+		}
+
+		/**
+		 * \brief Gives direct access to the stored pixels, in row-major order
+		 * \return A pointer to the first pixel (nullptr if the buffer is empty)
+		 */
+		Storage* getData() { return m_pixels.empty() ? nullptr : m_pixels.data(); }
+		const Storage* getData() const { return m_pixels.empty() ? nullptr : m_pixels.data(); }
+
+		/**
+		 * \brief Gives the memory used by the pixels
+		 * \return The number of bytes of the buffer
+		 */
+		size_t getMemorySize() const { return m_pixels.size() * sizeof(Storage); }
+
+	private:
+		size_t getIndex(const uint32_t p_x, const uint32_t p_y) const
+		{
+			if (p_x >= m_width || p_y >= m_height)
+				throw std::out_of_range("Pixel at coordinates " + std::to_string(p_x) +
+					", " + std::to_string(p_y) + " is not in the buffer");
+
+			return static_cast<size_t>(p_y) * m_width + p_x;
+		}
+
+		uint32_t				m_width = 0;
+		uint32_t				m_height = 0;
+		std::vector<Storage>	m_pixels;
+	};
+}
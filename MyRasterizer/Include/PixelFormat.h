@@ -0,0 +1,226 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#include "Color.h"
+
+namespace My
+{
+	/*
+	 * Pixel formats of the pixel buffers. Each format gives its storage type and converts it from and to
+	 * colors, or from and to depths for the depth formats, so every conversion is resolved at compile time.
+	 * Color formats missing channels read them as 0, and alpha as opaque
+	 */
+
+	namespace PixelFormatDetail
+	{
+		inline uint8_t toUnorm8(const float p_value)
+		{
+			const float clamped = p_value < 0.f ? 0.f : p_value > 1.f ? 1.f : p_value;
+			return static_cast<uint8_t>(clamped * 255.f + .5f);
+		}
+
+		/**
+		 * \brief Converts the given float to a half precision float, rounding to nearest
+		 */
+		inline uint16_t toHalf(const float p_value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &p_value, sizeof(bits));
+
+			const uint16_t sign = static_cast<uint16_t>(bits >> 16 & 0x8000);
+			const int32_t exponent = static_cast<int32_t>(bits >> 23 & 0xff) - 127 + 15;
+			uint32_t mantissa = bits & 0x7fffff;
+
+			// Infinity and NaN keep a non zero mantissa for NaN
+			if ((bits & 0x7f800000) == 0x7f800000)
+				return static_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+
+			if (exponent >= 31)
+				return static_cast<uint16_t>(sign | 0x7c00);
+
+			// Subnormal halves keep the implicit bit in their mantissa
+			if (exponent <= 0)
+			{
+				if (exponent < -10)
+					return sign;
+
+				mantissa |= 0x800000;
+				const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+				return static_cast<uint16_t>(sign | (mantissa + (1u << (shift - 1))) >> shift);
+			}
+
+			// A carry out of the mantissa correctly bumps the exponent
+			return static_cast<uint16_t>(sign | ((static_cast<uint32_t>(exponent) << 10 | mantissa >> 13)
+				+ (mantissa >> 12 & 1)));
+		}
+
+		inline float fromHalf(const uint16_t p_value)
+		{
+			const uint32_t sign = static_cast<uint32_t>(p_value & 0x8000) << 16;
+			const uint32_t exponent = p_value >> 10 & 0x1f;
+			const uint32_t mantissa = p_value & 0x3ff;
+
+			if (exponent == 0)
+			{
+				const float value = static_cast<float>(mantissa) * (1.f / 16777216.f);
+				return sign != 0 ? -value : value;
+			}
+
+			const uint32_t bits = exponent == 31 ? sign | 0x7f800000 | mantissa << 13
+				: sign | (exponent + 127 - 15) << 23 | mantissa << 13;
+
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+
+			return value;
+		}
+	}
+
+	struct FormatR8
+	{
+		typedef uint8_t Storage;
+		static constexpr bool IS_DEPTH = false;
+
+		static Storage fromColor(const Color& p_color) { return p_color.m_r; }
+		static Color toColor(const Storage p_pixel) { return { p_pixel, 0, 0, UINT8_MAX }; }
+	};
+
+	struct FormatRG8
+	{
+		struct Storage
+		{
+			uint8_t	m_r;
+			uint8_t	m_g;
+		};
+
+		static constexpr bool IS_DEPTH = false;
+
+		static Storage fromColor(const Color& p_color) { return { p_color.m_r, p_color.m_g }; }
+		static Color toColor(const Storage p_pixel) { return { p_pixel.m_r, p_pixel.m_g, 0, UINT8_MAX }; }
+	};
+
+	struct FormatRGBA8
+	{
+		typedef Color Storage;
+		static constexpr bool IS_DEPTH = false;
+
+		static Storage fromColor(const Color& p_color) { return p_color; }
+		static Color toColor(const Storage p_pixel) { return p_pixel; }
+	};
+
+	struct FormatRGB565
+	{
+		typedef uint16_t Storage;
+		static constexpr bool IS_DEPTH = false;
+
+		static Storage fromColor(const Color& p_color)
+		{
+			return static_cast<uint16_t>(((p_color.m_r * 31 + 127) / 255) << 11 | ((p_color.m_g * 63 + 127) / 255) << 5
+				| (p_color.m_b * 31 + 127) / 255);
+		}
+
+		static Color toColor(const Storage p_pixel)
+		{
+			// The high bits are repeated in the low ones so the extremes stay exact
+			const uint8_t r = static_cast<uint8_t>(p_pixel >> 11 & 31);
+			const uint8_t g = static_cast<uint8_t>(p_pixel >> 5 & 63);
+			const uint8_t b = static_cast<uint8_t>(p_pixel & 31);
+
+			return { static_cast<uint8_t>(r << 3 | r >> 2), static_cast<uint8_t>(g << 2 | g >> 4),
+				static_cast<uint8_t>(b << 3 | b >> 2), UINT8_MAX };
+		}
+	};
+
+	struct FormatRGBA16F
+	{
+		struct Storage
+		{
+			uint16_t	m_r;
+			uint16_t	m_g;
+			uint16_t	m_b;
+			uint16_t	m_a;
+		};
+
+		static constexpr bool IS_DEPTH = false;
+
+		static Storage fromColor(const Color& p_color)
+		{
+			constexpr float toFloat = 1.f / 255.f;
+
+			return { PixelFormatDetail::toHalf(p_color.m_r * toFloat), PixelFormatDetail::toHalf(p_color.m_g * toFloat),
+				PixelFormatDetail::toHalf(p_color.m_b * toFloat), PixelFormatDetail::toHalf(p_color.m_a * toFloat) };
+		}
+
+		static Color toColor(const Storage p_pixel)
+		{
+			return { PixelFormatDetail::toUnorm8(PixelFormatDetail::fromHalf(p_pixel.m_r)),
+				PixelFormatDetail::toUnorm8(PixelFormatDetail::fromHalf(p_pixel.m_g)),
+				PixelFormatDetail::toUnorm8(PixelFormatDetail::fromHalf(p_pixel.m_b)),
+				PixelFormatDetail::toUnorm8(PixelFormatDetail::fromHalf(p_pixel.m_a)) };
+		}
+	};
+
+	struct FormatRGBA32F
+	{
+		struct Storage
+		{
+			float	m_r;
+			float	m_g;
+			float	m_b;
+			float	m_a;
+		};
+
+		static constexpr bool IS_DEPTH = false;
+
+		static Storage fromColor(const Color& p_color)
+		{
+			constexpr float toFloat = 1.f / 255.f;
+			return { p_color.m_r * toFloat, p_color.m_g * toFloat, p_color.m_b * toFloat, p_color.m_a * toFloat };
+		}
+
+		static Color toColor(const Storage p_pixel)
+		{
+			return { PixelFormatDetail::toUnorm8(p_pixel.m_r), PixelFormatDetail::toUnorm8(p_pixel.m_g),
+				PixelFormatDetail::toUnorm8(p_pixel.m_b), PixelFormatDetail::toUnorm8(p_pixel.m_a) };
+		}
+	};
+
+	struct FormatR32F
+	{
+		typedef float Storage;
+		static constexpr bool IS_DEPTH = false;
+
+		static Storage fromColor(const Color& p_color) { return static_cast<float>(p_color.m_r) / 255.f; }
+		static Color toColor(const Storage p_pixel) { return { PixelFormatDetail::toUnorm8(p_pixel), 0, 0, UINT8_MAX }; }
+	};
+
+	// Normalized device depths in [-1, 1] mapped to 16 bits, anything farther being stored as the far plane
+	struct FormatD16
+	{
+		typedef uint16_t Storage;
+		static constexpr bool IS_DEPTH = true;
+
+		static Storage fromDepth(const float p_depth)
+		{
+			const float normalized = (p_depth < -1.f ? -1.f : p_depth > 1.f ? 1.f : p_depth) * .5f + .5f;
+			return static_cast<uint16_t>(normalized * 65535.f + .5f);
+		}
+
+		static float toDepth(const Storage p_pixel) { return static_cast<float>(p_pixel) / 65535.f * 2.f - 1.f; }
+	};
+
+	struct FormatD32F
+	{
+		typedef float Storage;
+		static constexpr bool IS_DEPTH = true;
+
+		static Storage fromDepth(const float p_depth) { return p_depth; }
+		static float toDepth(const Storage p_pixel) { return p_pixel; }
+	};
+
+	static_assert(sizeof(FormatRG8::Storage) == 2, "RG8 pixels should take 2 bytes");
+	static_assert(sizeof(FormatRGBA8::Storage) == 4, "RGBA8 pixels should take 4 bytes");
+	static_assert(sizeof(FormatRGBA16F::Storage) == 8, "RGBA16F pixels should take 8 bytes");
+	static_assert(sizeof(FormatRGBA32F::Storage) == 16, "RGBA32F pixels should take 16 bytes");
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+
+namespace My
+{
+	struct Color;
+	class Texture;
+	class ThreadPool;
+
+	class PostProcess
+	{
+	public:
+		/**
+		 * \brief Smooths the aliased edges of the given texture using
+		 * an FXAA-style edge detection and blending pass at native resolution
+		 * \param p_target The texture to anti-alias (modified in place). It must be uncompressed and use the linear layout
+		 * \param p_threadPool The thread pool on which the rows are processed
+		 */
+		static void applyFxaa(Texture& p_target, ThreadPool& p_threadPool);
+
+	private:
+		/**
+		 * \brief Computes the perceived luminance of each pixel of the source,
+		 * four pixels at a time
+		 * \param p_source The texture whose luminance should be computed
+		 * \param p_luma The buffer in which the luminance is written
+		 * \param p_firstRow The first row to process
+		 * \param p_lastRow The row after the last one to process
+		 */
+		static void computeLuma(const Texture& p_source, std::vector<float>& p_luma,
+			size_t p_firstRow, size_t p_lastRow);
+
+		/**
+		 * \brief Runs the edge detection and blending on the given rows
+		 * \param p_source A copy of the pixels of the texture before anti-aliasing
+		 * \param p_luma The luminance of each pixel of the source
+		 * \param p_target The texture in which the result is written
+		 * \param p_firstRow The first row to process
+		 * \param p_lastRow The row after the last one to process
+		 */
+		static void fxaaRows(const std::vector<Color>& p_source, const std::vector<float>& p_luma,
+			Texture& p_target, size_t p_firstRow, size_t p_lastRow);
+	};
+}
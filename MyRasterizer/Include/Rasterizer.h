@@ -2,8 +2,14 @@
 #include <vector>
 #include <functional>
 
+#include "Color.h"
 #include "Entity.h"
 #include "Light.h"
+#include "OcclusionBuffer.h"
+#include "PackedVertex.h"
+#include "PixelBuffer.h"
+#include "Vertex.h"
+#include "Vector/Vector2.h"
 #include "Vector/Vector3.h"
 #include "Vector/Vector4.h"
 #include "Matrix/Matrix4.h"
@@ -38,9 +44,11 @@ namespace My
 	}
 
 	class Camera;
-	struct Vertex;
+	class Frustum;
+	class Mesh;
 	class Texture;
 	class Scene;
+	class VertexStreams;
 
 	class Rasterizer
 	{
@@ -50,6 +58,47 @@ namespace My
 			E_WIRE_FRAME
 		};
 
+		struct InstanceBatch
+		{
+			const Mesh*			m_mesh = nullptr;
+			std::vector<float>	m_transforms[12];	// Top 3 rows of each model matrix, one array per element
+			std::vector<float>	m_rotations[9];		// Each 3x3 normal rotation, one array per element
+			std::vector<float>	m_transparencies;
+
+			/**
+			 * \brief Gives the number of instances in the batch
+			 * \return The number of entities added to the batch
+			 */
+			size_t getInstanceCount() const;
+
+			/**
+			 * \brief Appends the given entity's transform and transparency to the batch
+			 * \param p_entity The entity to add (must use the batch's mesh)
+			 */
+			void addInstance(const Entity& p_entity);
+
+			/**
+			 * \brief Removes every instance from the batch, keeping the allocated memory
+			 */
+			void clear();
+		};
+
+		struct LightBatch
+		{
+			std::vector<float>	m_positions[3];			// One array per element
+			std::vector<float>	m_ambients;
+			std::vector<float>	m_diffuseIntensities[3];	// Diffuse component times each channel's intensity
+			std::vector<float>	m_specularIntensities[3];	// Specular component times each channel's intensity
+
+			/**
+			 * \brief Gives the number of lights in the batch, including the black ones padding it to a multiple of 4
+			 * \return The length of each array
+			 */
+			size_t getLightCount() const;
+		};
+
+		using HdrColor = FormatRGBA32F::Storage;
+
 		using Vec3 = LibMath::Vector3;
 		using Vec4 = LibMath::Vector4;
 		using Mat4 = LibMath::Matrix4;
@@ -58,10 +107,27 @@ namespace My
 			Rasterizer& self)> DrawFunc;
 
 	public:
+		enum class EAntiAliasing
+		{
+			E_NONE,
+			E_FXAA
+		};
+
+		enum class EResolveFilter
+		{
+			E_BOX,
+			E_TENT
+		};
 
 		Rasterizer() = default;
 
-		explicit Rasterizer(uint8_t p_sampleCount);
+		/**
+		 * \brief Creates a multisampled rasterizer
+		 * \param p_sampleCount The number of samples per pixel on each axis
+		 * (i.e: 2 gives 2x2 = 4 samples per pixel)
+		 * \param p_antiAliasing The post-process anti-aliasing applied to the resolved image
+		 */
+		explicit Rasterizer(uint8_t p_sampleCount, EAntiAliasing p_antiAliasing = EAntiAliasing::E_NONE);
 
 		/**
 		 * \brief Creates a move copy of the given rasterizer
@@ -100,21 +166,292 @@ namespace My
 
 		void toggleWireFrameMode();
 
+		/**
+		 * \brief Gives read access to the post-process anti-aliasing mode
+		 * \return The anti-aliasing pass applied to the resolved image
+		 */
+		EAntiAliasing getAntiAliasing() const;
+
+		/**
+		 * \brief Sets the post-process anti-aliasing mode
+		 * \param p_antiAliasing The anti-aliasing pass to apply to the resolved image
+		 */
+		void setAntiAliasing(EAntiAliasing p_antiAliasing);
+
+		/**
+		 * \brief Gives read access to the filter used to resolve the samples
+		 * \return The filter used to resolve the samples into pixels
+		 */
+		EResolveFilter getResolveFilter() const;
+
+		/**
+		 * \brief Sets the filter used to resolve the samples into pixels
+		 * \param p_filter The box filter averages each pixel's own samples
+		 * while the tent filter also weighs in the neighbouring pixels' samples
+		 */
+		void setResolveFilter(EResolveFilter p_filter);
+
+		/**
+		 * \brief Checks whether the entities hidden behind occluder meshes are skipped
+		 * \return True if occlusion culling is enabled. False otherwise
+		 */
+		bool isOcclusionCullingEnabled() const;
+
+		/**
+		 * \brief Sets whether the entities hidden behind occluder meshes should be skipped. Occlusion culling
+		 * only applies in fill mode since wireframe occluders let the entities behind them show through
+		 * \param p_isEnabled Whether occlusion culling should be enabled
+		 */
+		void setOcclusionCulling(bool p_isEnabled);
+
+		/**
+		 * \brief Forgets the levels of detail picked for the entities in the previous frames.
+		 * Must be called when the rendered scene is replaced, since the levels are kept per entity index
+		 */
+		void resetLodState();
+
+		/**
+		 * \brief Checks whether the frames are shaded in a linear floating point buffer then tone mapped
+		 * \return True if the frames are rendered in high dynamic range. False otherwise
+		 */
+		bool isHdrEnabled() const;
+
+		/**
+		 * \brief Sets whether the frames should be shaded in a linear floating point buffer. The lights' contributions
+		 * are then summed up without clamping and the resolve tone maps and sRGB encodes the result once per pixel
+		 * \param p_isEnabled Whether the next frames should be rendered in high dynamic range
+		 */
+		void setHdr(bool p_isEnabled);
+
+		/**
+		 * \brief Gives read access to the exposure of the high dynamic range frames
+		 * \return The factor the linear colors are scaled by before being tone mapped
+		 */
+		float getExposure() const;
+
+		/**
+		 * \brief Sets the exposure of the high dynamic range frames
+		 * \param p_exposure The factor the linear colors are scaled by before being tone mapped (must be positive)
+		 */
+		void setExposure(float p_exposure);
+
+		/**
+		 * \brief Resolves the samples of the last rendered frame again, with the current filter, straight into
+		 * the given buffer's format. The post-process anti-aliasing is only applied to texture targets
+		 * \tparam TFormat A color format, instantiated for every format of PixelFormat.h
+		 * \param p_target The buffer receiving the pixels, resized to the last frame's size
+		 */
+		template <typename TFormat>
+		void resolve(PixelBuffer<TFormat>& p_target) const;
+
+		/**
+		 * \brief Gives each pixel of the last rendered frame the nearest depth of its samples
+		 * \tparam TFormat A depth format, instantiated for every format of PixelFormat.h
+		 * \param p_target The buffer receiving the depths, resized to the last frame's size.
+		 * The pixels nothing was drawn on are at the far plane
+		 */
+		template <typename TFormat>
+		void resolveDepth(PixelBuffer<TFormat>& p_target) const;
 
 	private:
-		std::vector<float>			m_zBuffer;
+		static constexpr uint8_t	MAX_SAMPLE_COUNT = 8;
+		static constexpr uint8_t	UNKNOWN_LOD = UINT8_MAX;
+
+		// Fraction of a level's threshold the screen size must move past before switching level
+		static constexpr float		LOD_HYSTERESIS = .15f;
+
+		PixelBuffer<FormatD32F>		m_zBuffer;
+		std::vector<Color>			m_sampleBuffer;
+		PixelBuffer<FormatRGBA32F>	m_hdrSampleBuffer;
+		LightBatch					m_lightBatch;
+		uint32_t					m_frameWidth = 0;
+		uint32_t					m_frameHeight = 0;
+		std::vector<LibMath::Vector2>	m_sampleOffsets;
+		std::vector<uint16_t>		m_tentWeights;	// 8 bit weights, widened to match the 16 bit lanes
+		uint32_t					m_tentWeightSum = 0;
 		const std::vector<Light>*	m_lights = nullptr;
 		const Camera*				m_camera = nullptr;
 		Texture*					m_target = nullptr;
 		uint8_t						m_sampleCount = 1;
 		EDrawMode					m_drawMode = EDrawMode::E_FILL;
+		EAntiAliasing				m_antiAliasing = EAntiAliasing::E_NONE;
+		EResolveFilter				m_resolveFilter = EResolveFilter::E_BOX;
 		DrawFunc					m_drawTriangle = &Rasterizer::drawTriangleFill;
+		OcclusionBuffer				m_occlusionBuffer;
+		std::vector<InstanceBatch>	m_opaqueBatches;
+		std::vector<InstanceBatch>	m_transparentBatches;
+		size_t						m_opaqueBatchCount = 0;
+		size_t						m_transparentBatchCount = 0;
+		std::vector<Vertex>			m_instanceVertices;
+		std::vector<Vec3>			m_instancePixels;
+		std::vector<Vec3>			m_instanceNormals;
+		float						m_viewProjection[16] = {};
+		Vec3						m_viewPosition;
+		Vec3						m_viewDirection;
+		float						m_projectionScale = 0.f;
+		std::vector<uint8_t>		m_entityLods;
+		bool						m_isOcclusionCullingEnabled = true;
+		bool						m_isHdrEnabled = false;
+		bool						m_isHdrFrame = false;	// Whether the last frame's samples are in the HDR buffer
+		float						m_exposure = 1.f;
+
+		/**
+		 * \brief Returns the number of samples stored for each pixel
+		 * \return The number of samples per pixel
+		 */
+		size_t getSamplesPerPixel() const;
+
+		/**
+		 * \brief Fills the sample offsets table with an ordered grid
+		 * of m_sampleCount x m_sampleCount positions inside a pixel
+		 * and computes the matching tent filter weights
+		 */
+		void updateSampleOffsets();
+
+		/**
+		 * \brief Writes a shaded color to the covered samples of a pixel
+		 * \param p_pixelIndex The index of the pixel in the target
+		 * \param p_coverageMask The mask of the samples to write to
+		 * \param p_color The color to write (blended if not opaque)
+		 * \param p_depths The depth of each sample of the pixel
+		 */
+		void writeSamples(size_t p_pixelIndex, uint64_t p_coverageMask,
+			const Color& p_color, const float* p_depths);
+
+		/**
+		 * \brief Writes a shaded linear color to the covered samples of a pixel of the HDR buffer
+		 * \param p_pixelIndex The index of the pixel in the target
+		 * \param p_coverageMask The mask of the samples to write to
+		 * \param p_color The color to write (blended if not opaque)
+		 * \param p_depths The depth of each sample of the pixel
+		 */
+		void writeHdrSamples(size_t p_pixelIndex, uint64_t p_coverageMask,
+			const HdrColor& p_color, const float* p_depths);
+
+		/**
+		 * \brief Fills the light batch with the given lights' positions and components
+		 * \param p_lights The scene's lights
+		 */
+		void batchLights(const std::vector<Light>& p_lights);
+
+		/**
+		 * \brief Filters the samples into the given texture's pixels, splitting the rows across threads
+		 * \param p_target The texture on which the samples should be resolved
+		 */
+		void resolve(Texture& p_target) const;
+
+		/**
+		 * \brief Resolves the given rows of the last frame with the kernel matching its buffer and the current filter
+		 * \param p_rows The pixels of the first row to resolve, followed by the next rows
+		 * \param p_firstRow The first row to resolve
+		 * \param p_lastRow The row after the last one to resolve
+		 */
+		void resolveRows(Color* p_rows, size_t p_firstRow, size_t p_lastRow) const;
+
+		/**
+		 * \brief Averages each pixel's own samples into the given rows of the target
+		 * \param p_rows The pixels of the first row to resolve, followed by the next rows
+		 * \param p_firstRow The first row to resolve
+		 * \param p_lastRow The row after the last one to resolve
+		 */
+		void resolveBoxRows(Color* p_rows, size_t p_firstRow, size_t p_lastRow) const;
+
+		/**
+		 * \brief Weighs the samples of each pixel and its 8 neighbours with a
+		 * one pixel radius tent into the given rows of the target
+		 * \param p_rows The pixels of the first row to resolve, followed by the next rows
+		 * \param p_firstRow The first row to resolve
+		 * \param p_lastRow The row after the last one to resolve
+		 */
+		void resolveTentRows(Color* p_rows, size_t p_firstRow, size_t p_lastRow) const;
+
+		/**
+		 * \brief Filters the linear samples of the HDR buffer with the current filter, then exposes, tone maps
+		 * and sRGB encodes them into the given rows of the target
+		 * \param p_rows The pixels of the first row to resolve, followed by the next rows
+		 * \param p_firstRow The first row to resolve
+		 * \param p_lastRow The row after the last one to resolve
+		 */
+		void resolveHdrRows(Color* p_rows, size_t p_firstRow, size_t p_lastRow) const;
 
 		/**
-		 * \brief Draws the received entity on the target texture
+		 * \brief Draws the opaque occluders' meshes in the occlusion buffer, then replaces the
+		 * given entities by the occluders and the entities whose bounds are still visible
+		 * \param p_scene The scene containing the entities
+		 * \param p_frustum The camera's frustum
+		 * \param p_entityIndices The indices of the entities inside the frustum
+		 */
+		void cullOccludedEntities(const Scene& p_scene, const Frustum& p_frustum,
+			std::vector<size_t>& p_entityIndices);
+
+		/**
+		 * \brief Groups the given entities into instance batches. Opaque entities sharing a mesh level
+		 * end up in the same batch while transparent ones are only grouped with consecutive
+		 * entities sharing their mesh to keep their blending order
+		 * \param p_entities The scene's entities
+		 * \param p_entityIndices The sorted indices of the entities to draw
+		 */
+		void batchEntities(const std::vector<Entity>& p_entities, const std::vector<size_t>& p_entityIndices);
+
+		/**
+		 * \brief Picks the level of detail matching the entity's projected size. The entity keeps
+		 * its previous frame's level until its size moves far enough past that level's thresholds
 		 * \param p_entity The entity to draw
+		 * \param p_entityIndex The index of the entity in the scene
+		 * \return The level of the entity's mesh to draw
+		 */
+		size_t selectLod(const Entity& p_entity, size_t p_entityIndex);
+
+		/**
+		 * \brief Gives an empty batch for the given mesh, reusing the previous frames' buffers if possible
+		 * \param p_batches The batches to pick from
+		 * \param p_batchCount The number of batches in use (incremented)
+		 * \param p_mesh The mesh shared by the batch's instances
+		 * \return A reference to the cleared batch
+		 */
+		static InstanceBatch& acquireBatch(std::vector<InstanceBatch>& p_batches, size_t& p_batchCount,
+			const Mesh* p_mesh);
+
+		/**
+		 * \brief Draws every instance of the given batch on the target texture,
+		 * fetching the shared mesh data once
+		 * \param p_batch The instances to draw
 		 */
-		void drawEntity(const Entity& p_entity);
+		void drawInstances(const InstanceBatch& p_batch);
+
+		/**
+		 * \brief Transforms the given vertex streams to world space and pixel coordinates for one instance,
+		 * four vertices at a time
+		 * \param p_streams The mesh's vertex streams
+		 * \param p_transform The top 3 rows of the instance's model matrix
+		 * \param p_rotation The instance's normal rotation
+		 * \param p_transparency The instance's transparency
+		 */
+		void transformInstanceStreams(const VertexStreams& p_streams, const float p_transform[12],
+			const float p_rotation[9], float p_transparency);
+
+		/**
+		 * \brief Transforms the given vertices to world space and pixel coordinates for one instance
+		 * \param p_vertices The mesh's full precision or packed vertices
+		 * \param p_vertexCount The number of vertices
+		 * \param p_quantization The mapping used to decode the packed vertices
+		 * \param p_transform The top 3 rows of the instance's model matrix
+		 * \param p_rotation The instance's normal rotation
+		 * \param p_transparency The instance's transparency
+		 */
+		template <typename TVertex>
+		void transformInstanceVertices(const TVertex* p_vertices, size_t p_vertexCount,
+			const VertexQuantization& p_quantization, const float p_transform[12], const float p_rotation[9],
+			float p_transparency);
+
+		/**
+		 * \brief Draws the triangles of the instance whose vertices were just transformed
+		 * \param p_indices The mesh's indices, in their stored width
+		 * \param p_indexCount The number of indices
+		 * \param p_texture The mesh's texture
+		 */
+		template <typename TIndex>
+		void drawInstanceTriangles(const TIndex* p_indices, size_t p_indexCount, const Texture* p_texture);
 
 		/**
 		 * \brief Draws the entity's normals on the target texture
@@ -142,6 +479,31 @@ namespace My
 		static void drawTriangleWireFrame(const Vertex p_vertices[3], const Vec3 p_pixelTriangle[3], const Texture* p_texture,
 			Rasterizer& p_self);
 
+		/**
+		 * \brief Computes the color of a point of the given triangle
+		 * \param p_vertices The triangle to shade
+		 * \param p_stw The barycentric coordinates of the point to shade
+		 * \param p_texture The triangle's source texture
+		 * \param p_textureLod The mip level to sample the texture from
+		 * \param p_self A reference to the rasterizer calling this function
+		 * \return The textured and lit color of the point
+		 */
+		static Color shadePixel(const Vertex p_vertices[3], const LibMath::Vector3& p_stw,
+			const Texture* p_texture, float p_textureLod, const Rasterizer& p_self);
+
+		/**
+		 * \brief Computes the linear color of a point of the given triangle, lighting it with
+		 * four lights of the batch at a time without clamping
+		 * \param p_vertices The triangle to shade
+		 * \param p_stw The barycentric coordinates of the point to shade
+		 * \param p_texture The triangle's source texture
+		 * \param p_textureLod The mip level to sample the texture from
+		 * \param p_self A reference to the rasterizer calling this function
+		 * \return The textured and lit linear color of the point
+		 */
+		static HdrColor shadeHdrPixel(const Vertex p_vertices[3], const LibMath::Vector3& p_stw,
+			const Texture* p_texture, float p_textureLod, const Rasterizer& p_self);
+
 		/**
 		 * \brief Converts the given world point to pixel coordinates
 		 * \param p_pos The world position to convert
@@ -1,7 +1,9 @@
 #pragma once
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
+#include "BoundingVolumeHierarchy.h"
 #include "Light.h"
 
 namespace My
@@ -18,6 +20,7 @@ namespace My
 
 	class Mesh;
 	class Entity;
+	class Frustum;
 
 	//struct Orientation
 	//{
@@ -30,32 +33,93 @@ namespace My
 	{
 	public:
 		Scene() = default;
-		Scene(const Scene& p_other) = default;
-		Scene(Scene&& p_other) = default;
-		~Scene();
+		Scene(const Scene& p_other);
+		Scene(Scene&& p_other) noexcept;
+		~Scene() = default;
 
-		Scene&				operator=(const Scene& p_other) = default;
+		Scene&				operator=(const Scene& p_other);
 		Scene&				operator=(Scene&& p_other) noexcept;
 
+		/**
+		 * \brief Adds the given mesh to the scene, which takes ownership of it
+		 * \param p_name The name of the mesh, replacing any mesh of the same name
+		 * \param p_mesh The mesh to add, allocated with new
+		 * \return A pointer to the added mesh
+		 */
 		const Mesh*			addMesh(const std::string& p_name, Mesh& p_mesh);
+
+		/**
+		 * \brief Adds the given mesh to the scene, sharing it with its other owners such as other scenes
+		 * or an asset registry. The mesh lives until its last owner releases it
+		 * \param p_name The name of the mesh, replacing any mesh of the same name
+		 * \param p_mesh The mesh to share
+		 * \return A pointer to the added mesh
+		 */
+		const Mesh*			addMesh(const std::string& p_name, std::shared_ptr<const Mesh> p_mesh);
+
 		const Mesh*			getMesh(const std::string& p_name);
+		const std::map<std::string, std::shared_ptr<const Mesh>>&	getMeshes() const;
 
 		void				addEntity(const Entity& p_entity);
 		void				addLight(const Light& p_light);
 
-		std::vector<Entity>	getEntities() const;
-		std::vector<Entity>&	getEntities();
+		/**
+		 * \brief Gives read access to the entities. They are modified through getEntity and added through addEntity
+		 * so the scene's hierarchy stays in sync with them
+		 * \return The scene's entities
+		 */
+		const std::vector<Entity>&	getEntities() const;
 
 		Entity&				getEntity(size_t index);
 		std::vector<Light>	getLights() const;
 
+		/**
+		 * \brief Finds the entities whose world bounds are at least partially inside the given frustum
+		 * \param p_frustum The frustum to test the entities against
+		 * \param p_entityIndices The vector to which the visible entities' indices are appended
+		 */
+		void				cullEntities(const Frustum& p_frustum, std::vector<size_t>& p_entityIndices) const;
+
+		/**
+		 * \brief Finds the closest entity whose world bounding box is hit by the given ray
+		 * \param p_origin The ray's starting point
+		 * \param p_direction The ray's direction
+		 * \return A pointer to the hit entity or nullptr if nothing was hit
+		 */
+		Entity*				pickEntity(const LibMath::Vector3& p_origin, const LibMath::Vector3& p_direction);
+
+		/**
+		 * \brief Gives read access to the hierarchy over the entities' world bounds,
+		 * refitting it first if some entities moved
+		 * \return The scene's bounding volume hierarchy - items are entity indices
+		 */
+		const BoundingVolumeHierarchy&	getBoundingVolumeHierarchy() const;
+
 		//const Orientation GlobalOrientation = {	LibMath::Vector3::right(),
 		//										LibMath::Vector3::up(),
 		//										LibMath::Vector3::front() };
 
 	private:
-		std::map<std::string, Mesh*> m_meshes;
+		friend class Entity;
+
+		/**
+		 * \brief Queues the given entity's bounds for the next hierarchy refit
+		 * \param p_index The index of the moved entity
+		 */
+		void				onEntityTransformChanged(size_t p_index);
+
+		/**
+		 * \brief Makes each entity point back to this scene
+		 */
+		void				bindEntities();
+
+		std::map<std::string, std::shared_ptr<const Mesh>> m_meshes;
 		std::vector<Entity> m_entities;
 		std::vector<Light> m_lights;
+
+		// Updated lazily by the queries
+		mutable BoundingVolumeHierarchy	m_hierarchy;
+		mutable std::vector<size_t>		m_movedEntities;
+		mutable std::vector<uint8_t>	m_hasEntityMoved;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Scene.h"
+#include "Texture.h"
+
+namespace My
+{
+	class ScenePack
+	{
+	public:
+		/**
+		 * \brief Maps the given scene pack and builds its scene without parsing nor copying anything:
+		 * the meshes and textures refer to the mapped buffers until they are first modified.
+		 * Only the structure of the pack is validated - the indices are trusted to be in range
+		 * \param p_path The path of the pack to load
+		 */
+		explicit ScenePack(const std::string& p_path);
+
+		ScenePack(const ScenePack& p_other) = delete;
+
+		/**
+		 * \brief Takes over the mapping and the scene of the given pack
+		 * \param p_other The pack to move
+		 */
+		ScenePack(ScenePack&& p_other) = default;
+
+		/**
+		 * \brief Destroys the scene then unmaps the pack
+		 */
+		~ScenePack() = default;
+
+		ScenePack& operator=(const ScenePack& p_other) = delete;
+		ScenePack& operator=(ScenePack&& p_other) = delete;
+
+		/**
+		 * \brief Gives access to the loaded scene
+		 * \return The scene stored in the pack
+		 */
+		Scene& getScene();
+
+		/**
+		 * \brief Gives read access to the loaded scene
+		 * \return The scene stored in the pack
+		 */
+		const Scene& getScene() const;
+
+		/**
+		 * \brief Writes the given scene's meshes, levels of detail, textures, entities and lights in a pack.
+		 * Every buffer is stored in the layout used at runtime, 16 bytes aligned
+		 * \param p_path The path of the pack to write
+		 * \param p_scene The scene to save. Its entities must use the scene's meshes, whose textures can't be virtual
+		 */
+		static void save(const std::string& p_path, const Scene& p_scene);
+
+		// Bumped whenever the layout of the records changes
+		static constexpr uint32_t VERSION = 4;
+
+	private:
+		// Declared first to be unmapped after the scene and the textures referring to it
+		MappedFile								m_file;
+		std::vector<std::unique_ptr<Texture>>	m_textures;
+		Scene									m_scene;
+	};
+}
@@ -1,10 +1,21 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
-#include "Vector/Vector2.h"
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
 
 namespace My
 {
 	struct Color;
+	class VirtualTexture;
+
+	enum class ETextureLayout : uint8_t
+	{
+		E_LINEAR,	// Row-major pixels, as expected by render targets
+		E_TILED		// Row-major 4x4 tiles of row-major pixels, keeping neighboring texels in the same cache lines
+	};
 
 	class Texture
 	{
@@ -13,23 +24,311 @@ namespace My
 					Texture(uint32_t p_width, uint32_t p_height);
 					Texture(const Texture& p_other);
 					Texture(Texture&& p_other) noexcept;
-		explicit	Texture(const char* p_imagePath);
+
+		/**
+		 * \brief Loads the given PNG, JPEG, BMP or TGA image and builds its mip chain. Throws if the image can't be decoded
+		 * \param p_imagePath The path of the image to load
+		 * \param p_layout The layout in which the pixels are stored (tiled by default as loaded textures are sampled)
+		 */
+		explicit	Texture(const char* p_imagePath, ETextureLayout p_layout = ETextureLayout::E_TILED);
+
+		/**
+		 * \brief Wraps the given pixels, such as a mapped scene pack's, without copying them.
+		 * The pixels must outlive the texture. Copies of the texture own their pixels
+		 * \param p_width The width of the texture
+		 * \param p_height The height of the texture
+		 * \param p_pixels The texture's row-major pixels
+		 * \param p_mipPixels The texture's mip levels, laid out as by getMipPixels (nullptr for none)
+		 * \param p_layout The layout in which the pixels are stored
+		 */
+					Texture(uint32_t p_width, uint32_t p_height, Color* p_pixels, const Color* p_mipPixels = nullptr,
+						ETextureLayout p_layout = ETextureLayout::E_LINEAR);
+
+		/**
+		 * \brief Wraps the given compressed blocks, such as a mapped scene pack's, without copying them.
+		 * The blocks must outlive the texture. Copies of the texture own their blocks
+		 * \param p_width The width of the texture
+		 * \param p_height The height of the texture
+		 * \param p_compression The format of the blocks
+		 * \param p_blocks The blocks of every mip level, laid out as by getBlocks
+		 */
+					Texture(uint32_t p_width, uint32_t p_height, ETextureCompression p_compression, const uint8_t* p_blocks);
+
+		/**
+		 * \brief Creates a view sampling the given virtual texture, so meshes can use it as any other texture.
+		 * The view has no pixels of its own, so reading or modifying them throws, and the virtual texture must outlive it
+		 * \param p_virtualTexture The virtual texture to sample
+		 */
+		explicit	Texture(const VirtualTexture& p_virtualTexture);
 					~Texture();
 
 		Texture&	operator=(const Texture&);
 		Texture&	operator=(Texture&&) noexcept;
 
+		/**
+		 * \brief Decodes the given encoded image, such as the content of an image file, and builds its mip chain.
+		 * Safe to call from any thread. Throws if the image can't be decoded
+		 * \param p_data The encoded image
+		 * \param p_size The number of bytes of the encoded image
+		 * \param p_layout The layout in which the pixels should be stored
+		 * \param p_firstLevel The number of largest levels to skip, as dropMipLevels would. They are never allocated,
+		 * only the decoded image is held while it is reduced
+		 * \return The decoded texture
+		 */
+		static Texture	decode(const void* p_data, size_t p_size, ETextureLayout p_layout = ETextureLayout::E_TILED,
+							size_t p_firstLevel = 0);
+
 		uint32_t	getWidth() const;
 		uint32_t	getHeight() const;
 		Color		getPixelColor(uint32_t p_x, uint32_t p_y) const;
-		Color		getPixelColorBlerp(	float p_x, float p_y, 
-										LibMath::Vector2 p_deltaRatio) const;
 		void		setPixelColor(uint32_t p_x, uint32_t p_y, const Color& p_c);
+
+		/**
+		 * \brief Samples the texture with bilinear filtering between the two mip levels closest to the given
+		 * level of detail. The texture coordinates wrap, while the filter is clamped to the texture's edges
+		 * \param p_u The horizontal texture coordinate
+		 * \param p_v The vertical texture coordinate
+		 * \param p_lod The mip level to sample, as the base 2 logarithm of the number of texels per pixel
+		 * \return The filtered color of the texture at the given coordinates
+		 */
+		Color		sampleTrilinear(float p_u, float p_v, float p_lod) const;
+
+		/**
+		 * \brief Builds the texture's mip chain down to a single texel, each level averaging 2x2 texels of the
+		 * previous one. Must be called again after the pixels are modified for the smaller levels to follow
+		 */
+		void		generateMipmaps();
+
+		/**
+		 * \brief Frees the given number of the largest mip levels, the next one becoming the texture's first
+		 * level. Texture coordinates are normalized so the texture is still sampled the same way, only blurrier
+		 * \param p_levelCount The number of levels to free (must be lower than the number of levels)
+		 */
+		void		dropMipLevels(size_t p_levelCount);
+
+		/**
+		 * \brief Records that the texture was sampled at the given level of detail. Safe to call from any thread
+		 * \param p_lod The level of detail of a sampled triangle, as given to sampleTrilinear
+		 */
+		void		recordSampledLod(float p_lod) const;
+
+		/**
+		 * \brief Gives the finest mip level recorded since the last call then forgets the recorded levels
+		 * \param p_level Receives the finest sampled level (negative when the texture was magnified)
+		 * \return True if the texture was sampled since the last call. False otherwise
+		 */
+		bool		takeSampledLevel(int32_t& p_level);
+
+		/**
+		 * \brief Gives the virtual texture the texture is a view of
+		 * \return A pointer to the virtual texture (nullptr if the texture has its own pixels)
+		 */
+		const VirtualTexture*	getVirtualTexture() const;
+
+		/**
+		 * \brief Filters the given texels with the same fixed point weights as the textures' sampling
+		 * \param p_texels The top left, top right, bottom left and bottom right texels
+		 * \param p_fractionX The horizontal position between the left and right texels, in [0, 1]
+		 * \param p_fractionY The vertical position between the top and bottom texels, in [0, 1]
+		 * \return The filtered color
+		 */
+		static Color	filterBilinear(const Color p_texels[4], float p_fractionX, float p_fractionY);
+
+		/**
+		 * \brief Blends the given colors with the same fixed point weights as the textures' sampling
+		 * \param p_a The color at 0
+		 * \param p_b The color at 1
+		 * \param p_fraction The position between the colors, in [0, 1]
+		 * \return The blended color
+		 */
+		static Color	filterLinear(const Color& p_a, const Color& p_b, float p_fraction);
+
+		/**
+		 * \brief Gives the memory used by the texture's pixels, mip chain and blocks
+		 * \return The number of bytes of the texture's buffers
+		 */
+		size_t		getMemorySize() const;
+
+		/**
+		 * \brief Gives the number of mip levels of the texture
+		 * \return The number of levels, including the texture itself
+		 */
+		size_t		getMipLevelCount() const;
+
+		/**
+		 * \brief Gives read access to the texture's mip levels after the first one, stored from the largest
+		 * to the smallest with each level's pixels in row-major order
+		 * \return A pointer to the first pixel of the second level (nullptr if the texture has no mip chain)
+		 */
+		const Color*	getMipPixels() const;
+
+		/**
+		 * \brief Gives the number of pixels of the mip levels after the first one
+		 * \return The number of pixels pointed to by getMipPixels
+		 */
+		size_t		getMipPixelCount() const;
+
+		/**
+		 * \brief Gives the layout in which the texture's pixels are stored
+		 * \return The layout of the pixel buffer and of the mip levels
+		 */
+		ETextureLayout	getLayout() const;
+
+		/**
+		 * \brief Stores the texture's pixels in the given layout, rebuilding its mip chain if it has one.
+		 * Textures wrapping external pixels get their own copy
+		 * \param p_layout The new layout of the pixels
+		 */
+		void			setLayout(ETextureLayout p_layout);
+
+		/**
+		 * \brief Gives the size of the texture's pixel buffer
+		 * \return The number of pixels of the buffer, including the padding of the tiled layout
+		 */
+		size_t			getPixelBufferSize() const;
+
+		/**
+		 * \brief Gives the block format in which the texture is stored
+		 * \return The texture's compression (E_NONE for uncompressed textures)
+		 */
+		ETextureCompression	getCompression() const;
+
+		/**
+		 * \brief Encodes the texture and its mip chain, which is built first if needed, in blocks of the given format
+		 * then frees the pixels. Compressed textures are decoded block by block when sampled and are read-only
+		 * \param p_compression The block format to use
+		 */
+		void			compress(ETextureCompression p_compression);
+
+		/**
+		 * \brief Gives read access to the compressed blocks of every mip level, from the largest to the smallest,
+		 * each level's blocks being in row-major order
+		 * \return A pointer to the first block (nullptr if the texture isn't compressed)
+		 */
+		const uint8_t*	getBlocks() const;
+
+		/**
+		 * \brief Gives the size of the compressed blocks
+		 * \return The number of bytes pointed to by getBlocks
+		 */
+		size_t			getBlockDataSize() const;
+
+		/**
+		 * \brief Gives direct access to the texture's pixel buffer, stored in the texture's layout
+		 * \return A pointer to the first pixel of the texture (nullptr if the texture is compressed)
+		 */
+		Color*			getPixels();
+
+		/**
+		 * \brief Gives direct read access to the texture's pixel buffer, stored in the texture's layout
+		 * \return A pointer to the first pixel of the texture (nullptr if the texture is compressed)
+		 */
+		const Color*	getPixels() const;
 	private:
-		uint32_t	m_width;
-		uint32_t	m_height;
-		Color*		m_pixels;
-		
+		struct MipLevel
+		{
+			uint32_t		m_width;
+			uint32_t		m_height;
+			const Color*	m_pixels;
+			const uint8_t*	m_blocks;
+		};
+
+		// Width and height of the tiles of the tiled layout
+		static constexpr uint32_t TILE_SIZE = 4;
+
+		static constexpr int32_t NOT_SAMPLED = INT32_MAX;
+
+		/**
+		 * \brief Gives the size of the buffer holding a level of the given size
+		 * \return The number of pixels of the buffer, including the padding of the tiled layout
+		 */
+		static size_t	getBufferSize(uint32_t p_width, uint32_t p_height, ETextureLayout p_layout);
+
+		/**
+		 * \brief Finds the given pixel of a level stored in the given layout
+		 * \return The index of the pixel in the level's buffer
+		 */
+		static size_t	getPixelIndex(ETextureLayout p_layout, uint32_t p_levelWidth, uint32_t p_x, uint32_t p_y);
+
+		/**
+		 * \brief Decodes the given image in the texture's layout then builds its mip chain
+		 * \param p_data The encoded image
+		 * \param p_size The number of bytes of the encoded image
+		 * \param p_source The name of the image, for error messages
+		 * \param p_firstLevel The number of largest levels to skip
+		 */
+		void		decodeImage(const uint8_t* p_data, size_t p_size, const std::string& p_source, size_t p_firstLevel);
+
+		/**
+		 * \brief Points the mip levels to the texture's pixels then to the given mip chain
+		 * \param p_mipPixels The mip levels after the first one (nullptr to only keep the texture itself)
+		 */
+		void		bindMipLevels(const Color* p_mipPixels);
+
+		/**
+		 * \brief Points the mip levels to the given compressed blocks
+		 * \param p_blocks The blocks of every level
+		 */
+		void		bindBlockLevels(const uint8_t* p_blocks);
+
+		/**
+		 * \brief Copies the compressed blocks of the given texture, if any
+		 * \param p_other The texture whose blocks should be copied
+		 */
+		void		copyBlocks(const Texture& p_other);
+
+		/**
+		 * \brief Gives the size of the blocks of a level of the given size
+		 * \return The number of bytes of the level's blocks
+		 */
+		static size_t	getLevelBlockSize(uint32_t p_width, uint32_t p_height, ETextureCompression p_compression);
+
+		/**
+		 * \brief Gives the size of the blocks of a texture of the given size and of its whole mip chain
+		 * \return The number of bytes of the blocks
+		 */
+		static size_t	getBlockChainSize(uint32_t p_width, uint32_t p_height, ETextureCompression p_compression);
+
+		/**
+		 * \brief Reads a texel of the given level, decoding its block if the texture is compressed
+		 * \return The color of the texel
+		 */
+		Color		getTexel(const MipLevel& p_level, uint32_t p_x, uint32_t p_y) const;
+
+		/**
+		 * \brief Finds the compressed block holding the given texel of a level
+		 * \return A pointer to the first byte of the block
+		 */
+		const uint8_t*	getBlock(const MipLevel& p_level, uint32_t p_x, uint32_t p_y) const;
+
+		/**
+		 * \brief Decodes the given block, or finds it in the calling thread's cache of decoded blocks
+		 * \return The block's texels, valid until the thread decodes another block in the same cache entry
+		 */
+		const Color*	decodeBlock(const uint8_t* p_block) const;
+
+		/**
+		 * \brief Samples the given mip level with bilinear filtering, wrapping the texture coordinates
+		 * and clamping the filter to the level's edges
+		 * \return The filtered color of the level at the given coordinates
+		 */
+		Color		sampleBilinear(const MipLevel& p_level, float p_u, float p_v) const;
+
+		uint32_t				m_width;
+		uint32_t				m_height;
+		Color*					m_pixels;
+		bool					m_isOwner = true;
+		ETextureLayout			m_layout = ETextureLayout::E_LINEAR;
+		ETextureCompression		m_compression = ETextureCompression::E_NONE;
+		std::vector<Color>		m_mipChain;
+		std::vector<uint8_t>	m_blockData;
+		const uint8_t*			m_blocks = nullptr;
+		uint64_t				m_blockDataId = 0;
+		std::vector<MipLevel>	m_mipLevels;
+		const VirtualTexture*	m_virtualTexture = nullptr;
+
+		// Finest level sampled since the last takeSampledLevel, written by the rendering threads
+		mutable std::atomic<int32_t>	m_finestSampledLevel { NOT_SAMPLED };
 	};
 
 }
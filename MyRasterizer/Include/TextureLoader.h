@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Texture.h"
+#include "ThreadPool.h"
+
+namespace My
+{
+	class TextureHandle
+	{
+	public:
+		/**
+		 * \brief Creates an empty handle, referring to no texture
+		 */
+		TextureHandle() = default;
+
+		/**
+		 * \brief Gives the texture to render with. Until the image is loaded, this is a white placeholder
+		 * whose content is replaced by the loader's update, so the pointer can be given to meshes right away
+		 * \return A pointer to the texture, stable for the lifetime of the handle's copies (nullptr for an empty handle)
+		 */
+		const Texture*	get() const;
+
+		/**
+		 * \brief Checks whether the loaded image replaced the placeholder
+		 * \return True if the texture is ready. False otherwise
+		 */
+		bool			isReady() const;
+
+		/**
+		 * \brief Checks whether the image couldn't be loaded, in which case the placeholder is kept
+		 * \return True if the loading failed. False otherwise
+		 */
+		bool			hasFailed() const;
+
+		/**
+		 * \brief Gives the reason the image couldn't be loaded
+		 * \return The error message (empty unless the loading failed)
+		 */
+		const std::string&	getError() const;
+
+	private:
+		friend class TextureLoader;
+
+		enum class EState : uint8_t
+		{
+			E_LOADING,
+			E_DECODED,	// Decoded by a worker, waiting for the update to take it
+			E_READY,
+			E_FAILED
+		};
+
+		struct State
+		{
+			Texture						m_texture;
+			std::unique_ptr<Texture>	m_decoded;
+			std::string					m_error;
+			std::atomic<EState>			m_state { EState::E_LOADING };
+
+			State();
+		};
+
+		explicit TextureHandle(std::shared_ptr<State> p_state);
+
+		std::shared_ptr<State>	m_state;
+	};
+
+	class TextureLoader
+	{
+	public:
+		/**
+		 * \brief Creates a loader decoding images on its own worker threads, apart from the rendering pool
+		 * \param p_threadCount The number of worker threads
+		 */
+		explicit TextureLoader(size_t p_threadCount = 2);
+
+		TextureLoader(const TextureLoader& p_other) = delete;
+		TextureLoader(TextureLoader&& p_other) = delete;
+
+		/**
+		 * \brief Waits for the queued images to be decoded then joins the worker threads
+		 */
+		~TextureLoader() = default;
+
+		TextureLoader& operator=(const TextureLoader& p_other) = delete;
+		TextureLoader& operator=(TextureLoader&& p_other) = delete;
+
+		/**
+		 * \brief Queues the given image for loading and returns without waiting for it
+		 * \param p_imagePath The path of the image to load
+		 * \param p_layout The layout in which the pixels should be stored
+		 * \param p_compression The block format the texture should be compressed to (E_NONE to keep the pixels)
+		 * \return A handle whose texture is a placeholder until the image is loaded
+		 */
+		TextureHandle	load(const std::string& p_imagePath, ETextureLayout p_layout = ETextureLayout::E_TILED,
+			ETextureCompression p_compression = ETextureCompression::E_NONE);
+
+		/**
+		 * \brief Replaces the placeholders of the decoded images by their texture. Must be called from the
+		 * rendering thread while no frame is rendered, such as between frames
+		 * \return The number of textures which became ready
+		 */
+		size_t			update();
+
+		/**
+		 * \brief Checks whether some images are still being loaded or waiting for an update
+		 * \return True if some handles aren't ready nor failed. False otherwise
+		 */
+		bool			isLoading() const;
+
+	private:
+		std::vector<std::shared_ptr<TextureHandle::State>>	m_pending;
+
+		// Declared last to be joined before the pending states are released
+		ThreadPool											m_pool;
+	};
+}
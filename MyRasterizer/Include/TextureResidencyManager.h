@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Texture.h"
+#include "ThreadPool.h"
+
+namespace My
+{
+	class TextureResidencyManager
+	{
+	public:
+		/**
+		 * \brief Creates a manager keeping the textures it manages under the given memory budget
+		 * \param p_budget The number of bytes the managed textures may use
+		 * \param p_threadCount The number of worker threads reloading the textures' freed levels
+		 */
+		explicit TextureResidencyManager(size_t p_budget, size_t p_threadCount = 1);
+
+		TextureResidencyManager(const TextureResidencyManager& p_other) = delete;
+		TextureResidencyManager(TextureResidencyManager&& p_other) = delete;
+
+		/**
+		 * \brief Waits for the pending reloads then joins the worker threads. The textures keep their current levels
+		 */
+		~TextureResidencyManager() = default;
+
+		TextureResidencyManager& operator=(const TextureResidencyManager& p_other) = delete;
+		TextureResidencyManager& operator=(TextureResidencyManager&& p_other) = delete;
+
+		/**
+		 * \brief Starts managing the given texture, whose freed levels are reloaded from the given image.
+		 * The texture must stay alive until it is released
+		 * \param p_texture The texture to manage, with all its levels
+		 * \param p_imagePath The image the texture was loaded from
+		 */
+		void	manage(Texture& p_texture, const std::string& p_imagePath);
+
+		/**
+		 * \brief Stops managing the given texture, cancelling its pending reload
+		 * \param p_texture The texture to release
+		 */
+		void	release(const Texture& p_texture);
+
+		/**
+		 * \brief Reads which levels the rasterizer sampled since the last update, frees the largest levels of the
+		 * least recently used textures while over budget and reloads the levels which are needed again and fit.
+		 * A reload only starts if the budget also fits its transient memory: the whole decoded image, plus the
+		 * uncompressed levels of compressed textures. Must be called from the rendering thread while no frame
+		 * is rendered, such as between frames
+		 * \return The number of textures whose levels changed
+		 */
+		size_t	update();
+
+		/**
+		 * \brief Gives the memory used by the managed textures
+		 * \return The number of bytes of the textures' buffers
+		 */
+		size_t	getResidentSize() const;
+
+		size_t	getBudget() const;
+
+		/**
+		 * \brief Sets the memory budget, which is enforced on the next update. The reloads which already started
+		 * may still briefly exceed a lowered budget with their decoded image
+		 * \param p_budget The number of bytes the managed textures may use
+		 */
+		void	setBudget(size_t p_budget);
+
+		/**
+		 * \brief Gives the number of largest levels freed from the given texture
+		 * \param p_texture A managed texture
+		 * \return The index of the texture's first resident level in its full mip chain
+		 */
+		size_t	getFirstResidentLevel(const Texture& p_texture) const;
+
+	private:
+		struct Reload
+		{
+			std::unique_ptr<Texture>	m_texture;
+			size_t						m_firstLevel = 0;
+			size_t						m_extraSize = 0;	// Expected growth of the texture once reloaded
+			size_t						m_transientSize = 0;	// Memory held while decoding
+			std::atomic<bool>			m_isDone { false };
+		};
+
+		struct Entry
+		{
+			Texture*				m_texture;
+			std::string				m_imagePath;
+			ETextureLayout			m_layout;
+			ETextureCompression		m_compression;
+			size_t					m_levelCount;		// Of the full mip chain
+			size_t					m_imageSize;		// Of the decoded image, at full resolution
+			size_t					m_firstLevel = 0;	// First resident level
+			size_t					m_wantedLevel = 0;	// Finest level sampled recently
+			uint64_t				m_lastUsedFrame = 0;
+			std::shared_ptr<Reload>	m_reload;
+		};
+
+		/**
+		 * \brief Finds the entry of the given texture
+		 * \return The index of the entry in m_entries. Throws if the texture isn't managed
+		 */
+		size_t	findEntry(const Texture& p_texture) const;
+
+		/**
+		 * \brief Queues the reload of the given entry's texture, from the given level
+		 */
+		void	queueReload(Entry& p_entry, size_t p_firstLevel, size_t p_extraSize, size_t p_transientSize);
+
+		std::vector<Entry>	m_entries;
+		size_t				m_budget;
+		uint64_t			m_frame = 0;
+
+		// Declared last to be joined before the pending reloads are released
+		ThreadPool			m_pool;
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace My
+{
+	class ThreadPool
+	{
+	public:
+		typedef std::function<void(size_t p_begin, size_t p_end)> RangeFunc;
+
+		/**
+		 * \brief Creates a thread pool with the given number of worker threads
+		 * \param p_threadCount The number of worker threads (hardware concurrency if 0)
+		 */
+		explicit ThreadPool(size_t p_threadCount = 0);
+
+		ThreadPool(const ThreadPool& p_other) = delete;
+		ThreadPool(ThreadPool&& p_other) = delete;
+
+		/**
+		 * \brief Waits for the queued tasks to finish then joins the worker threads
+		 */
+		~ThreadPool();
+
+		ThreadPool& operator=(const ThreadPool& p_other) = delete;
+		ThreadPool& operator=(ThreadPool&& p_other) = delete;
+
+		/**
+		 * \brief Gives read access to the number of worker threads of the pool
+		 * \return The number of worker threads of the pool
+		 */
+		size_t getThreadCount() const;
+
+		/**
+		 * \brief Splits the range [0, p_count) in chunks and processes them on the pool.
+		 * The calling thread takes part in the work and returns once every chunk is done.
+		 * \param p_count The number of elements to process
+		 * \param p_func The function to call for each chunk [begin, end)
+		 * \param p_minChunkSize The minimum number of elements per chunk
+		 */
+		void parallelFor(size_t p_count, const RangeFunc& p_func, size_t p_minChunkSize = 1);
+
+		/**
+		 * \brief Queues the given task and returns without waiting for it. Exceptions thrown by the task are
+		 * not reported, so it should catch its own
+		 * \param p_task The task to run on one of the worker threads
+		 */
+		void enqueue(std::function<void()> p_task);
+
+		/**
+		 * \brief Gives access to the thread pool shared by the rendering code
+		 * \return A reference to the default thread pool
+		 */
+		static ThreadPool& getDefault();
+
+	private:
+		std::vector<std::thread>			m_workers;
+		std::queue<std::function<void()>>	m_tasks;
+		std::mutex							m_mutex;
+		std::condition_variable				m_condition;
+		bool								m_isStopping = false;
+
+		/**
+		 * \brief Adds a task to the queue and wakes up a worker to run it
+		 * \param p_task The task to run
+		 */
+		void push(std::function<void()> p_task);
+
+		/**
+		 * \brief The loop run by each worker thread
+		 */
+		void workerLoop();
+	};
+}
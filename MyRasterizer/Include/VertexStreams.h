@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Color.h"
+#include "Vertex.h"
+
+namespace My
+{
+	enum class EVertexLayout : uint8_t
+	{
+		E_INTERLEAVED,
+		E_SEPARATE
+	};
+
+	/**
+	 * \brief Read only view over one contiguous vertex attribute, owned by a VertexStreams
+	 */
+	template <typename T>
+	class StreamView
+	{
+	public:
+		StreamView() = default;
+
+		/**
+		 * \brief Creates a view over the given elements
+		 * \param p_data The first element of the stream
+		 * \param p_size The number of elements of the stream
+		 */
+		StreamView(const T* p_data, const size_t p_size) :
+			m_data(p_data), m_size(p_size) {}
+
+		const T*	data() const { return m_data; }
+		size_t		size() const { return m_size; }
+		bool		empty() const { return m_size == 0; }
+		const T*	begin() const { return m_data; }
+		const T*	end() const { return m_data + m_size; }
+
+		const T&	operator[](const size_t p_index) const { return m_data[p_index]; }
+
+	private:
+		const T*	m_data = nullptr;
+		size_t		m_size = 0;
+	};
+
+	struct Vector3Streams
+	{
+		StreamView<float>	m_x;
+		StreamView<float>	m_y;
+		StreamView<float>	m_z;
+	};
+
+	struct TexCoordStreams
+	{
+		StreamView<float>	m_u;
+		StreamView<float>	m_v;
+	};
+
+	class VertexStreams
+	{
+	public:
+		// Number of floats processed at once by the SSE kernels
+		static constexpr size_t SIMD_WIDTH = 4;
+
+		VertexStreams() = default;
+
+		/**
+		 * \brief Splits the given vertices into one stream per attribute component
+		 * \param p_vertices The vertices to split
+		 */
+		explicit VertexStreams(const std::vector<Vertex>& p_vertices);
+
+		/**
+		 * \brief Gives the number of vertices in the streams
+		 * \return The number of vertices
+		 */
+		size_t size() const;
+
+		/**
+		 * \brief Checks whether the streams hold no vertex
+		 * \return True if there is no vertex. False otherwise
+		 */
+		bool empty() const;
+
+		/**
+		 * \brief Gives the number of elements readable from the position and normal streams.
+		 * The streams are padded with copies of the last vertex to a multiple of SIMD_WIDTH
+		 * so that kernels can load full registers without handling the tail separately
+		 * \return The padded number of vertices
+		 */
+		size_t getPaddedSize() const;
+
+		/**
+		 * \brief Gives read access to the position streams. Depth only passes only need these
+		 * \return Views over the x, y and z components of the positions
+		 */
+		Vector3Streams getPositions() const;
+
+		/**
+		 * \brief Gives read access to the normal streams
+		 * \return Views over the x, y and z components of the normals
+		 */
+		Vector3Streams getNormals() const;
+
+		/**
+		 * \brief Gives read access to the color stream
+		 * \return A view over the vertices' colors
+		 */
+		StreamView<Color> getColors() const;
+
+		/**
+		 * \brief Gives read access to the texture coordinate streams
+		 * \return Views over the u and v components of the texture coordinates
+		 */
+		TexCoordStreams getTexCoords() const;
+
+		/**
+		 * \brief Gathers the attributes of the given vertex
+		 * \param p_index The index of the vertex
+		 * \return The interleaved vertex
+		 */
+		Vertex getVertex(size_t p_index) const;
+
+		/**
+		 * \brief Gathers every vertex back into an interleaved buffer
+		 * \return The interleaved vertices
+		 */
+		std::vector<Vertex> toVertices() const;
+
+	private:
+		std::vector<float>	m_positionX;
+		std::vector<float>	m_positionY;
+		std::vector<float>	m_positionZ;
+		std::vector<float>	m_normalX;
+		std::vector<float>	m_normalY;
+		std::vector<float>	m_normalZ;
+		std::vector<Color>	m_colors;
+		std::vector<float>	m_u;
+		std::vector<float>	m_v;
+	};
+}
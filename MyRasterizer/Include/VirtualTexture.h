@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Color.h"
+#include "MappedFile.h"
+
+namespace My
+{
+	class Texture;
+
+	class VirtualTexture
+	{
+	public:
+		/**
+		 * \brief Fills a page of the given mip level. Called from the default thread pool's threads
+		 * \param p_level The mip level of the page
+		 * \param p_pageX The column of the page in the level
+		 * \param p_pageY The row of the page in the level
+		 * \param p_texels Receives the page's texels, in row-major order with rows of PAGE_SIZE texels.
+		 * Pages crossing the level's edges only need their texels inside the level
+		 */
+		typedef std::function<void(uint32_t p_level, uint32_t p_pageX, uint32_t p_pageY, Color* p_texels)> PageLoader;
+
+		// Width and height of a page, in texels
+		static constexpr uint32_t PAGE_SIZE = 128;
+
+		/**
+		 * \brief Creates a virtual texture whose pages are only loaded once they are sampled.
+		 * The pages of the levels fitting in a single page are loaded right away and always stay resident,
+		 * so sampling can always fall back to them
+		 * \param p_width The width of the texture's first level
+		 * \param p_height The height of the texture's first level
+		 * \param p_loader Fills the pages of every mip level
+		 * \param p_residentPageCount The number of pages which can be resident at once, besides the coarsest levels'
+		 */
+		VirtualTexture(uint32_t p_width, uint32_t p_height, PageLoader p_loader, size_t p_residentPageCount);
+
+		/**
+		 * \brief Maps the given page file, whose pages are copied from the mapping once they are sampled
+		 * \param p_pageFilePath The path of a file written by savePageFile
+		 * \param p_residentPageCount The number of pages which can be resident at once, besides the coarsest levels'
+		 */
+		VirtualTexture(const std::string& p_pageFilePath, size_t p_residentPageCount);
+
+		VirtualTexture(const VirtualTexture& p_other) = delete;
+		VirtualTexture(VirtualTexture&& p_other) = delete;
+		~VirtualTexture() = default;
+
+		VirtualTexture& operator=(const VirtualTexture& p_other) = delete;
+		VirtualTexture& operator=(VirtualTexture&& p_other) = delete;
+
+		uint32_t	getWidth() const;
+		uint32_t	getHeight() const;
+
+		/**
+		 * \brief Gives the number of mip levels of the texture
+		 * \return The number of levels, down to a single texel
+		 */
+		size_t		getMipLevelCount() const;
+
+		/**
+		 * \brief Samples the texture like Texture::sampleTrilinear, translating the texel addresses through the
+		 * page table. Levels whose page isn't resident fall back to the next coarser level. The finest needed page
+		 * is requested for the next update. Safe to call from any thread, while no update runs
+		 * \param p_u The horizontal texture coordinate
+		 * \param p_v The vertical texture coordinate
+		 * \param p_lod The mip level to sample
+		 * \return The filtered color of the texture at the given coordinates
+		 */
+		Color		sampleTrilinear(float p_u, float p_v, float p_lod) const;
+
+		/**
+		 * \brief Loads the pages requested since the last update in parallel, coarsest first, replacing the least
+		 * recently used pages which weren't requested. Must be called while no frame is rendered, such as between frames
+		 * \param p_maxPageCount The maximum number of pages to load
+		 * \return The number of loaded pages
+		 */
+		size_t		update(size_t p_maxPageCount = SIZE_MAX);
+
+		/**
+		 * \brief Gives the number of pages currently resident, including the coarsest levels'
+		 * \return The number of pages mapped in the page table
+		 */
+		size_t		getResidentPageCount() const;
+
+		/**
+		 * \brief Writes the pages of the given texture and of its mip chain, which is built if needed
+		 * \param p_path The path of the page file to write
+		 * \param p_texture The uncompressed texture to split in pages
+		 */
+		static void	savePageFile(const std::string& p_path, const Texture& p_texture);
+
+	private:
+		struct Level
+		{
+			uint32_t	m_width;
+			uint32_t	m_height;
+			uint32_t	m_pageCountX;
+			uint32_t	m_pageCountY;
+			size_t		m_firstPage;	// Index of the level's first page among every level's
+		};
+
+		static constexpr int32_t NO_SLOT = -1;
+
+		/**
+		 * \brief Builds the levels and the page table then loads the coarsest levels' pages
+		 * \param p_residentPageCount The number of slots of the pages which can be evicted
+		 */
+		void		initialize(size_t p_residentPageCount);
+
+		/**
+		 * \brief Finds the level of the given page and its position in the level
+		 * \return The index of the page's level
+		 */
+		size_t		findPage(size_t p_page, uint32_t& p_pageX, uint32_t& p_pageY) const;
+
+		/**
+		 * \brief Loads the given pages in the given slots and maps them in the page table
+		 */
+		void		loadPages(const std::vector<size_t>& p_pages, const std::vector<size_t>& p_slots);
+
+		/**
+		 * \brief Samples the given level with bilinear filtering if the pages of the footprint are resident
+		 * \param p_color Receives the filtered color
+		 * \return True if the level could be sampled. False otherwise
+		 */
+		bool		trySampleBilinear(size_t p_level, float p_u, float p_v, Color& p_color) const;
+
+		/**
+		 * \brief Samples the finest level starting from the given one whose pages are resident
+		 * \return The filtered color
+		 */
+		Color		sampleBilinear(size_t p_level, float p_u, float p_v) const;
+
+		uint32_t						m_width;
+		uint32_t						m_height;
+		PageLoader						m_loader;
+		std::unique_ptr<MappedFile>		m_pageFile;
+		std::vector<Level>				m_levels;
+
+		// Slot of each page of every level, in the pool of page texels
+		std::vector<int32_t>			m_pageTable;
+		std::vector<Color>				m_slotTexels;
+		std::vector<size_t>				m_slotPages;
+		std::vector<uint64_t>			m_slotLastUsedFrames;
+		size_t							m_pinnedSlotCount = 0;
+		uint64_t						m_frame = 0;
+
+		// Pages sampled since the last update, set by the rendering threads
+		std::unique_ptr<std::atomic<uint8_t>[]>	m_requestedPages;
+	};
+}
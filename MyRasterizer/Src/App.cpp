@@ -10,7 +10,8 @@
 namespace My
 {
 	App::App(const int p_screenWidth, const int p_screenHeight, const char* p_title)
-		: m_renderTexture(p_screenWidth, p_screenHeight), m_rasterizer(2)
+		: m_renderTexture(p_screenWidth, p_screenHeight), m_rasterizer(2),
+		m_containerTexture(m_textureLoader.load("../img/container.png"))
 	{
 		// Initialization
 		InitWindow(p_screenWidth, p_screenHeight, p_title);
@@ -37,8 +38,10 @@ namespace My
 		// Main game loop
 		while (!WindowShouldClose())
 		{
-			// Draw
-			if (checkInput())
+			// Draw (also when loaded textures replaced their placeholder)
+			const bool hasNewTextures = m_textureLoader.update() > 0;
+
+			if (checkInput() || hasNewTextures)
 				m_rasterizer.renderScene(m_scene, m_camera, m_renderTexture);
 
 			BeginDrawing();
@@ -65,47 +68,72 @@ namespace My
 
 	void App::createScene()
 	{
-		m_scene = Scene();
+		// Built apart so the meshes of the previous scene are reused by the registry rather than recreated
+		Scene scene;
 		m_camera.setTransform(Mat4::scaling(1.f, 1.f, -1.f) * Mat4::translation(0, 0, 2));
 
-		Mesh* cube = Mesh::createCube();
-		cube->setTexture(&CONTAINER_TEXTURE);
-		m_scene.addMesh("cube", *cube);
+		const Texture* containerTexture = m_containerTexture.get();
 
-		m_scene.addMesh("sphereW", *Mesh::createSphere(4, 4, Color::white));
-		m_scene.addMesh("sphereR", *Mesh::createSphere(16, 16, Color::red));
-		m_scene.addMesh("sphereG", *Mesh::createSphere(16, 16, Color::green));
-		m_scene.addMesh("sphereB", *Mesh::createSphere(16, 16, Color::blue));
+		scene.addMesh("cube", m_assets.findOrCreateMesh("cube", [containerTexture]
+		{
+			Mesh* cube = Mesh::createCube();
+			cube->setTexture(containerTexture);
+			cube->setOccluder(true);
+			return cube;
+		}));
 
+		scene.addMesh("sphereW", m_assets.findOrCreateMesh("sphere4W", []
+		{
+			return Mesh::createSphere(4, 4, Color::white);
+		}));
+		scene.addMesh("sphereR", m_assets.findOrCreateMesh("sphere16R", []
+		{
+			return Mesh::createSphere(16, 16, Color::red);
+		}));
+		scene.addMesh("sphereG", m_assets.findOrCreateMesh("sphere16G", []
+		{
+			return Mesh::createSphere(16, 16, Color::green);
+		}));
+		scene.addMesh("sphereB", m_assets.findOrCreateMesh("sphere16B", []
+		{
+			return Mesh::createSphere(16, 16, Color::blue);
+		}));
+
+		// Opaque, since only opaque entities hide the spheres behind them during occlusion culling
 		Mat4 transform = Mat4::translation(0, 0, 2) * Mat4::scaling(1.25f, 1.25f, 1.25f);
-		m_scene.addEntity(Entity(*m_scene.getMesh("cube"), 0.4f, transform));
+		scene.addEntity(Entity(*scene.getMesh("cube"), transform));
 
 		transform = Mat4::translation(0, 1.f, 3);
-		m_scene.addEntity(Entity(*m_scene.getMesh("sphereR"), transform));
+		scene.addEntity(Entity(*scene.getMesh("sphereR"), transform));
 
 		transform = Mat4::translation(-1.f, -1.f, 3);
-		m_scene.addEntity(Entity(*m_scene.getMesh("sphereG"), transform));
+		scene.addEntity(Entity(*scene.getMesh("sphereG"), transform));
 
 		transform = Mat4::translation(1.f, -1.f, 3);
-		m_scene.addEntity(Entity(*m_scene.getMesh("sphereB"), transform));
+		scene.addEntity(Entity(*scene.getMesh("sphereB"), transform));
 
 		//light
 		const Mat4 lightScale = Mat4::scaling(.05f, .05f, .05f);
 
 		Vec3 lightPos = Vec3(0, 2.f, 1);
 		transform = Mat4::translation(lightPos.m_x, lightPos.m_y, lightPos.m_z) * lightScale;
-		m_scene.addEntity(Entity(*m_scene.getMesh("sphereW"), transform));
-		m_scene.addLight(Light(lightPos, 0.1f, 0.5f, 0.4f, 8));
+		scene.addEntity(Entity(*scene.getMesh("sphereW"), transform));
+		scene.addLight(Light(lightPos, 0.1f, 0.5f, 0.4f, 8));
 
 		lightPos = Vec3(-2.f, -2.f, 1);
 		transform = Mat4::translation(lightPos.m_x, lightPos.m_y, lightPos.m_z) * lightScale;
-		m_scene.addEntity(Entity(*m_scene.getMesh("sphereW"), transform));
-		m_scene.addLight(Light(lightPos, 0.1f, 0.5f, 0.4f, 8));
+		scene.addEntity(Entity(*scene.getMesh("sphereW"), transform));
+		scene.addLight(Light(lightPos, 0.1f, 0.5f, 0.4f, 8));
 
 		lightPos = Vec3(2.f, -2.f, 1);
 		transform = Mat4::translation(lightPos.m_x, lightPos.m_y, lightPos.m_z) * lightScale;
-		m_scene.addEntity(Entity(*m_scene.getMesh("sphereW"), transform));
-		m_scene.addLight(Light(lightPos, 0.1f, 0.5f, 0.4f, 8));
+		scene.addEntity(Entity(*scene.getMesh("sphereW"), transform));
+		scene.addLight(Light(lightPos, 0.1f, 0.5f, 0.4f, 8));
+
+		m_scene = std::move(scene);
+
+		// The levels of detail of the previous scene's entities don't apply to the new ones
+		m_rasterizer.resetLodState();
 	}
 
 	bool App::checkInput()
@@ -126,10 +154,31 @@ namespace My
 			hasSceneChanged = true;
 		}
 
+		if (IsKeyPressed(KEY_F2))
+		{
+			m_rasterizer.setAntiAliasing(
+				m_rasterizer.getAntiAliasing() == Rasterizer::EAntiAliasing::E_FXAA
+				? Rasterizer::EAntiAliasing::E_NONE
+				: Rasterizer::EAntiAliasing::E_FXAA);
+			hasSceneChanged = true;
+		}
+
+		if (IsKeyPressed(KEY_F3))
+		{
+			m_rasterizer.setOcclusionCulling(!m_rasterizer.isOcclusionCullingEnabled());
+			hasSceneChanged = true;
+		}
+
+		if (IsKeyPressed(KEY_F4))
+		{
+			m_rasterizer.setHdr(!m_rasterizer.isHdrEnabled());
+			hasSceneChanged = true;
+		}
+
 		if (IsKeyDown(KEY_R))
 		{
-			for (auto& entity : m_scene.getEntities())
-				entity.rotateEulerAngles(ROTATION_SPEED * deltaTime, ROTATION_SPEED * deltaTime, 0_rad);
+			for (size_t i = 0; i < m_scene.getEntities().size(); i++)
+				m_scene.getEntity(i).rotateEulerAngles(ROTATION_SPEED * deltaTime, ROTATION_SPEED * deltaTime, 0_rad);
 
 			hasSceneChanged = true;
 		}
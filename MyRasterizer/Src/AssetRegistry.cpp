@@ -0,0 +1,206 @@
+#include "AssetRegistry.h"
+
+#include <cstring>
+#include <exception>
+#include <set>
+
+#include "MappedFile.h"
+#include "MeshImporter.h"
+
+namespace My
+{
+	namespace
+	{
+		/**
+		 * \brief Hashes the given bytes with 64 bits FNV-1a
+		 */
+		uint64_t hashContent(const char* p_data, const size_t p_size)
+		{
+			uint64_t hash = 14695981039346656037ull;
+
+			for (size_t i = 0; i < p_size; i++)
+			{
+				hash ^= static_cast<uint8_t>(p_data[i]);
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+
+		/**
+		 * \brief Checks whether the given image holds the same bytes as the given file
+		 * \return False if the image differs or can't be read anymore
+		 */
+		bool hasSameContent(const MappedFile& p_file, const std::string& p_imagePath)
+		{
+			try
+			{
+				const MappedFile image(p_imagePath);
+
+				return image.getSize() == p_file.getSize()
+					&& (p_file.getSize() == 0 || std::memcmp(image.getData(), p_file.getData(), p_file.getSize()) == 0);
+			}
+			catch (const std::exception&)
+			{
+				// The image was changed or removed since it was loaded
+				return false;
+			}
+		}
+
+		template <typename TKey, typename TAsset>
+		void eraseExpired(std::map<TKey, std::weak_ptr<const TAsset>>& p_assets)
+		{
+			for (auto it = p_assets.begin(); it != p_assets.end();)
+				it = it->second.expired() ? p_assets.erase(it) : std::next(it);
+		}
+	}
+
+	std::shared_ptr<const Texture> AssetRegistry::loadTexture(const std::string& p_imagePath,
+		const ETextureLayout p_layout)
+	{
+		const auto pathKey = std::make_pair(p_imagePath, p_layout);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (auto texture = find(m_texturesByPath, pathKey))
+				return texture;
+		}
+
+		// Read and decoded outside of the lock so other threads can load other assets meanwhile
+		const MappedFile file(p_imagePath);
+		const auto contentKey = std::make_pair(ContentKey(hashContent(file.getData(), file.getSize()), file.getSize()),
+			p_layout);
+
+		std::shared_ptr<const Texture> candidate;
+		std::string candidatePath;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			candidate = find(m_texturesByContent, contentKey);
+
+			if (candidate != nullptr)
+				candidatePath = m_contentPaths[contentKey];
+		}
+
+		// Different images may share a hash and a size, so their bytes are compared before sharing the texture
+		if (candidate != nullptr && hasSameContent(file, candidatePath))
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_texturesByPath[pathKey] = candidate;
+			return candidate;
+		}
+
+		std::shared_ptr<const Texture> texture = std::make_shared<const Texture>(
+			Texture::decode(file.getData(), file.getSize(), p_layout));
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Another thread may have loaded the same image in the meantime. An image colliding with the one
+		// already cached keeps its own texture, only found by path
+		auto cached = find(m_texturesByContent, contentKey);
+
+		if (cached == nullptr)
+		{
+			m_texturesByContent[contentKey] = texture;
+			m_contentPaths[contentKey] = p_imagePath;
+		}
+		else if (m_contentPaths[contentKey] == p_imagePath)
+		{
+			texture = std::move(cached);
+		}
+
+		m_texturesByPath[pathKey] = texture;
+
+		return texture;
+	}
+
+	std::shared_ptr<const Mesh> AssetRegistry::loadMesh(const std::string& p_path)
+	{
+		return findOrCreateMesh(p_path, [&p_path]
+		{
+			return new Mesh(MeshImporter::load(p_path));
+		});
+	}
+
+	std::shared_ptr<const Mesh> AssetRegistry::findOrCreateMesh(const std::string& p_key, const MeshFactory& p_factory)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (auto mesh = find(m_meshes, p_key))
+				return mesh;
+		}
+
+		std::shared_ptr<const Mesh> created(p_factory());
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto mesh = find(m_meshes, p_key);
+
+		if (mesh == nullptr)
+		{
+			mesh = std::move(created);
+			m_meshes[p_key] = mesh;
+		}
+
+		return mesh;
+	}
+
+	void AssetRegistry::purge()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		eraseExpired(m_texturesByPath);
+		eraseExpired(m_texturesByContent);
+
+		for (auto it = m_contentPaths.begin(); it != m_contentPaths.end();)
+			it = m_texturesByContent.count(it->first) == 0 ? m_contentPaths.erase(it) : std::next(it);
+		eraseExpired(m_meshes);
+	}
+
+	size_t AssetRegistry::getTextureCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Several paths may share a texture, and images colliding with a cached one are only cached by path
+		std::set<const Texture*> textures;
+
+		for (const auto& pair : m_texturesByPath)
+		{
+			if (const auto texture = pair.second.lock())
+				textures.insert(texture.get());
+		}
+
+		return textures.size();
+	}
+
+	size_t AssetRegistry::getMeshCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		return countLive(m_meshes);
+	}
+
+	template <typename TAsset, typename TKey>
+	std::shared_ptr<const TAsset> AssetRegistry::find(const std::map<TKey, std::weak_ptr<const TAsset>>& p_assets,
+		const TKey& p_key)
+	{
+		const auto it = p_assets.find(p_key);
+
+		return it == p_assets.end() ? nullptr : it->second.lock();
+	}
+
+	template <typename TAsset, typename TKey>
+	size_t AssetRegistry::countLive(const std::map<TKey, std::weak_ptr<const TAsset>>& p_assets)
+	{
+		size_t count = 0;
+
+		for (const auto& pair : p_assets)
+			count += pair.second.expired() ? 0 : 1;
+
+		return count;
+	}
+}
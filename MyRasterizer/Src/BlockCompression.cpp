@@ -0,0 +1,266 @@
+#include "BlockCompression.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include "PixelFormat.h"
+
+namespace My
+{
+	namespace
+	{
+		constexpr uint8_t HALF_ALPHA = 128;
+
+		// Index of the transparent black of three color blocks
+		constexpr uint32_t TRANSPARENT_INDEX = 3;
+
+		uint8_t mix(const uint8_t p_a, const uint8_t p_b, const int p_weightA, const int p_weightB)
+		{
+			return static_cast<uint8_t>((p_a * p_weightA + p_b * p_weightB) / (p_weightA + p_weightB));
+		}
+
+		/**
+		 * \brief Builds the colors the indices of a block refer to. Shared by the encoder and the decoder so both
+		 * agree on the rounding
+		 */
+		void buildPalette(const BC1Block& p_block, const bool p_isFourColors, Color p_palette[4])
+		{
+			p_palette[0] = FormatRGB565::toColor(p_block.m_color0);
+			p_palette[1] = FormatRGB565::toColor(p_block.m_color1);
+
+			const Color& color0 = p_palette[0];
+			const Color& color1 = p_palette[1];
+
+			if (p_isFourColors || p_block.m_color0 > p_block.m_color1)
+			{
+				p_palette[2] = { mix(color0.m_r, color1.m_r, 2, 1), mix(color0.m_g, color1.m_g, 2, 1),
+					mix(color0.m_b, color1.m_b, 2, 1), UINT8_MAX };
+				p_palette[3] = { mix(color0.m_r, color1.m_r, 1, 2), mix(color0.m_g, color1.m_g, 1, 2),
+					mix(color0.m_b, color1.m_b, 1, 2), UINT8_MAX };
+				return;
+			}
+
+			p_palette[2] = { mix(color0.m_r, color1.m_r, 1, 1), mix(color0.m_g, color1.m_g, 1, 1),
+				mix(color0.m_b, color1.m_b, 1, 1), UINT8_MAX };
+			p_palette[3] = { 0, 0, 0, 0 };
+		}
+
+		void buildAlphaPalette(const uint8_t p_alpha0, const uint8_t p_alpha1, uint8_t p_palette[8])
+		{
+			p_palette[0] = p_alpha0;
+			p_palette[1] = p_alpha1;
+
+			if (p_alpha0 > p_alpha1)
+			{
+				for (int i = 2; i < 8; i++)
+					p_palette[i] = mix(p_alpha0, p_alpha1, 8 - i, i - 1);
+
+				return;
+			}
+
+			for (int i = 2; i < 6; i++)
+				p_palette[i] = mix(p_alpha0, p_alpha1, 6 - i, i - 1);
+
+			p_palette[6] = 0;
+			p_palette[7] = UINT8_MAX;
+		}
+
+		int squaredDistance(const Color& p_a, const Color& p_b)
+		{
+			const int r = p_a.m_r - p_b.m_r;
+			const int g = p_a.m_g - p_b.m_g;
+			const int b = p_a.m_b - p_b.m_b;
+
+			return r * r + g * g + b * b;
+		}
+	}
+
+	size_t BlockCompression::getBlockByteCount(const ETextureCompression p_compression)
+	{
+		switch (p_compression)
+		{
+		case ETextureCompression::E_BC1:
+			return sizeof(BC1Block);
+		case ETextureCompression::E_BC3:
+			return sizeof(BC3Block);
+		default:
+			throw std::invalid_argument("Uncompressed textures have no blocks");
+		}
+	}
+
+	BC1Block BlockCompression::encodeBC1(const Color p_texels[BLOCK_TEXEL_COUNT])
+	{
+		bool hasTransparency = false;
+
+		for (uint32_t i = 0; i < BLOCK_TEXEL_COUNT; i++)
+			hasTransparency |= p_texels[i].m_a < HALF_ALPHA;
+
+		return encodeColors(p_texels, hasTransparency);
+	}
+
+	BC3Block BlockCompression::encodeBC3(const Color p_texels[BLOCK_TEXEL_COUNT])
+	{
+		BC3Block block {};
+		block.m_color = encodeColors(p_texels, false);
+
+		uint8_t minAlpha = UINT8_MAX;
+		uint8_t maxAlpha = 0;
+
+		for (uint32_t i = 0; i < BLOCK_TEXEL_COUNT; i++)
+		{
+			minAlpha = p_texels[i].m_a < minAlpha ? p_texels[i].m_a : minAlpha;
+			maxAlpha = p_texels[i].m_a > maxAlpha ? p_texels[i].m_a : maxAlpha;
+		}
+
+		block.m_alpha0 = maxAlpha;
+		block.m_alpha1 = minAlpha;
+
+		// A uniform alpha only needs the first index
+		if (maxAlpha == minAlpha)
+			return block;
+
+		uint8_t palette[8];
+		buildAlphaPalette(maxAlpha, minAlpha, palette);
+
+		uint64_t indices = 0;
+
+		for (uint32_t i = 0; i < BLOCK_TEXEL_COUNT; i++)
+		{
+			uint64_t bestIndex = 0;
+			int bestDistance = INT32_MAX;
+
+			for (uint64_t j = 0; j < 8; j++)
+			{
+				const int distance = palette[j] > p_texels[i].m_a ? palette[j] - p_texels[i].m_a : p_texels[i].m_a - palette[j];
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = j;
+				}
+			}
+
+			indices |= bestIndex << (i * 3);
+		}
+
+		for (size_t i = 0; i < sizeof(block.m_alphaIndices); i++)
+			block.m_alphaIndices[i] = static_cast<uint8_t>(indices >> (i * 8));
+
+		return block;
+	}
+
+	void BlockCompression::decodeBC1(const BC1Block& p_block, Color p_texels[BLOCK_TEXEL_COUNT])
+	{
+		decodeColors(p_block, false, p_texels);
+	}
+
+	void BlockCompression::decodeBC3(const BC3Block& p_block, Color p_texels[BLOCK_TEXEL_COUNT])
+	{
+		decodeColors(p_block.m_color, true, p_texels);
+
+		uint8_t palette[8];
+		buildAlphaPalette(p_block.m_alpha0, p_block.m_alpha1, palette);
+
+		uint64_t indices = 0;
+
+		for (size_t i = 0; i < sizeof(p_block.m_alphaIndices); i++)
+			indices |= static_cast<uint64_t>(p_block.m_alphaIndices[i]) << (i * 8);
+
+		for (uint32_t i = 0; i < BLOCK_TEXEL_COUNT; i++)
+			p_texels[i].m_a = palette[indices >> (i * 3) & 7];
+	}
+
+	BC1Block BlockCompression::encodeColors(const Color p_texels[BLOCK_TEXEL_COUNT], const bool p_hasTransparency)
+	{
+		int minColor[3] = { UINT8_MAX, UINT8_MAX, UINT8_MAX };
+		int maxColor[3] = { 0, 0, 0 };
+		bool hasOpaqueTexel = false;
+
+		for (uint32_t i = 0; i < BLOCK_TEXEL_COUNT; i++)
+		{
+			const Color& texel = p_texels[i];
+
+			if (p_hasTransparency && texel.m_a < HALF_ALPHA)
+				continue;
+
+			const int channels[3] = { texel.m_r, texel.m_g, texel.m_b };
+
+			for (int j = 0; j < 3; j++)
+			{
+				minColor[j] = channels[j] < minColor[j] ? channels[j] : minColor[j];
+				maxColor[j] = channels[j] > maxColor[j] ? channels[j] : maxColor[j];
+			}
+
+			hasOpaqueTexel = true;
+		}
+
+		BC1Block block {};
+
+		if (!hasOpaqueTexel)
+		{
+			block.m_indices = UINT32_MAX;
+			return block;
+		}
+
+		// Insetting the box by 1/16th of its size lowers the average error of the interpolated colors
+		for (int j = 0; j < 3; j++)
+		{
+			const int inset = (maxColor[j] - minColor[j]) >> 4;
+			minColor[j] += inset;
+			maxColor[j] -= inset;
+		}
+
+		block.m_color0 = FormatRGB565::fromColor({ static_cast<uint8_t>(maxColor[0]), static_cast<uint8_t>(maxColor[1]),
+			static_cast<uint8_t>(maxColor[2]), UINT8_MAX });
+		block.m_color1 = FormatRGB565::fromColor({ static_cast<uint8_t>(minColor[0]), static_cast<uint8_t>(minColor[1]),
+			static_cast<uint8_t>(minColor[2]), UINT8_MAX });
+
+		// The endpoints' order selects the mode: four colors when the first is greater, three colors and transparency otherwise
+		if ((block.m_color0 < block.m_color1) != p_hasTransparency && block.m_color0 != block.m_color1)
+			std::swap(block.m_color0, block.m_color1);
+
+		Color palette[4];
+		buildPalette(block, !p_hasTransparency, palette);
+
+		const uint32_t colorCount = p_hasTransparency ? 3 : 4;
+
+		for (uint32_t i = 0; i < BLOCK_TEXEL_COUNT; i++)
+		{
+			uint32_t bestIndex = 0;
+
+			if (p_hasTransparency && p_texels[i].m_a < HALF_ALPHA)
+			{
+				bestIndex = TRANSPARENT_INDEX;
+			}
+			else
+			{
+				int bestDistance = INT32_MAX;
+
+				for (uint32_t j = 0; j < colorCount; j++)
+				{
+					const int distance = squaredDistance(p_texels[i], palette[j]);
+
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = j;
+					}
+				}
+			}
+
+			block.m_indices |= bestIndex << (i * 2);
+		}
+
+		return block;
+	}
+
+	void BlockCompression::decodeColors(const BC1Block& p_block, const bool p_isFourColors,
+		Color p_texels[BLOCK_TEXEL_COUNT])
+	{
+		Color palette[4];
+		buildPalette(p_block, p_isFourColors, palette);
+
+		for (uint32_t i = 0; i < BLOCK_TEXEL_COUNT; i++)
+			p_texels[i] = palette[p_block.m_indices >> (i * 2) & 3];
+	}
+}
@@ -0,0 +1,89 @@
+#include "BoundingVolume.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Arithmetic.h"
+
+namespace My
+{
+	BoundingSphere BoundingSphere::transformed(const LibMath::Matrix4& p_transform) const
+	{
+		const LibMath::Vector3 center
+		{
+			p_transform[0] * m_center.m_x + p_transform[1] * m_center.m_y + p_transform[2] * m_center.m_z + p_transform[3],
+			p_transform[4] * m_center.m_x + p_transform[5] * m_center.m_y + p_transform[6] * m_center.m_z + p_transform[7],
+			p_transform[8] * m_center.m_x + p_transform[9] * m_center.m_y + p_transform[10] * m_center.m_z + p_transform[11]
+		};
+
+		// The radius grows with the largest axis scale (see ITransformable::getScale)
+		const float scaleXSquared = p_transform[0] * p_transform[0] + p_transform[4] * p_transform[4]
+			+ p_transform[8] * p_transform[8];
+		const float scaleYSquared = p_transform[1] * p_transform[1] + p_transform[5] * p_transform[5]
+			+ p_transform[9] * p_transform[9];
+		const float scaleZSquared = p_transform[2] * p_transform[2] + p_transform[6] * p_transform[6]
+			+ p_transform[10] * p_transform[10];
+
+		const float maxScale = sqrtf(LibMath::max(scaleXSquared, LibMath::max(scaleYSquared, scaleZSquared)));
+
+		return { center, m_radius * maxScale };
+	}
+
+	AABB AABB::transformed(const LibMath::Matrix4& p_transform) const
+	{
+		/*
+		 * Transforms the center and projects the extents on each axis
+		 * https://www.realtimerendering.com/resources/GraphicsGems/gems/TransBox.c
+		 */
+		const LibMath::Vector3 center = getCenter();
+		const LibMath::Vector3 extents = getExtents();
+
+		LibMath::Vector3 newCenter;
+		LibMath::Vector3 newExtents;
+
+		for (int row = 0; row < 3; row++)
+		{
+			const size_t first = static_cast<size_t>(row) * 4;
+
+			newCenter[row] = p_transform[first] * center.m_x + p_transform[first + 1] * center.m_y
+				+ p_transform[first + 2] * center.m_z + p_transform[first + 3];
+
+			newExtents[row] = LibMath::abs(p_transform[first]) * extents.m_x
+				+ LibMath::abs(p_transform[first + 1]) * extents.m_y
+				+ LibMath::abs(p_transform[first + 2]) * extents.m_z;
+		}
+
+		return { newCenter - newExtents, newCenter + newExtents };
+	}
+
+	LibMath::Vector3 AABB::getCenter() const
+	{
+		return (m_min + m_max) * .5f;
+	}
+
+	LibMath::Vector3 AABB::getExtents() const
+	{
+		return (m_max - m_min) * .5f;
+	}
+
+	float AABB::getSurfaceArea() const
+	{
+		const LibMath::Vector3 size = m_max - m_min;
+		return 2.f * (size.m_x * size.m_y + size.m_y * size.m_z + size.m_z * size.m_x);
+	}
+
+	void AABB::expand(const AABB& p_other)
+	{
+		m_min.m_x = std::min(m_min.m_x, p_other.m_min.m_x);
+		m_min.m_y = std::min(m_min.m_y, p_other.m_min.m_y);
+		m_min.m_z = std::min(m_min.m_z, p_other.m_min.m_z);
+		m_max.m_x = std::max(m_max.m_x, p_other.m_max.m_x);
+		m_max.m_y = std::max(m_max.m_y, p_other.m_max.m_y);
+		m_max.m_z = std::max(m_max.m_z, p_other.m_max.m_z);
+	}
+
+	AABB AABB::empty()
+	{
+		return { LibMath::Vector3(INFINITY), LibMath::Vector3(-INFINITY) };
+	}
+}
@@ -0,0 +1,478 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "Frustum.h"
+
+namespace My
+{
+	namespace
+	{
+		// Vector3's subscript operator isn't inlined across translation units
+		float getComponent(const LibMath::Vector3& p_vector, const int p_axis)
+		{
+			return p_axis == 0 ? p_vector.m_x : p_axis == 1 ? p_vector.m_y : p_vector.m_z;
+		}
+	}
+
+	void BoundingVolumeHierarchy::build(const std::vector<AABB>& p_itemBounds)
+	{
+		clear();
+
+		if (p_itemBounds.empty())
+			return;
+
+		const size_t itemCount = p_itemBounds.size();
+
+		m_itemBounds = p_itemBounds;
+		m_items.resize(itemCount);
+		std::iota(m_items.begin(), m_items.end(), 0u);
+		m_itemLeaves.assign(itemCount, 0);
+		m_isItemUpdated.assign(itemCount, 0);
+
+		std::vector<Vec3> centroids;
+		centroids.reserve(itemCount);
+
+		for (const auto& bounds : m_itemBounds)
+			centroids.push_back(bounds.getCenter());
+
+		m_nodes.reserve(itemCount * 2 - 1);
+		m_parents.reserve(itemCount * 2 - 1);
+
+		m_nodes.push_back({ AABB::empty(), 0, static_cast<uint32_t>(itemCount) });
+		m_parents.push_back(INVALID_NODE);
+		refitNode(0);
+
+		std::vector<uint32_t> pendingNodes{ 0 };
+
+		while (!pendingNodes.empty())
+		{
+			const uint32_t nodeIndex = pendingNodes.back();
+			pendingNodes.pop_back();
+
+			if (splitNode(nodeIndex, centroids))
+			{
+				pendingNodes.push_back(m_nodes[nodeIndex].m_first);
+				pendingNodes.push_back(m_nodes[nodeIndex].m_first + 1);
+				continue;
+			}
+
+			const Node& leaf = m_nodes[nodeIndex];
+
+			for (uint32_t i = leaf.m_first; i < leaf.m_first + leaf.m_count; i++)
+				m_itemLeaves[m_items[i]] = nodeIndex;
+		}
+
+		m_cost = m_buildCost = computeCost();
+	}
+
+	void BoundingVolumeHierarchy::clear()
+	{
+		m_nodes.clear();
+		m_parents.clear();
+		m_items.clear();
+		m_itemLeaves.clear();
+		m_itemBounds.clear();
+		m_updatedItems.clear();
+		m_isItemUpdated.clear();
+		m_buildCost = 0.f;
+		m_cost = 0.f;
+	}
+
+	size_t BoundingVolumeHierarchy::getItemCount() const
+	{
+		return m_itemBounds.size();
+	}
+
+	const AABB& BoundingVolumeHierarchy::getItemBounds(const size_t p_item) const
+	{
+		return m_itemBounds[p_item];
+	}
+
+	void BoundingVolumeHierarchy::updateItem(const size_t p_item, const AABB& p_bounds)
+	{
+		m_itemBounds[p_item] = p_bounds;
+
+		if (m_isItemUpdated[p_item])
+			return;
+
+		m_isItemUpdated[p_item] = 1;
+		m_updatedItems.push_back(static_cast<uint32_t>(p_item));
+	}
+
+	bool BoundingVolumeHierarchy::needsRefit() const
+	{
+		return !m_updatedItems.empty();
+	}
+
+	void BoundingVolumeHierarchy::refit()
+	{
+		if (m_updatedItems.empty())
+			return;
+
+		// Walking up from each leaf costs more than a full bottom-up pass once enough items moved
+		if (m_updatedItems.size() * 8 > m_itemBounds.size())
+		{
+			// Children are always stored after their parent
+			for (size_t i = m_nodes.size(); i-- > 0;)
+				refitNode(static_cast<uint32_t>(i));
+		}
+		else
+		{
+			for (const uint32_t item : m_updatedItems)
+			{
+				for (uint32_t node = m_itemLeaves[item]; node != INVALID_NODE; node = m_parents[node])
+					refitNode(node);
+			}
+		}
+
+		for (const uint32_t item : m_updatedItems)
+			m_isItemUpdated[item] = 0;
+
+		m_updatedItems.clear();
+
+		m_cost = computeCost();
+
+		if (m_cost > m_buildCost * REBUILD_THRESHOLD)
+		{
+			const std::vector<AABB> itemBounds = m_itemBounds;
+			build(itemBounds);
+		}
+	}
+
+	void BoundingVolumeHierarchy::queryFrustum(const Frustum& p_frustum, std::vector<size_t>& p_items) const
+	{
+		if (m_nodes.empty())
+			return;
+
+		std::vector<uint32_t> pendingNodes{ 0 };
+
+		while (!pendingNodes.empty())
+		{
+			const Node& node = m_nodes[pendingNodes.back()];
+			pendingNodes.pop_back();
+
+			if (!p_frustum.intersects(node.m_bounds))
+				continue;
+
+			if (p_frustum.contains(node.m_bounds))
+			{
+				// The items of a sub-tree are contiguous - find its first and last leaves
+				const Node* firstLeaf = &node;
+				const Node* lastLeaf = &node;
+
+				while (firstLeaf->m_count == 0)
+					firstLeaf = &m_nodes[firstLeaf->m_first];
+
+				while (lastLeaf->m_count == 0)
+					lastLeaf = &m_nodes[lastLeaf->m_first + 1];
+
+				for (uint32_t i = firstLeaf->m_first; i < lastLeaf->m_first + lastLeaf->m_count; i++)
+					p_items.push_back(m_items[i]);
+
+				continue;
+			}
+
+			if (node.m_count == 0)
+			{
+				pendingNodes.push_back(node.m_first);
+				pendingNodes.push_back(node.m_first + 1);
+				continue;
+			}
+
+			for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+			{
+				if (p_frustum.intersects(m_itemBounds[m_items[i]]))
+					p_items.push_back(m_items[i]);
+			}
+		}
+	}
+
+	bool BoundingVolumeHierarchy::raycast(const Vec3& p_origin, const Vec3& p_direction,
+		size_t& p_item, float& p_distance) const
+	{
+		if (m_nodes.empty())
+			return false;
+
+		const Vec3 invDirection(1.f / p_direction.m_x, 1.f / p_direction.m_y, 1.f / p_direction.m_z);
+
+		float closestDistance = intersectRay(m_nodes[0].m_bounds, p_origin, invDirection, INFINITY);
+		uint32_t closestItem = INVALID_NODE;
+
+		if (closestDistance == INFINITY)
+			return false;
+
+		std::vector<std::pair<uint32_t, float>> pendingNodes{ { 0, closestDistance } };
+		closestDistance = INFINITY;
+
+		while (!pendingNodes.empty())
+		{
+			const uint32_t nodeIndex = pendingNodes.back().first;
+			const float entryDistance = pendingNodes.back().second;
+			pendingNodes.pop_back();
+
+			if (entryDistance >= closestDistance)
+				continue;
+
+			const Node& node = m_nodes[nodeIndex];
+
+			if (node.m_count != 0)
+			{
+				for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+				{
+					const float distance = intersectRay(m_itemBounds[m_items[i]], p_origin,
+						invDirection, closestDistance);
+
+					if (distance < closestDistance)
+					{
+						closestDistance = distance;
+						closestItem = m_items[i];
+					}
+				}
+
+				continue;
+			}
+
+			uint32_t nearChild = node.m_first;
+			uint32_t farChild = node.m_first + 1;
+
+			float nearDistance = intersectRay(m_nodes[nearChild].m_bounds, p_origin, invDirection, closestDistance);
+			float farDistance = intersectRay(m_nodes[farChild].m_bounds, p_origin, invDirection, closestDistance);
+
+			if (farDistance < nearDistance)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearDistance, farDistance);
+			}
+
+			// Push the far child first so the near one is visited first
+			if (farDistance != INFINITY)
+				pendingNodes.emplace_back(farChild, farDistance);
+
+			if (nearDistance != INFINITY)
+				pendingNodes.emplace_back(nearChild, nearDistance);
+		}
+
+		if (closestItem == INVALID_NODE)
+			return false;
+
+		p_item = closestItem;
+		p_distance = closestDistance;
+
+		return true;
+	}
+
+	void BoundingVolumeHierarchy::traverse(const NodeFilter& p_nodeFilter, const ItemVisitor& p_itemVisitor) const
+	{
+		if (m_nodes.empty())
+			return;
+
+		std::vector<uint32_t> pendingNodes{ 0 };
+
+		while (!pendingNodes.empty())
+		{
+			const Node& node = m_nodes[pendingNodes.back()];
+			pendingNodes.pop_back();
+
+			if (!p_nodeFilter(node.m_bounds))
+				continue;
+
+			if (node.m_count == 0)
+			{
+				pendingNodes.push_back(node.m_first);
+				pendingNodes.push_back(node.m_first + 1);
+				continue;
+			}
+
+			for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+			{
+				if (p_nodeFilter(m_itemBounds[m_items[i]]))
+					p_itemVisitor(m_items[i]);
+			}
+		}
+	}
+
+	float BoundingVolumeHierarchy::getCost() const
+	{
+		return m_cost;
+	}
+
+	bool BoundingVolumeHierarchy::splitNode(const uint32_t p_nodeIndex, const std::vector<Vec3>& p_centroids)
+	{
+		// Copy what we need since adding the children can reallocate the node buffer
+		const uint32_t first = m_nodes[p_nodeIndex].m_first;
+		const uint32_t count = m_nodes[p_nodeIndex].m_count;
+		const float parentArea = m_nodes[p_nodeIndex].m_bounds.getSurfaceArea();
+
+		if (count <= 1)
+			return false;
+
+		AABB centroidBounds = AABB::empty();
+
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const Vec3& centroid = p_centroids[m_items[i]];
+			centroidBounds.expand({ centroid, centroid });
+		}
+
+		const Vec3 centroidExtents = centroidBounds.m_max - centroidBounds.m_min;
+
+		int axis = 0;
+
+		if (centroidExtents.m_y > getComponent(centroidExtents, axis))
+			axis = 1;
+
+		if (centroidExtents.m_z > getComponent(centroidExtents, axis))
+			axis = 2;
+
+		// Every centroid is at the same spot - there's nothing to split
+		if (getComponent(centroidExtents, axis) <= 0.f)
+			return false;
+
+		const float binScale = static_cast<float>(BIN_COUNT) / getComponent(centroidExtents, axis);
+		const float binOrigin = getComponent(centroidBounds.m_min, axis);
+
+		const auto getBin = [&](const uint32_t p_item)
+		{
+			const size_t bin = static_cast<size_t>((getComponent(p_centroids[p_item], axis) - binOrigin) * binScale);
+			return std::min(bin, BIN_COUNT - 1);
+		};
+
+		AABB binBounds[BIN_COUNT];
+		uint32_t binCounts[BIN_COUNT] = {};
+
+		std::fill(std::begin(binBounds), std::end(binBounds), AABB::empty());
+
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const size_t bin = getBin(m_items[i]);
+			binBounds[bin].expand(m_itemBounds[m_items[i]]);
+			binCounts[bin]++;
+		}
+
+		// Sweep from both ends to get the cost of each split plane
+		AABB leftBounds[BIN_COUNT - 1];
+		AABB rightBounds[BIN_COUNT - 1];
+		uint32_t leftCounts[BIN_COUNT - 1];
+		uint32_t rightCounts[BIN_COUNT - 1];
+
+		AABB leftAccumulator = AABB::empty();
+		AABB rightAccumulator = AABB::empty();
+		uint32_t leftCount = 0;
+		uint32_t rightCount = 0;
+
+		for (size_t i = 0; i < BIN_COUNT - 1; i++)
+		{
+			leftAccumulator.expand(binBounds[i]);
+			leftCount += binCounts[i];
+			leftBounds[i] = leftAccumulator;
+			leftCounts[i] = leftCount;
+
+			rightAccumulator.expand(binBounds[BIN_COUNT - 1 - i]);
+			rightCount += binCounts[BIN_COUNT - 1 - i];
+			rightBounds[BIN_COUNT - 2 - i] = rightAccumulator;
+			rightCounts[BIN_COUNT - 2 - i] = rightCount;
+		}
+
+		size_t bestSplit = BIN_COUNT;
+		float bestCost = INFINITY;
+
+		for (size_t i = 0; i < BIN_COUNT - 1; i++)
+		{
+			if (leftCounts[i] == 0 || rightCounts[i] == 0)
+				continue;
+
+			const float cost = leftBounds[i].getSurfaceArea() * static_cast<float>(leftCounts[i])
+				+ rightBounds[i].getSurfaceArea() * static_cast<float>(rightCounts[i]);
+
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		if (bestSplit == BIN_COUNT)
+			return false;
+
+		// Traversing a node costs about as much as testing an item, both scaled by the hit probability
+		const bool isSplitWorthIt = parentArea + bestCost < parentArea * static_cast<float>(count);
+
+		if (!isSplitWorthIt && count <= MAX_LEAF_SIZE)
+			return false;
+
+		const auto middle = std::partition(m_items.begin() + first, m_items.begin() + first + count,
+			[&](const uint32_t p_item) { return getBin(p_item) <= bestSplit; });
+
+		const uint32_t splitCount = static_cast<uint32_t>(middle - (m_items.begin() + first));
+		const uint32_t leftChild = static_cast<uint32_t>(m_nodes.size());
+
+		m_nodes.push_back({ leftBounds[bestSplit], first, splitCount });
+		m_nodes.push_back({ rightBounds[bestSplit], first + splitCount, count - splitCount });
+		m_parents.push_back(p_nodeIndex);
+		m_parents.push_back(p_nodeIndex);
+
+		m_nodes[p_nodeIndex].m_first = leftChild;
+		m_nodes[p_nodeIndex].m_count = 0;
+
+		return true;
+	}
+
+	void BoundingVolumeHierarchy::refitNode(const uint32_t p_nodeIndex)
+	{
+		Node& node = m_nodes[p_nodeIndex];
+
+		if (node.m_count == 0)
+		{
+			node.m_bounds = m_nodes[node.m_first].m_bounds;
+			node.m_bounds.expand(m_nodes[node.m_first + 1].m_bounds);
+			return;
+		}
+
+		node.m_bounds = AABB::empty();
+
+		for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+			node.m_bounds.expand(m_itemBounds[m_items[i]]);
+	}
+
+	float BoundingVolumeHierarchy::computeCost() const
+	{
+		if (m_nodes.empty())
+			return 0.f;
+
+		float cost = 0.f;
+
+		for (const auto& node : m_nodes)
+		{
+			const float count = node.m_count == 0 ? 1.f : static_cast<float>(node.m_count);
+			cost += node.m_bounds.getSurfaceArea() * count;
+		}
+
+		const float rootArea = m_nodes[0].m_bounds.getSurfaceArea();
+
+		return rootArea > 0.f ? cost / rootArea : 0.f;
+	}
+
+	float BoundingVolumeHierarchy::intersectRay(const AABB& p_bounds, const Vec3& p_origin,
+		const Vec3& p_invDirection, const float p_maxDistance)
+	{
+		// Slab test - https://tavianator.com/2011/ray_box.html
+		float entry = 0.f;
+		float exit = p_maxDistance;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float origin = getComponent(p_origin, axis);
+			const float invDirection = getComponent(p_invDirection, axis);
+			const float minDistance = (getComponent(p_bounds.m_min, axis) - origin) * invDirection;
+			const float maxDistance = (getComponent(p_bounds.m_max, axis) - origin) * invDirection;
+
+			entry = std::max(entry, std::min(minDistance, maxDistance));
+			exit = std::min(exit, std::max(minDistance, maxDistance));
+		}
+
+		return entry <= exit ? entry : INFINITY;
+	}
+}
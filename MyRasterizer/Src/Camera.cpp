@@ -31,4 +31,9 @@ namespace My
 	{
 		return getTransform().inverse();
 	}
+
+	Frustum Camera::getFrustum() const
+	{
+		return Frustum(m_projectionMatrix * getViewMatrix());
+	}
 }
@@ -4,6 +4,7 @@
 
 #include "Arithmetic.h"
 #include "Mesh.h"
+#include "Scene.h"
 
 My::Entity::Entity(const Mesh& p_mesh, const Mat4& p_transform) :
 	ITransformable(p_transform), m_mesh(&p_mesh), m_transparency(1.0f)
@@ -17,6 +18,16 @@ My::Entity::Entity(const Mesh& p_mesh, const float p_transparency, const Mat4& p
 {
 }
 
+My::Entity::Entity(const Entity& p_other) :
+	ITransformable(p_other), m_mesh(p_other.m_mesh), m_transparency(p_other.m_transparency)
+{
+}
+
+My::Entity::Entity(Entity&& p_other) :
+	ITransformable(std::move(p_other)), m_mesh(p_other.m_mesh), m_transparency(p_other.m_transparency)
+{
+}
+
 const My::Mesh* My::Entity::getMesh() const
 {
 	return m_mesh;
@@ -32,8 +43,65 @@ bool My::Entity::isOpaque() const
 	if (!LibMath::floatEquals(m_transparency, 1.f))
 		return false;
 
-	const auto vertices = m_mesh->getVertices();
+	const auto isTransparent = [](const auto& p_vertex) { return p_vertex.m_color.m_a != UINT8_MAX; };
+
+	if (m_mesh->hasCompressedVertices())
+	{
+		const auto& packedVertices = m_mesh->getPackedVertices();
+		return !std::all_of(packedVertices.begin(), packedVertices.end(), isTransparent);
+	}
+
+	if (m_mesh->getVertexLayout() == EVertexLayout::E_SEPARATE)
+	{
+		const StreamView<Color> colors = m_mesh->getVertexStreams().getColors();
+		return !std::all_of(colors.begin(), colors.end(), [](const Color& p_color) { return p_color.m_a != UINT8_MAX; });
+	}
+
+	const auto& vertices = m_mesh->getVertices();
+
+	return !std::all_of(vertices.begin(), vertices.end(), isTransparent);
+}
+
+My::AABB My::Entity::getBoundingBox() const
+{
+	return m_mesh->getBoundingBox().transformed(getTransform());
+}
+
+My::BoundingSphere My::Entity::getBoundingSphere() const
+{
+	return m_mesh->getBoundingSphere().transformed(getTransform());
+}
+
+My::Entity& My::Entity::operator=(const Entity& p_other)
+{
+	if (&p_other == this)
+		return *this;
+
+	ITransformable::operator=(p_other);
+	m_mesh = p_other.m_mesh;
+	m_transparency = p_other.m_transparency;
+
+	onTransformChanged();
+
+	return *this;
+}
 
-	return !std::all_of(vertices.begin(), vertices.end(),
-		[](const Vertex& vertex) { return vertex.m_color.m_a != UINT8_MAX; });
+My::Entity& My::Entity::operator=(Entity&& p_other)
+{
+	if (&p_other == this)
+		return *this;
+
+	ITransformable::operator=(std::move(p_other));
+	m_mesh = p_other.m_mesh;
+	m_transparency = p_other.m_transparency;
+
+	onTransformChanged();
+
+	return *this;
+}
+
+void My::Entity::onTransformChanged()
+{
+	if (m_scene != nullptr)
+		m_scene->onEntityTransformChanged(m_sceneIndex);
 }
@@ -0,0 +1,122 @@
+#include "Frustum.h"
+
+#include <cmath>
+#include <emmintrin.h>
+
+#include "Arithmetic.h"
+
+namespace My
+{
+	Frustum::Frustum(const LibMath::Matrix4& p_viewProjection)
+	{
+		/*
+		 * Gribb & Hartmann plane extraction - a point is inside when -w <= x, y, z <= w in clip space
+		 * https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+		 */
+		static constexpr int SIGNED_ROWS[PLANE_COUNT][2] =
+		{
+			{ 0, 1 }, { 0, -1 },	// Left, right
+			{ 1, 1 }, { 1, -1 },	// Bottom, top
+			{ 2, 1 }, { 2, -1 }		// Near, far
+		};
+
+		for (size_t i = 0; i < PLANE_COUNT; i++)
+		{
+			const size_t row = static_cast<size_t>(SIGNED_ROWS[i][0]) * 4;
+			const float sign = static_cast<float>(SIGNED_ROWS[i][1]);
+
+			const float x = p_viewProjection[12] + sign * p_viewProjection[row];
+			const float y = p_viewProjection[13] + sign * p_viewProjection[row + 1];
+			const float z = p_viewProjection[14] + sign * p_viewProjection[row + 2];
+			const float w = p_viewProjection[15] + sign * p_viewProjection[row + 3];
+
+			const float length = sqrtf(x * x + y * y + z * z);
+			const float invLength = length > 0.f ? 1.f / length : 0.f;
+
+			m_normalX[i] = x * invLength;
+			m_normalY[i] = y * invLength;
+			m_normalZ[i] = z * invLength;
+			m_distance[i] = w * invLength;
+		}
+	}
+
+	bool Frustum::intersects(const BoundingSphere& p_sphere) const
+	{
+		const __m128 centerX = _mm_set1_ps(p_sphere.m_center.m_x);
+		const __m128 centerY = _mm_set1_ps(p_sphere.m_center.m_y);
+		const __m128 centerZ = _mm_set1_ps(p_sphere.m_center.m_z);
+		const __m128 negRadius = _mm_set1_ps(-p_sphere.m_radius);
+
+		int outsideMask = 0;
+
+		for (size_t i = 0; i < PADDED_PLANE_COUNT; i += 4)
+		{
+			__m128 distance = _mm_load_ps(m_distance + i);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(m_normalX + i), centerX));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(m_normalY + i), centerY));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(m_normalZ + i), centerZ));
+
+			outsideMask |= _mm_movemask_ps(_mm_cmplt_ps(distance, negRadius));
+		}
+
+		return outsideMask == 0;
+	}
+
+	bool Frustum::intersects(const AABB& p_box) const
+	{
+		const __m128 minX = _mm_set1_ps(p_box.m_min.m_x);
+		const __m128 minY = _mm_set1_ps(p_box.m_min.m_y);
+		const __m128 minZ = _mm_set1_ps(p_box.m_min.m_z);
+		const __m128 maxX = _mm_set1_ps(p_box.m_max.m_x);
+		const __m128 maxY = _mm_set1_ps(p_box.m_max.m_y);
+		const __m128 maxZ = _mm_set1_ps(p_box.m_max.m_z);
+
+		int outsideMask = 0;
+
+		for (size_t i = 0; i < PADDED_PLANE_COUNT; i += 4)
+		{
+			const __m128 normalX = _mm_load_ps(m_normalX + i);
+			const __m128 normalY = _mm_load_ps(m_normalY + i);
+			const __m128 normalZ = _mm_load_ps(m_normalZ + i);
+
+			// Distance of the corner furthest along each plane's normal
+			__m128 distance = _mm_load_ps(m_distance + i);
+			distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(normalX, minX), _mm_mul_ps(normalX, maxX)));
+			distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(normalY, minY), _mm_mul_ps(normalY, maxY)));
+			distance = _mm_add_ps(distance, _mm_max_ps(_mm_mul_ps(normalZ, minZ), _mm_mul_ps(normalZ, maxZ)));
+
+			outsideMask |= _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+
+		return outsideMask == 0;
+	}
+
+	bool Frustum::contains(const AABB& p_box) const
+	{
+		const __m128 minX = _mm_set1_ps(p_box.m_min.m_x);
+		const __m128 minY = _mm_set1_ps(p_box.m_min.m_y);
+		const __m128 minZ = _mm_set1_ps(p_box.m_min.m_z);
+		const __m128 maxX = _mm_set1_ps(p_box.m_max.m_x);
+		const __m128 maxY = _mm_set1_ps(p_box.m_max.m_y);
+		const __m128 maxZ = _mm_set1_ps(p_box.m_max.m_z);
+
+		int outsideMask = 0;
+
+		for (size_t i = 0; i < PADDED_PLANE_COUNT; i += 4)
+		{
+			const __m128 normalX = _mm_load_ps(m_normalX + i);
+			const __m128 normalY = _mm_load_ps(m_normalY + i);
+			const __m128 normalZ = _mm_load_ps(m_normalZ + i);
+
+			// Distance of the corner furthest against each plane's normal
+			__m128 distance = _mm_load_ps(m_distance + i);
+			distance = _mm_add_ps(distance, _mm_min_ps(_mm_mul_ps(normalX, minX), _mm_mul_ps(normalX, maxX)));
+			distance = _mm_add_ps(distance, _mm_min_ps(_mm_mul_ps(normalY, minY), _mm_mul_ps(normalY, maxY)));
+			distance = _mm_add_ps(distance, _mm_min_ps(_mm_mul_ps(normalZ, minZ), _mm_mul_ps(normalZ, maxZ)));
+
+			outsideMask |= _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+
+		return outsideMask == 0;
+	}
+}
@@ -17,11 +17,13 @@ namespace My
 	void ITransformable::setTransform(const Mat4& p_transform)
 	{
 		m_transform = p_transform;
+		onTransformChanged();
 	}
 
 	ITransformable& ITransformable::translate(const float p_x, const float p_y, const float p_z)
 	{
 		this->m_transform *= Mat4::translation(p_x, p_y, p_z);
+		onTransformChanged();
 		return *this;
 	}
 
@@ -34,6 +36,7 @@ namespace My
 	ITransformable& ITransformable::scale(const float p_x, const float p_y, const float p_z)
 	{
 		this->m_transform *= Mat4::scaling(p_x, p_y, p_z);
+		onTransformChanged();
 		return *this;
 	}
 
@@ -42,6 +45,7 @@ namespace My
 		this->m_transform *= Mat4::rotation(p_x, Vec3::right());	//rotate x axis
 		this->m_transform *= Mat4::rotation(p_y, Vec3::up());		//rotate y axis
 		this->m_transform *= Mat4::rotation(p_z, Vec3::back());		//rotate z axis
+		onTransformChanged();
 		return *this;
 	}
 
@@ -262,4 +266,8 @@ namespace My
 	{
 		return -this->getForward();
 	}
+
+	void ITransformable::onTransformChanged()
+	{
+	}
 }
@@ -0,0 +1,78 @@
+#include "IndexBuffer.h"
+
+#include <utility>
+
+namespace My
+{
+	IndexBuffer::IndexBuffer(const std::vector<size_t>& p_indices, const size_t p_vertexCount) :
+		m_type(p_vertexCount <= UINT16_MAX + 1 ? EIndexType::E_UINT16 : EIndexType::E_UINT32)
+	{
+		if (m_type == EIndexType::E_UINT16)
+		{
+			m_indices16.reserve(p_indices.size());
+
+			for (const size_t index : p_indices)
+				m_indices16.push_back(static_cast<uint16_t>(index));
+		}
+		else
+		{
+			m_indices32.reserve(p_indices.size());
+
+			for (const size_t index : p_indices)
+				m_indices32.push_back(static_cast<uint32_t>(index));
+		}
+	}
+
+	IndexBuffer::IndexBuffer(std::vector<uint32_t>&& p_indices, const size_t p_vertexCount) :
+		m_type(p_vertexCount <= UINT16_MAX + 1 ? EIndexType::E_UINT16 : EIndexType::E_UINT32)
+	{
+		if (m_type == EIndexType::E_UINT32)
+		{
+			m_indices32 = std::move(p_indices);
+			return;
+		}
+
+		m_indices16.reserve(p_indices.size());
+
+		for (const uint32_t index : p_indices)
+			m_indices16.push_back(static_cast<uint16_t>(index));
+	}
+
+	IndexBuffer::IndexBuffer(const EIndexType p_type, const void* p_indices, const size_t p_count) :
+		m_externalIndices(p_count == 0 ? nullptr : p_indices), m_externalCount(p_count), m_type(p_type)
+	{
+	}
+
+	EIndexType IndexBuffer::getType() const
+	{
+		return m_type;
+	}
+
+	size_t IndexBuffer::size() const
+	{
+		if (m_externalIndices != nullptr)
+			return m_externalCount;
+
+		return m_type == EIndexType::E_UINT16 ? m_indices16.size() : m_indices32.size();
+	}
+
+	bool IndexBuffer::empty() const
+	{
+		return size() == 0;
+	}
+
+	size_t IndexBuffer::operator[](const size_t p_position) const
+	{
+		return visit([p_position](const auto* p_indices) { return static_cast<size_t>(p_indices[p_position]); });
+	}
+
+	std::vector<size_t> IndexBuffer::toVector() const
+	{
+		return visit([this](const auto* p_indices) { return std::vector<size_t>(p_indices, p_indices + size()); });
+	}
+
+	bool IndexBuffer::isExternal() const
+	{
+		return m_externalIndices != nullptr;
+	}
+}
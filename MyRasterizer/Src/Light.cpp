@@ -19,6 +19,21 @@ My::Light::Light(const Vec3& p_position, const float p_ambientComponent,
 {
 }
 
+const LibMath::Vector3& My::Light::getPosition() const
+{
+	return m_position;
+}
+
+LibMath::Vector3 My::Light::getComponents() const
+{
+	return { m_ambientComponent, m_diffuseComponent, m_specularComponent };
+}
+
+const LibMath::Vector3& My::Light::getIntensity() const
+{
+	return m_intensity;
+}
+
 My::Color My::Light::calculateLightingPhong(const Vertex& p_vertex, const Vec3& p_observer,
                                             const size_t p_shininess) const
 {
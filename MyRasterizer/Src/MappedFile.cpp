@@ -0,0 +1,168 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace My
+{
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& p_path, const bool p_isCopyOnWrite) :
+		m_isCopyOnWrite(p_isCopyOnWrite)
+	{
+		HANDLE file = CreateFileA(p_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("Unable to open file: " + p_path);
+
+		m_file = file;
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file, &size))
+		{
+			close();
+			throw std::runtime_error("Unable to get the size of file: " + p_path);
+		}
+
+		m_size = static_cast<size_t>(size.QuadPart);
+
+		// Empty files can't be mapped
+		if (m_size == 0)
+			return;
+
+		m_mapping = CreateFileMappingA(file, nullptr, p_isCopyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+		m_data = m_mapping == nullptr ? nullptr : static_cast<char*>(MapViewOfFile(m_mapping,
+			p_isCopyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+
+		if (m_data == nullptr)
+		{
+			close();
+			throw std::runtime_error("Unable to map file: " + p_path);
+		}
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+
+		if (m_file != nullptr)
+			CloseHandle(m_file);
+
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = nullptr;
+		m_size = 0;
+	}
+#else
+	MappedFile::MappedFile(const std::string& p_path, const bool p_isCopyOnWrite) :
+		m_isCopyOnWrite(p_isCopyOnWrite)
+	{
+		m_file = open(p_path.c_str(), O_RDONLY);
+
+		if (m_file < 0)
+			throw std::runtime_error("Unable to open file: " + p_path);
+
+		struct stat status;
+
+		if (fstat(m_file, &status) != 0)
+		{
+			close();
+			throw std::runtime_error("Unable to get the size of file: " + p_path);
+		}
+
+		m_size = static_cast<size_t>(status.st_size);
+
+		// Empty files can't be mapped
+		if (m_size == 0)
+			return;
+
+		const int protection = p_isCopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+		void* data = mmap(nullptr, m_size, protection, MAP_PRIVATE, m_file, 0);
+
+		if (data == MAP_FAILED)
+		{
+			close();
+			throw std::runtime_error("Unable to map file: " + p_path);
+		}
+
+		m_data = static_cast<char*>(data);
+		madvise(data, m_size, MADV_SEQUENTIAL);
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data != nullptr)
+			munmap(m_data, m_size);
+
+		if (m_file >= 0)
+			::close(m_file);
+
+		m_data = nullptr;
+		m_file = -1;
+		m_size = 0;
+	}
+#endif
+
+	MappedFile::MappedFile(MappedFile&& p_other) noexcept
+	{
+		*this = std::move(p_other);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& p_other) noexcept
+	{
+		if (this == &p_other)
+			return *this;
+
+		close();
+
+		std::swap(m_data, p_other.m_data);
+		std::swap(m_size, p_other.m_size);
+		std::swap(m_isCopyOnWrite, p_other.m_isCopyOnWrite);
+		std::swap(m_file, p_other.m_file);
+
+#ifdef _WIN32
+		std::swap(m_mapping, p_other.m_mapping);
+#endif
+
+		return *this;
+	}
+
+	const char* MappedFile::getData() const
+	{
+		return m_data;
+	}
+
+	char* MappedFile::getWritableData()
+	{
+		if (!m_isCopyOnWrite)
+			throw std::logic_error("The file isn't mapped copy-on-write");
+
+		return m_data;
+	}
+
+	size_t MappedFile::getSize() const
+	{
+		return m_size;
+	}
+}
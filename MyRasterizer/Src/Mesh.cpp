@@ -1,10 +1,14 @@
 #include "Mesh.h"
 
-#include <numeric>
-#include <set>
-#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 
+#include "Arithmetic.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include "Texture.h"
+#include "ThreadPool.h"
 #include "Trigonometry.h"
 #include "Vector/Vector3.h"
 
@@ -22,25 +26,204 @@ My::Mesh::Mesh(const std::vector<Vertex>& p_vertices,
 				"] is not part of the vertex buffer");
 
 	this->m_vertices = p_vertices;
-	this->m_indices = p_indices;
+	this->m_indices = IndexBuffer(p_indices, p_vertices.size());
 	this->m_texture = p_texture;
 
 	this->calculateTriangleNormals();
+	this->calculateBounds();
 }
 
-std::vector<My::Vertex> My::Mesh::getVertices() const
+My::Mesh::Mesh(std::vector<Vertex>&& p_vertices, IndexBuffer&& p_indices, const Texture* p_texture)
 {
-	return m_vertices;
+	// Make sure the index buffer is a set of triangles
+	if (p_indices.size() % 3 != 0)
+		throw Exceptions::InvalidIndexBuffer();
+
+	// Make sure the received indices are valid
+	p_indices.visit([&](const auto* p_data)
+	{
+		for (size_t i = 0; i < p_indices.size(); i++)
+			if (p_data[i] >= p_vertices.size())
+				throw Exceptions::InvalidIndexBuffer("Index [" + std::to_string(p_data[i]) +
+					"] is not part of the vertex buffer");
+	});
+
+	this->m_vertices = std::move(p_vertices);
+	this->m_indices = std::move(p_indices);
+	this->m_texture = p_texture;
+
+	this->calculateTriangleNormals();
+	this->calculateBounds();
+}
+
+My::Mesh::Mesh(const StreamView<Vertex> p_vertices, const IndexBuffer& p_indices, const StreamView<Vec3> p_normals,
+	const AABB& p_boundingBox, const BoundingSphere& p_boundingSphere, const Texture* p_texture) :
+	m_indices(p_indices), m_externalVertices(p_vertices), m_externalNormals(p_normals), m_hasExternalBuffers(true),
+	m_texture(p_texture), m_boundingBox(p_boundingBox), m_boundingSphere(p_boundingSphere)
+{
+	// Make sure the index buffer is a set of triangles with a normal each
+	if (p_indices.size() % 3 != 0 || p_normals.size() != p_indices.size() / 3)
+		throw Exceptions::InvalidIndexBuffer();
+}
+
+My::StreamView<My::Vertex> My::Mesh::getVertices() const
+{
+	if (m_hasExternalBuffers)
+		return m_externalVertices;
+
+	return { m_vertices.data(), m_vertices.size() };
+}
+
+const std::vector<My::PackedVertex>& My::Mesh::getPackedVertices() const
+{
+	return m_packedVertices;
+}
+
+const My::VertexStreams& My::Mesh::getVertexStreams() const
+{
+	return m_vertexStreams;
+}
+
+My::EVertexLayout My::Mesh::getVertexLayout() const
+{
+	return m_vertexStreams.empty() ? EVertexLayout::E_INTERLEAVED : EVertexLayout::E_SEPARATE;
+}
+
+void My::Mesh::setVertexLayout(const EVertexLayout p_layout)
+{
+	if (p_layout == EVertexLayout::E_SEPARATE)
+		splitVertices();
+	else
+		interleaveVertices();
+
+	for (Mesh& lod : m_lods)
+		lod.setVertexLayout(p_layout);
+}
+
+const My::VertexQuantization& My::Mesh::getVertexQuantization() const
+{
+	return m_quantization;
+}
+
+size_t My::Mesh::getVertexCount() const
+{
+	if (hasCompressedVertices())
+		return m_packedVertices.size();
+
+	if (m_hasExternalBuffers)
+		return m_externalVertices.size();
+
+	return getVertexLayout() == EVertexLayout::E_SEPARATE ? m_vertexStreams.size() : m_vertices.size();
+}
+
+std::vector<My::Vertex> My::Mesh::decodeVertices() const
+{
+	if (getVertexLayout() == EVertexLayout::E_SEPARATE)
+		return m_vertexStreams.toVertices();
+
+	if (m_hasExternalBuffers)
+		return { m_externalVertices.begin(), m_externalVertices.end() };
+
+	if (!hasCompressedVertices())
+		return m_vertices;
+
+	std::vector<Vertex> vertices;
+	vertices.reserve(m_packedVertices.size());
+
+	for (const PackedVertex& vertex : m_packedVertices)
+		vertices.push_back(m_quantization.decode(vertex));
+
+	return vertices;
+}
+
+bool My::Mesh::hasCompressedVertices() const
+{
+	return !m_packedVertices.empty();
 }
 
-std::vector<size_t> My::Mesh::getIndices() const
+void My::Mesh::compressVertices()
+{
+	packVertices();
+
+	for (Mesh& lod : m_lods)
+		lod.packVertices();
+}
+
+void My::Mesh::decompressVertices()
+{
+	unpackVertices();
+
+	for (Mesh& lod : m_lods)
+		lod.unpackVertices();
+}
+
+const My::IndexBuffer& My::Mesh::getIndices() const
 {
 	return m_indices;
 }
 
-std::vector<LibMath::Vector3> My::Mesh::getNormals() const
+My::StreamView<LibMath::Vector3> My::Mesh::getNormals() const
+{
+	if (m_hasExternalBuffers)
+		return m_externalNormals;
+
+	return { this->m_normals.data(), this->m_normals.size() };
+}
+
+bool My::Mesh::hasExternalBuffers() const
+{
+	return m_hasExternalBuffers;
+}
+
+void My::Mesh::copyExternalBuffers()
+{
+	if (!m_hasExternalBuffers)
+		return;
+
+	m_vertices.assign(m_externalVertices.begin(), m_externalVertices.end());
+	m_normals.assign(m_externalNormals.begin(), m_externalNormals.end());
+	m_indices = IndexBuffer(m_indices.toVector(), m_vertices.size());
+
+	m_externalVertices = {};
+	m_externalNormals = {};
+	m_hasExternalBuffers = false;
+}
+
+void My::Mesh::optimize(const float p_overdrawThreshold)
 {
-	return this->m_normals;
+	copyExternalBuffers();
+
+	// Reordering packed vertices would need the same work on another vertex type
+	if (hasCompressedVertices())
+	{
+		decompressVertices();
+		optimize(p_overdrawThreshold);
+		compressVertices();
+		return;
+	}
+
+	if (getVertexLayout() == EVertexLayout::E_SEPARATE)
+	{
+		setVertexLayout(EVertexLayout::E_INTERLEAVED);
+		optimize(p_overdrawThreshold);
+		setVertexLayout(EVertexLayout::E_SEPARATE);
+		return;
+	}
+
+	std::vector<size_t> indices = m_indices.toVector();
+
+	MeshOptimizer::optimizeVertexCache(indices, m_vertices.size());
+	MeshOptimizer::optimizeOverdraw(indices, m_vertices, p_overdrawThreshold);
+	MeshOptimizer::optimizeVertexFetch(m_vertices, indices);
+
+	m_indices = IndexBuffer(indices, m_vertices.size());
+
+	// The triangle normals follow the index buffer's order
+	m_normals.clear();
+	calculateTriangleNormals();
+
+	for (Mesh& lod : m_lods)
+		lod.optimize(p_overdrawThreshold);
 }
 
 My::Mesh* My::Mesh::createCube(const Color& p_color)
@@ -90,6 +273,28 @@ My::Mesh* My::Mesh::createCube(const Color& p_color)
 
 My::Mesh* My::Mesh::createSphere(const uint32_t p_latitudeCount, const uint32_t p_longitudeCount,
 	const Color& p_color)
+{
+	Mesh* sphere = new Mesh(buildSphere(p_latitudeCount, p_longitudeCount, p_color));
+
+	uint32_t latitudeCount = p_latitudeCount;
+	uint32_t longitudeCount = p_longitudeCount;
+
+	while (latitudeCount > 2 || longitudeCount > 3)
+	{
+		latitudeCount = std::max(2u, latitudeCount / 2);
+		longitudeCount = std::max(3u, longitudeCount / 2);
+
+		sphere->addLod(buildSphere(latitudeCount, longitudeCount, p_color));
+	}
+
+	// The rings are generated cap first then band by band which keeps little in the vertex cache
+	sphere->optimize();
+
+	return sphere;
+}
+
+My::Mesh My::Mesh::buildSphere(const uint32_t p_latitudeCount, const uint32_t p_longitudeCount,
+	const Color& p_color)
 {
 	const float deltaPhi = LibMath::g_pi / static_cast<float>(p_latitudeCount);
 	const float deltaTheta = LibMath::g_pi * 2.f / static_cast<float>(p_longitudeCount);
@@ -171,75 +376,397 @@ My::Mesh* My::Mesh::createSphere(const uint32_t p_latitudeCount, const uint32_t
 		indices.push_back(j0 + p_longitudeCount - 1);
 	}
 
-	return new Mesh(vertices, indices);
+	return { vertices, indices };
 }
 
-void My::Mesh::calculateVertexNormals()
+void My::Mesh::calculateVertexNormals(const LibMath::Radian& p_smoothingAngle)
 {
-	struct Compare
+	copyExternalBuffers();
+
+	if (hasCompressedVertices())
 	{
-		bool operator()(const Vec3& lhs, const Vec3& rhs) const noexcept
+		unpackVertices();
+		calculateVertexNormals(p_smoothingAngle);
+		packVertices();
+		return;
+	}
+
+	if (getVertexLayout() == EVertexLayout::E_SEPARATE)
+	{
+		interleaveVertices();
+		calculateVertexNormals(p_smoothingAngle);
+		splitVertices();
+		return;
+	}
+
+	const size_t vertexCount = m_vertices.size();
+	const size_t triangleCount = m_indices.size() / 3;
+
+	if (triangleCount == 0)
+		return;
+
+	const std::vector<uint32_t> positionIds = weldPositions();
+	const float minCosine = LibMath::cos(p_smoothingAngle);
+
+	m_indices.visit([&](const auto* p_indices)
+	{
+		// Unit normal of each triangle, and the angle of each of its corners as their weight
+		std::vector<float> faceNormals(triangleCount * 3);
+		std::vector<float> cornerWeights(triangleCount * 3);
+
+		ThreadPool::getDefault().parallelFor(triangleCount, [&](const size_t p_begin, const size_t p_end)
 		{
-			return lhs.isShorterThan(rhs);
-		}
+			for (size_t triangle = p_begin; triangle < p_end; triangle++)
+			{
+				const Vec3* corners[3] =
+				{
+					&m_vertices[p_indices[triangle * 3]].m_position,
+					&m_vertices[p_indices[triangle * 3 + 1]].m_position,
+					&m_vertices[p_indices[triangle * 3 + 2]].m_position
+				};
+
+				// Unit edges from each corner to the next one
+				float edges[3][3];
+
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					const Vec3& from = *corners[corner];
+					const Vec3& to = *corners[(corner + 1) % 3];
+					float* edge = edges[corner];
+
+					edge[0] = to.m_x - from.m_x;
+					edge[1] = to.m_y - from.m_y;
+					edge[2] = to.m_z - from.m_z;
+
+					const float length = sqrtf(edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]);
+
+					for (size_t axis = 0; axis < 3; axis++)
+						edge[axis] = length > 0.f ? edge[axis] / length : 0.f;
+				}
+
+				float* normal = &faceNormals[triangle * 3];
+				normal[0] = edges[0][1] * edges[2][2] - edges[0][2] * edges[2][1];
+				normal[1] = edges[0][2] * edges[2][0] - edges[0][0] * edges[2][2];
+				normal[2] = edges[0][0] * edges[2][1] - edges[0][1] * edges[2][0];
+
+				const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+				// Degenerate triangles keep a null normal and weight
+				if (length <= 0.f)
+				{
+					normal[0] = normal[1] = normal[2] = 0.f;
+					continue;
+				}
+
+				for (size_t axis = 0; axis < 3; axis++)
+					normal[axis] /= -length;
+
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					const float* toNext = edges[corner];
+					const float* fromPrevious = edges[(corner + 2) % 3];
+					const float cosine = -(toNext[0] * fromPrevious[0] + toNext[1] * fromPrevious[1]
+						+ toNext[2] * fromPrevious[2]);
+
+					cornerWeights[triangle * 3 + corner] = acosf(LibMath::clamp(cosine, -1.f, 1.f));
+				}
+			}
+		}, NORMAL_CHUNK_SIZE);
+
+		// Corners of every triangle touching each welded position, in compressed rows
+		const size_t cornerCount = triangleCount * 3;
+		std::vector<uint32_t> cornerOffsets(vertexCount + 1, 0);
+
+		for (size_t corner = 0; corner < cornerCount; corner++)
+			cornerOffsets[positionIds[p_indices[corner]] + 1]++;
+
+		for (size_t i = 1; i < cornerOffsets.size(); i++)
+			cornerOffsets[i] += cornerOffsets[i - 1];
+
+		std::vector<uint32_t> positionCorners(cornerCount);
+		std::vector<uint32_t> cursors(cornerOffsets.begin(), cornerOffsets.end() - 1);
+
+		for (size_t corner = 0; corner < cornerCount; corner++)
+			positionCorners[cursors[positionIds[p_indices[corner]]]++] = static_cast<uint32_t>(corner);
+
+		ThreadPool::getDefault().parallelFor(vertexCount, [&](const size_t p_begin, const size_t p_end)
+		{
+			for (size_t vertex = p_begin; vertex < p_end; vertex++)
+			{
+				const uint32_t* first = positionCorners.data() + cornerOffsets[positionIds[vertex]];
+				const uint32_t* last = positionCorners.data() + cornerOffsets[positionIds[vertex] + 1];
+
+				// The triangles using the vertex itself decide which of the others are smoothed with it
+				float reference[3] = { 0.f, 0.f, 0.f };
+
+				for (const uint32_t* corner = first; corner != last; corner++)
+				{
+					if (p_indices[*corner] != vertex)
+						continue;
+
+					const float* faceNormal = &faceNormals[*corner / 3 * 3];
+
+					for (size_t axis = 0; axis < 3; axis++)
+						reference[axis] += faceNormal[axis] * cornerWeights[*corner];
+				}
+
+				// Unused vertices keep their normal
+				if (reference[0] == 0.f && reference[1] == 0.f && reference[2] == 0.f)
+					continue;
+
+				// Comparing against the non normalized average only needs the threshold scaled by its length
+				const float threshold = minCosine * sqrtf(reference[0] * reference[0] + reference[1] * reference[1]
+					+ reference[2] * reference[2]);
+
+				float normal[3] = { 0.f, 0.f, 0.f };
+
+				for (const uint32_t* corner = first; corner != last; corner++)
+				{
+					const float* faceNormal = &faceNormals[*corner / 3 * 3];
+
+					if (faceNormal[0] * reference[0] + faceNormal[1] * reference[1] + faceNormal[2] * reference[2] < threshold)
+						continue;
+
+					for (size_t axis = 0; axis < 3; axis++)
+						normal[axis] += faceNormal[axis] * cornerWeights[*corner];
+				}
+
+				// The vertex's own triangles are always within the angle of their average
+				m_vertices[vertex].m_normal = Vec3(normal[0], normal[1], normal[2]).normalized();
+			}
+		}, NORMAL_CHUNK_SIZE);
+	});
+}
+
+std::vector<uint32_t> My::Mesh::weldPositions() const
+{
+	const size_t vertexCount = m_vertices.size();
+
+	const Vec3 size = m_boundingBox.m_max - m_boundingBox.m_min;
+	const float tolerance = std::max({ size.m_x, size.m_y, size.m_z }) * WELD_TOLERANCE;
+
+	// Cells larger than the tolerance only need their neighbors checked near their faces
+	const float cellSize = tolerance > 0.f ? tolerance * 32.f : 1.f;
+	const float toleranceSquared = tolerance * tolerance;
+
+	std::vector<int32_t> cells(vertexCount * 3);
+
+	const auto hashCell = [](const int32_t* p_cell)
+	{
+		return static_cast<uint32_t>(p_cell[0]) * 73856093u ^ static_cast<uint32_t>(p_cell[1]) * 19349663u
+			^ static_cast<uint32_t>(p_cell[2]) * 83492791u;
 	};
 
-	std::set<Vec3, Compare> uniqueNormals;
+	// Open addressing keeps every welded position of a cell in the same probe sequence
+	size_t tableSize = 1;
 
-	//each Vertex has it's own set of unique normals pointers
-	std::map<Vertex*, std::set<const Vec3*>> vertexUniqueNormals;
+	while (tableSize < vertexCount * 2)
+		tableSize *= 2;
 
-	for (size_t i = 0; i < this->m_indices.size(); i += 3)
+	constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+	std::vector<uint32_t> table(tableSize, EMPTY_SLOT);
+	std::vector<uint32_t> positionIds(vertexCount);
+
+	for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
 	{
-		//triangle ABC
-		const Vec3& a = this->m_vertices[m_indices[i]].m_position;
-		const Vec3& b = this->m_vertices[m_indices[i + 1]].m_position;
-		const Vec3& c = this->m_vertices[m_indices[i + 2]].m_position;
+		const Vec3& position = m_vertices[vertex].m_position;
+		const float offsets[3] =
+		{
+			(position.m_x - m_boundingBox.m_min.m_x) / cellSize,
+			(position.m_y - m_boundingBox.m_min.m_y) / cellSize,
+			(position.m_z - m_boundingBox.m_min.m_z) / cellSize
+		};
+
+		int32_t* cell = &cells[vertex * 3];
+		int32_t first[3];
+		int32_t last[3];
+
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			cell[axis] = static_cast<int32_t>(floorf(offsets[axis]));
+
+			const float fraction = (offsets[axis] - static_cast<float>(cell[axis])) * cellSize;
+			first[axis] = cell[axis] - (fraction < tolerance ? 1 : 0);
+			last[axis] = cell[axis] + (fraction > cellSize - tolerance ? 1 : 0);
+		}
+
+		positionIds[vertex] = vertex;
+
+		for (int32_t x = first[0]; x <= last[0] && positionIds[vertex] == vertex; x++)
+		{
+			for (int32_t y = first[1]; y <= last[1] && positionIds[vertex] == vertex; y++)
+			{
+				for (int32_t z = first[2]; z <= last[2] && positionIds[vertex] == vertex; z++)
+				{
+					const int32_t neighbor[3] = { x, y, z };
+
+					for (size_t slot = hashCell(neighbor) & (tableSize - 1); table[slot] != EMPTY_SLOT;
+						slot = (slot + 1) & (tableSize - 1))
+					{
+						const uint32_t other = table[slot];
+						const int32_t* otherCell = &cells[other * 3];
+
+						if (otherCell[0] == x && otherCell[1] == y && otherCell[2] == z
+							&& (m_vertices[other].m_position - position).magnitudeSquared() <= toleranceSquared)
+						{
+							positionIds[vertex] = other;
+							break;
+						}
+					}
+				}
+			}
+		}
 
-		//create plane
-		Vec3 bc = c - b;
-		Vec3 ba = a - b;
+		if (positionIds[vertex] != vertex)
+			continue;
 
-		//get normal
-		const Vec3 normal = bc.cross(ba).normalized();
+		size_t slot = hashCell(cell) & (tableSize - 1);
 
-		//insert in uniqueNormals, returns pair<it,bool> (bool isNewInsert is ignored)
-		//it is ptr to either new normal or existent normal (no duplicates)
-		const Vec3* normalPtr = &(*uniqueNormals.insert(normal).first);
+		while (table[slot] != EMPTY_SLOT)
+			slot = (slot + 1) & (tableSize - 1);
 
-		vertexUniqueNormals[&m_vertices[m_indices[i]]].insert(normalPtr);
-		vertexUniqueNormals[&m_vertices[m_indices[i + 1]]].insert(normalPtr);
-		vertexUniqueNormals[&m_vertices[m_indices[i + 2]]].insert(normalPtr);
+		table[slot] = vertex;
 	}
 
-	//accumulate operator : add all the Vec3 pointers' values;
-	auto op = [](const Vec3& v1, const Vec3* v2) { return v1 + *v2; };
+	return positionIds;
+}
+
+void My::Mesh::calculateTriangleNormals()
+{
+	copyExternalBuffers();
+
+	if (hasCompressedVertices())
+	{
+		unpackVertices();
+		calculateTriangleNormals();
+		packVertices();
+		return;
+	}
 
-	for (auto& pair : vertexUniqueNormals)
+	if (getVertexLayout() == EVertexLayout::E_SEPARATE)
 	{
-		pair.first->m_normal = std::accumulate(pair.second.begin(), pair.second.end(),
-			Vec3::zero(), op);
-		pair.first->m_normal.normalize();
+		interleaveVertices();
+		calculateTriangleNormals();
+		splitVertices();
+		return;
 	}
+
+	const size_t firstNormal = m_normals.size();
+	const size_t triangleCount = m_indices.size() / 3;
+
+	m_normals.resize(firstNormal + triangleCount);
+
+	m_indices.visit([&](const auto* p_indices)
+	{
+		ThreadPool::getDefault().parallelFor(triangleCount, [&](const size_t p_begin, const size_t p_end)
+		{
+			for (size_t triangle = p_begin; triangle < p_end; triangle++)
+			{
+				//ABC triangle
+				const Vec3& a = this->m_vertices[p_indices[triangle * 3]].m_position;
+				const Vec3& b = this->m_vertices[p_indices[triangle * 3 + 1]].m_position;
+				const Vec3& c = this->m_vertices[p_indices[triangle * 3 + 2]].m_position;
+
+				//create plane
+				Vec3 ab = b - a;
+				Vec3 ac = c - a;
+
+				m_normals[firstNormal + triangle] = ab.cross(ac).normalized();
+			}
+		}, NORMAL_CHUNK_SIZE);
+	});
 }
 
-void My::Mesh::calculateTriangleNormals()
+const My::AABB& My::Mesh::getBoundingBox() const
 {
-	this->m_normals.reserve(this->m_indices.size() / 3);
+	return m_boundingBox;
+}
+
+const My::BoundingSphere& My::Mesh::getBoundingSphere() const
+{
+	return m_boundingSphere;
+}
 
-	for (size_t i = 0; i + 2 < this->m_indices.size(); i += 3)
+void My::Mesh::calculateBounds()
+{
+	if (m_vertices.empty())
 	{
-		//ABC triangle
-		const Vec3& a = this->m_vertices[m_indices[i]].m_position;
-		const Vec3& b = this->m_vertices[m_indices[i + 1]].m_position;
-		const Vec3& c = this->m_vertices[m_indices[i + 2]].m_position;
+		m_boundingBox = {};
+		m_boundingSphere = {};
+		return;
+	}
 
-		//create plane
-		Vec3 ab = b - a;
-		Vec3 ac = c - a;
+	Vec3 min = m_vertices[0].m_position;
+	Vec3 max = min;
 
-		m_normals.push_back(ab.cross(ac).normalized());
+	for (const auto& vertex : m_vertices)
+	{
+		const Vec3& position = vertex.m_position;
+
+		min = { LibMath::min(min.m_x, position.m_x), LibMath::min(min.m_y, position.m_y), LibMath::min(min.m_z, position.m_z) };
+		max = { LibMath::max(max.m_x, position.m_x), LibMath::max(max.m_y, position.m_y), LibMath::max(max.m_z, position.m_z) };
 	}
+
+	m_boundingBox = { min, max };
+
+	// Centering the sphere on the box is a bit loose but never misses a vertex
+	const Vec3 center = m_boundingBox.getCenter();
+	float radiusSquared = 0.f;
+
+	for (const auto& vertex : m_vertices)
+		radiusSquared = LibMath::max(radiusSquared, (vertex.m_position - center).magnitudeSquared());
+
+	m_boundingSphere = { center, sqrtf(radiusSquared) };
+}
+
+void My::Mesh::packVertices()
+{
+	copyExternalBuffers();
+
+	interleaveVertices();
+
+	if (m_vertices.empty())
+		return;
+
+	m_quantization = VertexQuantization(m_boundingBox);
+	m_packedVertices.reserve(m_vertices.size());
+
+	for (const Vertex& vertex : m_vertices)
+		m_packedVertices.push_back(m_quantization.encode(vertex));
+
+	// Frees the full precision buffer's memory
+	std::vector<Vertex>().swap(m_vertices);
+}
+
+void My::Mesh::unpackVertices()
+{
+	if (m_packedVertices.empty())
+		return;
+
+	m_vertices = decodeVertices();
+	std::vector<PackedVertex>().swap(m_packedVertices);
+}
+
+void My::Mesh::splitVertices()
+{
+	copyExternalBuffers();
+
+	unpackVertices();
+
+	if (m_vertices.empty())
+		return;
+
+	m_vertexStreams = VertexStreams(m_vertices);
+	std::vector<Vertex>().swap(m_vertices);
+}
+
+void My::Mesh::interleaveVertices()
+{
+	if (m_vertexStreams.empty())
+		return;
+
+	m_vertices = m_vertexStreams.toVertices();
+	m_vertexStreams = {};
 }
 
 const My::Texture* My::Mesh::getTexture() const
@@ -250,4 +777,79 @@ const My::Texture* My::Mesh::getTexture() const
 void My::Mesh::setTexture(const Texture* p_texture)
 {
 	m_texture = p_texture;
+
+	for (Mesh& lod : m_lods)
+		lod.setTexture(p_texture);
+}
+
+bool My::Mesh::isOccluder() const
+{
+	return m_isOccluder;
+}
+
+void My::Mesh::setOccluder(const bool p_isOccluder)
+{
+	m_isOccluder = p_isOccluder;
+}
+
+void My::Mesh::addLod(const Mesh& p_lod)
+{
+	m_lods.push_back(p_lod);
+
+	// Levels are stored like the mesh itself
+	Mesh& lod = m_lods.back();
+	lod.unpackVertices();
+	lod.interleaveVertices();
+
+	if (hasCompressedVertices())
+		lod.packVertices();
+	else if (getVertexLayout() == EVertexLayout::E_SEPARATE)
+		lod.splitVertices();
+
+	// Levels are flat - a level with its own chain would never be selected
+	lod.m_lods.clear();
+	lod.m_texture = m_texture;
+}
+
+size_t My::Mesh::getLodCount() const
+{
+	return m_lods.size() + 1;
+}
+
+const My::Mesh& My::Mesh::getLod(const size_t p_level) const
+{
+	if (p_level >= getLodCount())
+		throw std::out_of_range("Invalid level of detail " + std::to_string(p_level)
+			+ ". The mesh has " + std::to_string(getLodCount()) + " levels");
+
+	return p_level == 0 ? *this : m_lods[p_level - 1];
+}
+
+float My::Mesh::getLodScreenSize(const size_t p_level) const
+{
+	const float triangleCount = static_cast<float>(getLod(p_level).m_indices.size() / 3);
+
+	// Diameter of the disc whose area gives each triangle the wanted number of pixels
+	return sqrtf(triangleCount * PIXELS_PER_TRIANGLE * 4.f / LibMath::g_pi);
+}
+
+void My::Mesh::generateLods(const std::vector<float>& p_triangleRatios)
+{
+	m_lods.clear();
+
+	MeshSimplifier simplifier(*this);
+	const size_t triangleCount = m_indices.size() / 3;
+
+	for (const float ratio : p_triangleRatios)
+	{
+		const size_t previousCount = simplifier.getTriangleCount();
+
+		simplifier.simplify(static_cast<size_t>(static_cast<float>(triangleCount) * ratio));
+
+		// The borders, seams and folds left can't be reduced any further
+		if (simplifier.getTriangleCount() == previousCount)
+			break;
+
+		addLod(simplifier.createMesh());
+	}
 }
@@ -0,0 +1,1116 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+#include "Arithmetic.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+namespace My
+{
+	namespace
+	{
+		constexpr uint32_t MISSING_INDEX = UINT32_MAX;
+
+		// Significant digits which fit in the 64 bit mantissa accumulator
+		constexpr int32_t MAX_DIGITS = 19;
+
+		bool isSpace(const char p_char)
+		{
+			return p_char == ' ' || p_char == '\t' || p_char == '\r';
+		}
+
+		bool isDigit(const char p_char)
+		{
+			return static_cast<unsigned char>(p_char - '0') < 10;
+		}
+
+		const char* skipSpaces(const char* p_cursor, const char* p_end)
+		{
+			while (p_cursor < p_end && isSpace(*p_cursor))
+				p_cursor++;
+
+			return p_cursor;
+		}
+
+		/**
+		 * \brief Finds the end of the line starting at the given position
+		 * \return The position of the line's '\n', or the end of the data
+		 */
+		const char* findLineEnd(const char* p_cursor, const char* p_end)
+		{
+			const void* newLine = std::memchr(p_cursor, '\n', static_cast<size_t>(p_end - p_cursor));
+			return newLine == nullptr ? p_end : static_cast<const char*>(newLine);
+		}
+
+		std::runtime_error parseError(const char* p_format, const char* p_data, const char* p_cursor)
+		{
+			return std::runtime_error(std::string("Invalid ") + p_format + " data at byte "
+				+ std::to_string(p_cursor - p_data));
+		}
+
+		/**
+		 * \brief Parses a decimal number, accumulating its significant digits in an integer scaled once by
+		 * a power of ten. Much faster than strtof, which handles locales, and exact for the usual 6 to 9 digits
+		 * \param p_cursor The first character of the number, moved past it on success
+		 * \param p_end The end of the data
+		 * \param p_value Receives the parsed number
+		 * \return True if a number was parsed. False otherwise
+		 */
+		bool parseFloat(const char*& p_cursor, const char* p_end, float& p_value)
+		{
+			static constexpr double POWERS_OF_TEN[] =
+			{
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+			};
+
+			constexpr int32_t MAX_EXACT_POWER = 22;
+
+			const char* cursor = p_cursor;
+			const bool isNegative = cursor < p_end && *cursor == '-';
+
+			if (cursor < p_end && (*cursor == '-' || *cursor == '+'))
+				cursor++;
+
+			uint64_t mantissa = 0;
+			int32_t exponent = 0;
+			int32_t digitCount = 0;
+			bool hasDigits = false;
+
+			for (; cursor < p_end && isDigit(*cursor); cursor++)
+			{
+				hasDigits = true;
+
+				if (digitCount < MAX_DIGITS)
+				{
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+					digitCount += mantissa != 0;
+				}
+				else
+				{
+					exponent++;
+				}
+			}
+
+			if (cursor < p_end && *cursor == '.')
+			{
+				for (cursor++; cursor < p_end && isDigit(*cursor); cursor++)
+				{
+					hasDigits = true;
+
+					if (digitCount < MAX_DIGITS)
+					{
+						mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+						digitCount += mantissa != 0;
+						exponent--;
+					}
+				}
+			}
+
+			if (!hasDigits)
+				return false;
+
+			if (cursor < p_end && (*cursor == 'e' || *cursor == 'E'))
+			{
+				const char* exponentCursor = cursor + 1;
+				const bool isExponentNegative = exponentCursor < p_end && *exponentCursor == '-';
+
+				if (exponentCursor < p_end && (*exponentCursor == '-' || *exponentCursor == '+'))
+					exponentCursor++;
+
+				if (exponentCursor < p_end && isDigit(*exponentCursor))
+				{
+					int32_t exponentValue = 0;
+
+					for (; exponentCursor < p_end && isDigit(*exponentCursor); exponentCursor++)
+						exponentValue = std::min(exponentValue * 10 + (*exponentCursor - '0'), 100000);
+
+					exponent += isExponentNegative ? -exponentValue : exponentValue;
+					cursor = exponentCursor;
+				}
+			}
+
+			double value = static_cast<double>(mantissa);
+
+			if (exponent < 0)
+				value = -exponent <= MAX_EXACT_POWER ? value / POWERS_OF_TEN[-exponent] : value * std::pow(10., exponent);
+			else if (exponent > 0)
+				value = exponent <= MAX_EXACT_POWER ? value * POWERS_OF_TEN[exponent] : value * std::pow(10., exponent);
+
+			p_value = static_cast<float>(isNegative ? -value : value);
+			p_cursor = cursor;
+
+			return true;
+		}
+
+		bool parseInteger(const char*& p_cursor, const char* p_end, int64_t& p_value)
+		{
+			const char* cursor = p_cursor;
+			const bool isNegative = cursor < p_end && *cursor == '-';
+
+			if (cursor < p_end && (*cursor == '-' || *cursor == '+'))
+				cursor++;
+
+			if (cursor == p_end || !isDigit(*cursor))
+				return false;
+
+			int64_t value = 0;
+
+			for (; cursor < p_end && isDigit(*cursor); cursor++)
+				value = std::min<int64_t>(value * 10 + (*cursor - '0'), INT32_MAX);
+
+			p_value = isNegative ? -value : value;
+			p_cursor = cursor;
+
+			return true;
+		}
+
+		uint8_t toColorChannel(const float p_value)
+		{
+			return static_cast<uint8_t>(LibMath::clamp(p_value, 0.f, 1.f) * 255.f + .5f);
+		}
+
+		enum class EObjLine : uint8_t
+		{
+			E_POSITION,
+			E_TEX_COORD,
+			E_NORMAL,
+			E_FACE,
+			E_OTHER
+		};
+
+		/**
+		 * \brief Identifies the given OBJ line from its keyword
+		 * \param p_cursor The first character of the line, moved past the keyword
+		 * \param p_lineEnd The end of the line
+		 * \return The kind of line
+		 */
+		EObjLine readObjKeyword(const char*& p_cursor, const char* p_lineEnd)
+		{
+			const char* cursor = skipSpaces(p_cursor, p_lineEnd);
+			const size_t length = static_cast<size_t>(p_lineEnd - cursor);
+
+			EObjLine line = EObjLine::E_OTHER;
+			size_t keywordLength = 0;
+
+			if (length >= 2 && cursor[0] == 'v' && isSpace(cursor[1]))
+			{
+				line = EObjLine::E_POSITION;
+				keywordLength = 1;
+			}
+			else if (length >= 3 && cursor[0] == 'v' && cursor[1] == 't' && isSpace(cursor[2]))
+			{
+				line = EObjLine::E_TEX_COORD;
+				keywordLength = 2;
+			}
+			else if (length >= 3 && cursor[0] == 'v' && cursor[1] == 'n' && isSpace(cursor[2]))
+			{
+				line = EObjLine::E_NORMAL;
+				keywordLength = 2;
+			}
+			else if (length >= 2 && cursor[0] == 'f' && isSpace(cursor[1]))
+			{
+				line = EObjLine::E_FACE;
+				keywordLength = 1;
+			}
+
+			p_cursor = cursor + keywordLength;
+			return line;
+		}
+
+		struct ObjCounts
+		{
+			size_t	m_positionCount = 0;
+			size_t	m_texCoordCount = 0;
+			size_t	m_normalCount = 0;
+			size_t	m_triangleCount = 0;
+		};
+
+		struct ObjChunk
+		{
+			const char*	m_begin = nullptr;
+			const char*	m_end = nullptr;
+			ObjCounts	m_counts;
+			ObjCounts	m_first;
+		};
+
+		struct ObjCorner
+		{
+			uint32_t	m_position = MISSING_INDEX;
+			uint32_t	m_texCoord = MISSING_INDEX;
+			uint32_t	m_normal = MISSING_INDEX;
+
+			bool operator==(const ObjCorner& p_other) const
+			{
+				return m_position == p_other.m_position && m_texCoord == p_other.m_texCoord
+					&& m_normal == p_other.m_normal;
+			}
+		};
+
+		/**
+		 * \brief Converts an OBJ index, 1 based or relative to the end when negative, to a 0 based one
+		 * \param p_index The index read from the file
+		 * \param p_count The number of elements defined before the face
+		 * \param p_total The number of elements in the file
+		 * \return The 0 based index, or MISSING_INDEX if it is out of range
+		 */
+		uint32_t resolveObjIndex(const int64_t p_index, const size_t p_count, const size_t p_total)
+		{
+			const int64_t index = p_index > 0 ? p_index - 1 : static_cast<int64_t>(p_count) + p_index;
+
+			if (p_index == 0 || index < 0 || static_cast<size_t>(index) >= p_total)
+				return MISSING_INDEX;
+
+			return static_cast<uint32_t>(index);
+		}
+
+		enum class EPlyType : uint8_t
+		{
+			E_INT8,
+			E_UINT8,
+			E_INT16,
+			E_UINT16,
+			E_INT32,
+			E_UINT32,
+			E_FLOAT32,
+			E_FLOAT64
+		};
+
+		struct PlyProperty
+		{
+			std::string	m_name;
+			EPlyType	m_type = EPlyType::E_FLOAT32;
+			EPlyType	m_countType = EPlyType::E_UINT8;
+			bool		m_isList = false;
+			size_t		m_offset = 0;
+		};
+
+		struct PlyElement
+		{
+			std::string					m_name;
+			size_t						m_count = 0;
+			std::vector<PlyProperty>	m_properties;
+			size_t						m_stride = 0;	// 0 if the element has list properties
+		};
+
+		bool parsePlyType(const std::string& p_name, EPlyType& p_type)
+		{
+			static const std::pair<const char*, EPlyType> TYPES[] =
+			{
+				{ "char", EPlyType::E_INT8 }, { "int8", EPlyType::E_INT8 },
+				{ "uchar", EPlyType::E_UINT8 }, { "uint8", EPlyType::E_UINT8 },
+				{ "short", EPlyType::E_INT16 }, { "int16", EPlyType::E_INT16 },
+				{ "ushort", EPlyType::E_UINT16 }, { "uint16", EPlyType::E_UINT16 },
+				{ "int", EPlyType::E_INT32 }, { "int32", EPlyType::E_INT32 },
+				{ "uint", EPlyType::E_UINT32 }, { "uint32", EPlyType::E_UINT32 },
+				{ "float", EPlyType::E_FLOAT32 }, { "float32", EPlyType::E_FLOAT32 },
+				{ "double", EPlyType::E_FLOAT64 }, { "float64", EPlyType::E_FLOAT64 }
+			};
+
+			for (const auto& type : TYPES)
+			{
+				if (p_name == type.first)
+				{
+					p_type = type.second;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		size_t getPlyTypeSize(const EPlyType p_type)
+		{
+			switch (p_type)
+			{
+			case EPlyType::E_INT8:
+			case EPlyType::E_UINT8:
+				return 1;
+			case EPlyType::E_INT16:
+			case EPlyType::E_UINT16:
+				return 2;
+			case EPlyType::E_FLOAT64:
+				return 8;
+			default:
+				return 4;
+			}
+		}
+
+		template <typename T>
+		T readPlyRaw(const char* p_data, const bool p_isSwapped)
+		{
+			char bytes[sizeof(T)];
+			std::memcpy(bytes, p_data, sizeof(T));
+
+			if (p_isSwapped)
+				std::reverse(bytes, bytes + sizeof(T));
+
+			T value;
+			std::memcpy(&value, bytes, sizeof(T));
+
+			return value;
+		}
+
+		double readPlyValue(const char* p_data, const EPlyType p_type, const bool p_isSwapped)
+		{
+			switch (p_type)
+			{
+			case EPlyType::E_INT8:
+				return readPlyRaw<int8_t>(p_data, p_isSwapped);
+			case EPlyType::E_UINT8:
+				return readPlyRaw<uint8_t>(p_data, p_isSwapped);
+			case EPlyType::E_INT16:
+				return readPlyRaw<int16_t>(p_data, p_isSwapped);
+			case EPlyType::E_UINT16:
+				return readPlyRaw<uint16_t>(p_data, p_isSwapped);
+			case EPlyType::E_INT32:
+				return readPlyRaw<int32_t>(p_data, p_isSwapped);
+			case EPlyType::E_UINT32:
+				return readPlyRaw<uint32_t>(p_data, p_isSwapped);
+			case EPlyType::E_FLOAT32:
+				return readPlyRaw<float>(p_data, p_isSwapped);
+			default:
+				return readPlyRaw<double>(p_data, p_isSwapped);
+			}
+		}
+
+		/**
+		 * \brief Splits the given header line on spaces
+		 */
+		std::vector<std::string> splitWords(const char* p_begin, const char* p_end)
+		{
+			std::vector<std::string> words;
+
+			for (const char* cursor = skipSpaces(p_begin, p_end); cursor < p_end; cursor = skipSpaces(cursor, p_end))
+			{
+				const char* wordEnd = cursor;
+
+				while (wordEnd < p_end && !isSpace(*wordEnd))
+					wordEnd++;
+
+				words.emplace_back(cursor, wordEnd);
+				cursor = wordEnd;
+			}
+
+			return words;
+		}
+
+		/**
+		 * \brief Gives the size of the given property's value, read from the data for lists
+		 * \return The number of bytes of the value
+		 */
+		size_t getPlyPropertySize(const PlyProperty& p_property, const char* p_value, const char* p_end,
+			const bool p_isSwapped, const char* p_data)
+		{
+			if (!p_property.m_isList)
+				return getPlyTypeSize(p_property.m_type);
+
+			const size_t countSize = getPlyTypeSize(p_property.m_countType);
+
+			if (p_value + countSize > p_end)
+				throw parseError("PLY", p_data, p_end);
+
+			const double count = readPlyValue(p_value, p_property.m_countType, p_isSwapped);
+
+			if (count < 0.)
+				throw parseError("PLY", p_data, p_value);
+
+			return countSize + static_cast<size_t>(count) * getPlyTypeSize(p_property.m_type);
+		}
+
+		/**
+		 * \brief Gives the size of the given item of an element with list properties
+		 * \return The number of bytes of the item
+		 */
+		size_t getPlyItemSize(const PlyElement& p_element, const char* p_item, const char* p_end, const bool p_isSwapped,
+			const char* p_data)
+		{
+			size_t size = 0;
+
+			for (const PlyProperty& property : p_element.m_properties)
+				size += getPlyPropertySize(property, p_item + size, p_end, p_isSwapped, p_data);
+
+			return size;
+		}
+
+		/**
+		 * \brief Finds the index of the first property with one of the given names
+		 * \return The index of the property, or -1 if there is none
+		 */
+		int32_t findPlyProperty(const PlyElement& p_element, std::initializer_list<const char*> p_names)
+		{
+			for (size_t i = 0; i < p_element.m_properties.size(); i++)
+			{
+				for (const char* name : p_names)
+				{
+					if (p_element.m_properties[i].m_name == name)
+						return static_cast<int32_t>(i);
+				}
+			}
+
+			return -1;
+		}
+
+		/**
+		 * \brief Finishes the mesh, generating its normals if the file had none
+		 * and those of the faces left without any if it only had some
+		 */
+		Mesh createImportedMesh(std::vector<Vertex>&& p_vertices, std::vector<uint32_t>&& p_indices, const bool p_hasNormals)
+		{
+			const size_t vertexCount = p_vertices.size();
+
+			const auto isMissingNormal = [](const Vertex& p_vertex)
+			{
+				return p_vertex.m_normal == LibMath::Vector3::zero();
+			};
+
+			// The file's normals are kept, only the missing ones are taken from the generated ones
+			if (p_hasNormals && std::any_of(p_vertices.begin(), p_vertices.end(), isMissingNormal))
+			{
+				Mesh generated(std::vector<Vertex>(p_vertices), IndexBuffer(std::vector<uint32_t>(p_indices), vertexCount));
+				generated.calculateVertexNormals();
+
+				const StreamView<Vertex> generatedVertices = generated.getVertices();
+
+				for (size_t i = 0; i < vertexCount; i++)
+				{
+					if (isMissingNormal(p_vertices[i]))
+						p_vertices[i].m_normal = generatedVertices[i].m_normal;
+				}
+			}
+
+			Mesh mesh(std::move(p_vertices), IndexBuffer(std::move(p_indices), vertexCount));
+
+			if (!p_hasNormals)
+				mesh.calculateVertexNormals();
+
+			return mesh;
+		}
+	}
+
+	double MeshImporter::Statistics::getThroughput() const
+	{
+		return m_seconds > 0. ? static_cast<double>(m_byteCount) / 1e6 / m_seconds : 0.;
+	}
+
+	Mesh MeshImporter::load(const std::string& p_path, Statistics* p_statistics)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		const size_t extensionStart = p_path.find_last_of('.');
+		std::string extension = extensionStart == std::string::npos ? "" : p_path.substr(extensionStart + 1);
+
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](const char p_char) { return static_cast<char>(tolower(static_cast<unsigned char>(p_char))); });
+
+		if (extension != "obj" && extension != "ply")
+			throw std::invalid_argument("Unsupported mesh format: " + p_path);
+
+		const MappedFile file(p_path);
+
+		Mesh mesh = extension == "obj" ? parseObj(file.getData(), file.getSize()) : parsePly(file.getData(), file.getSize());
+
+		if (p_statistics != nullptr)
+		{
+			p_statistics->m_byteCount = file.getSize();
+			p_statistics->m_vertexCount = mesh.getVertexCount();
+			p_statistics->m_triangleCount = mesh.getIndices().size() / 3;
+			p_statistics->m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		return mesh;
+	}
+
+	Mesh MeshImporter::parseObj(const char* p_data, const size_t p_size)
+	{
+		const char* end = p_data + p_size;
+
+		// Chunks of about OBJ_CHUNK_SIZE bytes, cut after a new line
+		std::vector<ObjChunk> chunks;
+
+		for (const char* cursor = p_data; cursor < end;)
+		{
+			const char* chunkEnd = end - cursor > static_cast<ptrdiff_t>(OBJ_CHUNK_SIZE) ? cursor + OBJ_CHUNK_SIZE : end;
+
+			if (chunkEnd < end)
+				chunkEnd = std::min(findLineEnd(chunkEnd, end) + 1, end);
+
+			ObjChunk chunk;
+			chunk.m_begin = cursor;
+			chunk.m_end = chunkEnd;
+			chunks.push_back(chunk);
+
+			cursor = chunkEnd;
+		}
+
+		ThreadPool& threadPool = ThreadPool::getDefault();
+
+		// First pass: counts the elements of each chunk to know where its own are written
+		threadPool.parallelFor(chunks.size(), [&chunks](const size_t p_begin, const size_t p_end)
+		{
+			for (size_t i = p_begin; i < p_end; i++)
+			{
+				ObjChunk& chunk = chunks[i];
+
+				for (const char* cursor = chunk.m_begin; cursor < chunk.m_end;)
+				{
+					const char* lineEnd = findLineEnd(cursor, chunk.m_end);
+
+					switch (readObjKeyword(cursor, lineEnd))
+					{
+					case EObjLine::E_POSITION:
+						chunk.m_counts.m_positionCount++;
+						break;
+					case EObjLine::E_TEX_COORD:
+						chunk.m_counts.m_texCoordCount++;
+						break;
+					case EObjLine::E_NORMAL:
+						chunk.m_counts.m_normalCount++;
+						break;
+					case EObjLine::E_FACE:
+					{
+						size_t cornerCount = 0;
+
+						for (cursor = skipSpaces(cursor, lineEnd); cursor < lineEnd && *cursor != '#';
+							cursor = skipSpaces(cursor, lineEnd))
+						{
+							cornerCount++;
+
+							while (cursor < lineEnd && !isSpace(*cursor))
+								cursor++;
+						}
+
+						chunk.m_counts.m_triangleCount += cornerCount >= 3 ? cornerCount - 2 : 0;
+						break;
+					}
+					default:
+						break;
+					}
+
+					cursor = lineEnd + 1;
+				}
+			}
+		}, 1);
+
+		ObjCounts total;
+
+		for (ObjChunk& chunk : chunks)
+		{
+			chunk.m_first = total;
+			total.m_positionCount += chunk.m_counts.m_positionCount;
+			total.m_texCoordCount += chunk.m_counts.m_texCoordCount;
+			total.m_normalCount += chunk.m_counts.m_normalCount;
+			total.m_triangleCount += chunk.m_counts.m_triangleCount;
+		}
+
+		std::vector<float> positions(total.m_positionCount * 3);
+		std::vector<Color> colors(total.m_positionCount, Color::white);
+		std::vector<float> texCoords(total.m_texCoordCount * 2);
+		std::vector<float> normals(total.m_normalCount * 3);
+		std::vector<ObjCorner> corners(total.m_triangleCount * 3);
+
+		// Second pass: parses each chunk straight into the final arrays
+		threadPool.parallelFor(chunks.size(), [&](const size_t p_begin, const size_t p_end)
+		{
+			for (size_t i = p_begin; i < p_end; i++)
+			{
+				const ObjChunk& chunk = chunks[i];
+				ObjCounts count = chunk.m_first;
+
+				for (const char* cursor = chunk.m_begin; cursor < chunk.m_end;)
+				{
+					const char* lineEnd = findLineEnd(cursor, chunk.m_end);
+
+					const auto readFloats = [&](float* p_values, const size_t p_count)
+					{
+						for (size_t value = 0; value < p_count; value++)
+						{
+							cursor = skipSpaces(cursor, lineEnd);
+
+							if (!parseFloat(cursor, lineEnd, p_values[value]))
+								throw parseError("OBJ", p_data, cursor);
+						}
+					};
+
+					switch (readObjKeyword(cursor, lineEnd))
+					{
+					case EObjLine::E_POSITION:
+					{
+						readFloats(&positions[count.m_positionCount * 3], 3);
+
+						// Optional vertex color
+						float color[3];
+						cursor = skipSpaces(cursor, lineEnd);
+
+						if (parseFloat(cursor, lineEnd, color[0]))
+						{
+							readFloats(color + 1, 2);
+							colors[count.m_positionCount] = Color(toColorChannel(color[0]), toColorChannel(color[1]),
+								toColorChannel(color[2]), UINT8_MAX);
+						}
+
+						count.m_positionCount++;
+						break;
+					}
+					case EObjLine::E_TEX_COORD:
+					{
+						float* texCoord = &texCoords[count.m_texCoordCount * 2];
+						readFloats(texCoord, 1);
+
+						cursor = skipSpaces(cursor, lineEnd);
+
+						if (!parseFloat(cursor, lineEnd, texCoord[1]))
+							texCoord[1] = 0.f;
+
+						// OBJ's v axis goes up while the textures' rows go down
+						texCoord[1] = 1.f - texCoord[1];
+
+						count.m_texCoordCount++;
+						break;
+					}
+					case EObjLine::E_NORMAL:
+						readFloats(&normals[count.m_normalCount * 3], 3);
+						count.m_normalCount++;
+						break;
+					case EObjLine::E_FACE:
+					{
+						ObjCorner first;
+						ObjCorner previous;
+						size_t cornerCount = 0;
+
+						for (cursor = skipSpaces(cursor, lineEnd); cursor < lineEnd && *cursor != '#';
+							cursor = skipSpaces(cursor, lineEnd))
+						{
+							ObjCorner corner;
+							int64_t index;
+
+							if (!parseInteger(cursor, lineEnd, index))
+								throw parseError("OBJ", p_data, cursor);
+
+							corner.m_position = resolveObjIndex(index, count.m_positionCount, total.m_positionCount);
+
+							if (cursor < lineEnd && *cursor == '/')
+							{
+								cursor++;
+
+								if (cursor < lineEnd && *cursor != '/')
+								{
+									if (!parseInteger(cursor, lineEnd, index))
+										throw parseError("OBJ", p_data, cursor);
+
+									corner.m_texCoord = resolveObjIndex(index, count.m_texCoordCount, total.m_texCoordCount);
+
+									if (corner.m_texCoord == MISSING_INDEX)
+										throw parseError("OBJ", p_data, cursor);
+								}
+
+								if (cursor < lineEnd && *cursor == '/')
+								{
+									cursor++;
+
+									if (!parseInteger(cursor, lineEnd, index))
+										throw parseError("OBJ", p_data, cursor);
+
+									corner.m_normal = resolveObjIndex(index, count.m_normalCount, total.m_normalCount);
+
+									if (corner.m_normal == MISSING_INDEX)
+										throw parseError("OBJ", p_data, cursor);
+								}
+							}
+
+							if (corner.m_position == MISSING_INDEX || (cursor < lineEnd && !isSpace(*cursor)))
+								throw parseError("OBJ", p_data, cursor);
+
+							// Triangle fan around the first corner
+							if (cornerCount == 0)
+								first = corner;
+							else if (cornerCount >= 2)
+							{
+								ObjCorner* triangle = &corners[count.m_triangleCount * 3];
+								triangle[0] = first;
+								triangle[1] = previous;
+								triangle[2] = corner;
+								count.m_triangleCount++;
+							}
+
+							previous = corner;
+							cornerCount++;
+						}
+						break;
+					}
+					default:
+						break;
+					}
+
+					cursor = lineEnd + 1;
+				}
+			}
+		}, 1);
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices(corners.size());
+
+		const auto setAttributes = [&](Vertex& p_vertex, const ObjCorner& p_corner)
+		{
+			const float* position = &positions[p_corner.m_position * 3];
+			p_vertex.m_position = { position[0], position[1], position[2] };
+			p_vertex.m_color = colors[p_corner.m_position];
+
+			if (p_corner.m_normal != MISSING_INDEX)
+			{
+				const float* normal = &normals[p_corner.m_normal * 3];
+				p_vertex.m_normal = { normal[0], normal[1], normal[2] };
+			}
+			else
+			{
+				p_vertex.m_normal = LibMath::Vector3::zero();
+			}
+
+			const bool hasTexCoord = p_corner.m_texCoord != MISSING_INDEX;
+			p_vertex.m_u = hasTexCoord ? texCoords[p_corner.m_texCoord * 2] : 0.f;
+			p_vertex.m_v = hasTexCoord ? texCoords[p_corner.m_texCoord * 2 + 1] : 0.f;
+		};
+
+		if (total.m_texCoordCount == 0 && total.m_normalCount == 0)
+		{
+			// The positions are the vertices
+			vertices.resize(total.m_positionCount);
+
+			threadPool.parallelFor(corners.size(), [&](const size_t p_begin, const size_t p_end)
+			{
+				for (size_t i = p_begin; i < p_end; i++)
+					indices[i] = corners[i].m_position;
+			}, ELEMENT_CHUNK_SIZE);
+
+			threadPool.parallelFor(vertices.size(), [&](const size_t p_begin, const size_t p_end)
+			{
+				for (size_t i = p_begin; i < p_end; i++)
+					setAttributes(vertices[i], ObjCorner{ static_cast<uint32_t>(i), MISSING_INDEX, MISSING_INDEX });
+			}, ELEMENT_CHUNK_SIZE);
+		}
+		else
+		{
+			// Every distinct corner becomes a vertex, found back with an open addressing hash table
+			size_t tableSize = 1;
+
+			while (tableSize < corners.size() * 2)
+				tableSize *= 2;
+
+			std::vector<uint32_t> table(tableSize, MISSING_INDEX);
+			std::vector<ObjCorner> uniqueCorners;
+
+			for (size_t i = 0; i < corners.size(); i++)
+			{
+				const ObjCorner& corner = corners[i];
+				size_t slot = (corner.m_position * 73856093u ^ corner.m_texCoord * 19349663u
+					^ corner.m_normal * 83492791u) & (tableSize - 1);
+
+				while (table[slot] != MISSING_INDEX && !(uniqueCorners[table[slot]] == corner))
+					slot = (slot + 1) & (tableSize - 1);
+
+				if (table[slot] == MISSING_INDEX)
+				{
+					table[slot] = static_cast<uint32_t>(uniqueCorners.size());
+					uniqueCorners.push_back(corner);
+				}
+
+				indices[i] = table[slot];
+			}
+
+			vertices.resize(uniqueCorners.size());
+
+			threadPool.parallelFor(vertices.size(), [&](const size_t p_begin, const size_t p_end)
+			{
+				for (size_t i = p_begin; i < p_end; i++)
+					setAttributes(vertices[i], uniqueCorners[i]);
+			}, ELEMENT_CHUNK_SIZE);
+		}
+
+		return createImportedMesh(std::move(vertices), std::move(indices), total.m_normalCount != 0);
+	}
+
+	Mesh MeshImporter::parsePly(const char* p_data, const size_t p_size)
+	{
+		const char* end = p_data + p_size;
+		const char* cursor = p_data;
+
+		// Header
+		std::vector<PlyElement> elements;
+		bool isSwapped = false;
+		bool isHeaderComplete = false;
+		bool hasMagic = false;
+
+		constexpr uint16_t ENDIANNESS_PROBE = 1;
+		uint8_t firstByte;
+		std::memcpy(&firstByte, &ENDIANNESS_PROBE, 1);
+		const bool isLittleEndian = firstByte == 1;
+
+		while (cursor < end && !isHeaderComplete)
+		{
+			const char* lineEnd = findLineEnd(cursor, end);
+			const std::vector<std::string> words = splitWords(cursor, lineEnd);
+			cursor = std::min(lineEnd + 1, end);
+
+			if (words.empty())
+				continue;
+
+			if (!hasMagic)
+			{
+				if (words[0] != "ply")
+					throw std::runtime_error("Invalid PLY data: missing magic number");
+
+				hasMagic = true;
+			}
+			else if (words[0] == "format" && words.size() >= 2)
+			{
+				if (words[1] == "binary_little_endian")
+					isSwapped = !isLittleEndian;
+				else if (words[1] == "binary_big_endian")
+					isSwapped = isLittleEndian;
+				else
+					throw std::runtime_error("Unsupported PLY format: " + words[1]);
+			}
+			else if (words[0] == "element" && words.size() >= 3)
+			{
+				PlyElement element;
+				element.m_name = words[1];
+				element.m_count = std::stoull(words[2]);
+				elements.push_back(element);
+			}
+			else if (words[0] == "property" && words.size() >= 2 && !elements.empty())
+			{
+				PlyProperty property;
+				const bool isList = words.size() >= 5 && words[1] == "list";
+
+				if ((isList && (!parsePlyType(words[2], property.m_countType) || !parsePlyType(words[3], property.m_type)))
+					|| (!isList && (words.size() < 3 || !parsePlyType(words[1], property.m_type))))
+					throw std::runtime_error("Invalid PLY property: " + words[1]);
+
+				property.m_isList = isList;
+				property.m_name = words.back();
+				elements.back().m_properties.push_back(property);
+			}
+			else if (words[0] == "end_header")
+			{
+				isHeaderComplete = true;
+			}
+		}
+
+		if (!isHeaderComplete)
+			throw std::runtime_error("Invalid PLY data: missing end_header");
+
+		for (PlyElement& element : elements)
+		{
+			size_t offset = 0;
+			bool hasList = false;
+
+			for (PlyProperty& property : element.m_properties)
+			{
+				property.m_offset = offset;
+				offset += getPlyTypeSize(property.m_type);
+				hasList |= property.m_isList;
+			}
+
+			element.m_stride = hasList ? 0 : offset;
+		}
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		bool hasNormals = false;
+
+		ThreadPool& threadPool = ThreadPool::getDefault();
+
+		for (const PlyElement& element : elements)
+		{
+			if (element.m_name == "vertex")
+			{
+				if (element.m_stride == 0)
+					throw std::runtime_error("Unsupported PLY data: vertices with list properties");
+
+				if (static_cast<size_t>(end - cursor) / element.m_stride < element.m_count)
+					throw parseError("PLY", p_data, end);
+
+				// Attributes missing from the file are left out of the lookups
+				const int32_t attributes[] =
+				{
+					findPlyProperty(element, { "x" }),
+					findPlyProperty(element, { "y" }),
+					findPlyProperty(element, { "z" }),
+					findPlyProperty(element, { "nx" }),
+					findPlyProperty(element, { "ny" }),
+					findPlyProperty(element, { "nz" }),
+					findPlyProperty(element, { "red", "r" }),
+					findPlyProperty(element, { "green", "g" }),
+					findPlyProperty(element, { "blue", "b" }),
+					findPlyProperty(element, { "alpha", "a" }),
+					findPlyProperty(element, { "u", "s", "texture_u", "texture_s" }),
+					findPlyProperty(element, { "v", "t", "texture_v", "texture_t" })
+				};
+
+				hasNormals = attributes[3] >= 0 && attributes[4] >= 0 && attributes[5] >= 0;
+				vertices.resize(element.m_count);
+
+				const char* first = cursor;
+
+				threadPool.parallelFor(element.m_count, [&](const size_t p_begin, const size_t p_end)
+				{
+					for (size_t i = p_begin; i < p_end; i++)
+					{
+						const char* item = first + i * element.m_stride;
+
+						const auto read = [&](const size_t p_attribute, const double p_default)
+						{
+							if (attributes[p_attribute] < 0)
+								return p_default;
+
+							const PlyProperty& property = element.m_properties[attributes[p_attribute]];
+							return readPlyValue(item + property.m_offset, property.m_type, isSwapped);
+						};
+
+						// Integer colors are already in [0, 255]
+						const auto readChannel = [&](const size_t p_attribute)
+						{
+							if (attributes[p_attribute] < 0)
+								return static_cast<uint8_t>(UINT8_MAX);
+
+							const PlyProperty& property = element.m_properties[attributes[p_attribute]];
+							const double value = readPlyValue(item + property.m_offset, property.m_type, isSwapped);
+
+							if (property.m_type == EPlyType::E_FLOAT32 || property.m_type == EPlyType::E_FLOAT64)
+								return toColorChannel(static_cast<float>(value));
+
+							return static_cast<uint8_t>(LibMath::clamp(static_cast<float>(value), 0.f, 255.f));
+						};
+
+						Vertex& vertex = vertices[i];
+						vertex.m_position = { static_cast<float>(read(0, 0.)), static_cast<float>(read(1, 0.)),
+							static_cast<float>(read(2, 0.)) };
+						vertex.m_normal = { static_cast<float>(read(3, 0.)), static_cast<float>(read(4, 0.)),
+							static_cast<float>(read(5, 0.)) };
+						vertex.m_color = Color(readChannel(6), readChannel(7), readChannel(8), readChannel(9));
+
+						// Like OBJ, the v axis goes up while the textures' rows go down
+						vertex.m_u = static_cast<float>(read(10, 0.));
+						vertex.m_v = 1.f - static_cast<float>(read(11, 1.));
+					}
+				}, ELEMENT_CHUNK_SIZE);
+
+				cursor += element.m_count * element.m_stride;
+			}
+			else if (element.m_name == "face")
+			{
+				const int32_t listIndex = findPlyProperty(element, { "vertex_indices", "vertex_index" });
+
+				if (listIndex < 0 || !element.m_properties[listIndex].m_isList)
+					throw std::runtime_error("Invalid PLY data: faces without vertex indices");
+
+				const PlyProperty& list = element.m_properties[listIndex];
+				const size_t countSize = getPlyTypeSize(list.m_countType);
+				const size_t indexSize = getPlyTypeSize(list.m_type);
+				const size_t triangleSize = countSize + indexSize * 3;
+
+				// Meshes made only of triangles have a fixed face size, which lets the faces be read in parallel
+				bool isTriangleList = element.m_properties.size() == 1
+					&& static_cast<size_t>(end - cursor) / triangleSize >= element.m_count;
+
+				if (isTriangleList)
+				{
+					std::atomic<bool> hasPolygons{ false };
+					const char* first = cursor;
+					indices.resize(element.m_count * 3);
+
+					threadPool.parallelFor(element.m_count, [&](const size_t p_begin, const size_t p_end)
+					{
+						for (size_t i = p_begin; i < p_end && !hasPolygons; i++)
+						{
+							const char* face = first + i * triangleSize;
+
+							if (readPlyValue(face, list.m_countType, isSwapped) != 3.)
+							{
+								hasPolygons = true;
+								return;
+							}
+
+							for (size_t corner = 0; corner < 3; corner++)
+							{
+								const double index = readPlyValue(face + countSize + corner * indexSize, list.m_type, isSwapped);
+								indices[i * 3 + corner] = index >= 0. && index < static_cast<double>(vertices.size()) ?
+									static_cast<uint32_t>(index) : MISSING_INDEX;
+							}
+						}
+					}, ELEMENT_CHUNK_SIZE);
+
+					isTriangleList = !hasPolygons;
+				}
+
+				if (isTriangleList)
+				{
+					cursor += element.m_count * triangleSize;
+				}
+				else
+				{
+					indices.clear();
+
+					for (size_t i = 0; i < element.m_count; i++)
+					{
+						const char* face = cursor;
+						const size_t faceSize = getPlyItemSize(element, face, end, isSwapped, p_data);
+
+						if (face + faceSize > end)
+							throw parseError("PLY", p_data, end);
+
+						const char* listData = face;
+
+						for (int32_t property = 0; property < listIndex; property++)
+							listData += getPlyPropertySize(element.m_properties[property], listData, end, isSwapped, p_data);
+
+						const size_t cornerCount = static_cast<size_t>(readPlyValue(listData, list.m_countType, isSwapped));
+						const char* corners = listData + countSize;
+
+						// Triangle fan around the first corner
+						for (size_t corner = 2; corner < cornerCount; corner++)
+						{
+							for (const size_t polygonCorner : { size_t(0), corner - 1, corner })
+							{
+								const double index = readPlyValue(corners + polygonCorner * indexSize, list.m_type, isSwapped);
+								indices.push_back(index >= 0. && index < static_cast<double>(vertices.size()) ?
+									static_cast<uint32_t>(index) : MISSING_INDEX);
+							}
+						}
+
+						cursor = face + faceSize;
+					}
+				}
+
+				if (std::find(indices.begin(), indices.end(), MISSING_INDEX) != indices.end())
+					throw std::runtime_error("Invalid PLY data: face index out of range");
+			}
+			else if (element.m_stride != 0)
+			{
+				if (static_cast<size_t>(end - cursor) / element.m_stride < element.m_count)
+					throw parseError("PLY", p_data, end);
+
+				cursor += element.m_count * element.m_stride;
+			}
+			else
+			{
+				for (size_t i = 0; i < element.m_count; i++)
+					cursor += getPlyItemSize(element, cursor, end, isSwapped, p_data);
+
+				if (cursor > end)
+					throw parseError("PLY", p_data, end);
+			}
+		}
+
+		return createImportedMesh(std::move(vertices), std::move(indices), hasNormals);
+	}
+}
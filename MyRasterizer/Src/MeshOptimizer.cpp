@@ -0,0 +1,435 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace My
+{
+	namespace
+	{
+		constexpr uint32_t	INVALID_INDEX = UINT32_MAX;
+
+		/**
+		 * \brief Emulates a first in first out cache by remembering when each vertex entered it
+		 */
+		class FifoCache
+		{
+		public:
+			FifoCache(const size_t p_vertexCount, const size_t p_cacheSize) :
+				m_timestamps(p_vertexCount, 0), m_cacheSize(p_cacheSize), m_time(p_cacheSize + 1)
+			{
+			}
+
+			/**
+			 * \brief Transforms the given triangle's vertices that aren't in the cache
+			 * \return The number of vertices that missed the cache
+			 */
+			size_t addTriangle(const size_t* p_vertices)
+			{
+				size_t missCount = 0;
+
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					size_t& timestamp = m_timestamps[p_vertices[corner]];
+
+					if (m_time - timestamp > m_cacheSize)
+					{
+						timestamp = m_time++;
+						missCount++;
+					}
+				}
+
+				return missCount;
+			}
+
+			/**
+			 * \brief Evicts every vertex from the cache
+			 */
+			void clear()
+			{
+				m_time += m_cacheSize + 1;
+			}
+
+		private:
+			std::vector<size_t>	m_timestamps;
+			size_t				m_cacheSize;
+			size_t				m_time;
+		};
+	}
+
+	void MeshOptimizer::optimizeVertexCache(std::vector<size_t>& p_indices, const size_t p_vertexCount)
+	{
+		const size_t triangleCount = p_indices.size() / 3;
+
+		if (triangleCount == 0)
+			return;
+
+		// The live triangles of each vertex are kept at the front of its adjacency range
+		std::vector<uint32_t> adjacencyOffsets(p_vertexCount + 1, 0);
+		std::vector<uint32_t> liveTriangleCounts(p_vertexCount, 0);
+
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			liveTriangleCounts[p_indices[i]]++;
+
+		std::partial_sum(liveTriangleCounts.begin(), liveTriangleCounts.end(), adjacencyOffsets.begin() + 1);
+
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+		for (size_t i = 0; i < triangleCount * 3; i++)
+			adjacency[cursors[p_indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		std::vector<int> cachePositions(p_vertexCount, -1);
+		std::vector<float> vertexScores(p_vertexCount);
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<uint8_t> isEmitted(triangleCount, 0);
+
+		for (size_t vertex = 0; vertex < p_vertexCount; vertex++)
+			vertexScores[vertex] = getVertexScore(-1, liveTriangleCounts[vertex]);
+
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			triangleScores[triangle] = vertexScores[p_indices[triangle * 3]]
+				+ vertexScores[p_indices[triangle * 3 + 1]] + vertexScores[p_indices[triangle * 3 + 2]];
+		}
+
+		// Three extra slots hold the vertices pushed out by the last triangle so their scores get updated
+		uint32_t cache[MAX_CACHE_SIZE + 3];
+		uint32_t nextCache[MAX_CACHE_SIZE + 3];
+		size_t cacheCount = 0;
+
+		std::vector<size_t> indices;
+		indices.reserve(triangleCount * 3);
+
+		size_t bestTriangle = static_cast<size_t>(std::max_element(triangleScores.begin(), triangleScores.end())
+			- triangleScores.begin());
+		size_t firstUnemitted = 0;
+
+		while (bestTriangle != INVALID_INDEX)
+		{
+			const size_t* vertices = &p_indices[bestTriangle * 3];
+
+			indices.insert(indices.end(), vertices, vertices + 3);
+			isEmitted[bestTriangle] = 1;
+
+			size_t nextCacheCount = 0;
+
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				const size_t vertex = vertices[corner];
+
+				// Degenerate triangles repeat a vertex, which is still only cached once
+				if (std::find(vertices, vertices + corner, vertex) == vertices + corner)
+					nextCache[nextCacheCount++] = static_cast<uint32_t>(vertex);
+
+				// Swaps the triangle out of the vertex's live range (once for each of its corners)
+				uint32_t* first = &adjacency[adjacencyOffsets[vertex]];
+				uint32_t* last = first + liveTriangleCounts[vertex] - 1;
+
+				*std::find(first, last + 1, static_cast<uint32_t>(bestTriangle)) = *last;
+				liveTriangleCounts[vertex]--;
+			}
+
+			for (size_t i = 0; i < cacheCount; i++)
+			{
+				const uint32_t vertex = cache[i];
+
+				if (vertex != vertices[0] && vertex != vertices[1] && vertex != vertices[2])
+					nextCache[nextCacheCount++] = vertex;
+			}
+
+			std::copy(nextCache, nextCache + nextCacheCount, cache);
+			cacheCount = std::min(nextCacheCount, MAX_CACHE_SIZE);
+
+			for (size_t i = 0; i < nextCacheCount; i++)
+			{
+				const uint32_t vertex = cache[i];
+				cachePositions[vertex] = i < MAX_CACHE_SIZE ? static_cast<int>(i) : -1;
+				vertexScores[vertex] = getVertexScore(cachePositions[vertex], liveTriangleCounts[vertex]);
+			}
+
+			// Only the triangles around the cached vertices changed score
+			bestTriangle = INVALID_INDEX;
+			float bestScore = -1.f;
+
+			for (size_t i = 0; i < nextCacheCount; i++)
+			{
+				const uint32_t vertex = cache[i];
+				const uint32_t first = adjacencyOffsets[vertex];
+
+				for (uint32_t j = first; j < first + liveTriangleCounts[vertex]; j++)
+				{
+					const uint32_t triangle = adjacency[j];
+
+					const float score = vertexScores[p_indices[triangle * 3]]
+						+ vertexScores[p_indices[triangle * 3 + 1]] + vertexScores[p_indices[triangle * 3 + 2]];
+
+					triangleScores[triangle] = score;
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = triangle;
+					}
+				}
+			}
+
+			// Nothing left around the cache - continue from any remaining triangle
+			if (bestTriangle == INVALID_INDEX)
+			{
+				while (firstUnemitted < triangleCount && isEmitted[firstUnemitted])
+					firstUnemitted++;
+
+				if (firstUnemitted < triangleCount)
+					bestTriangle = firstUnemitted;
+			}
+		}
+
+		p_indices.swap(indices);
+	}
+
+	void MeshOptimizer::optimizeOverdraw(std::vector<size_t>& p_indices, const std::vector<Vertex>& p_vertices,
+		const float p_threshold)
+	{
+		const size_t triangleCount = p_indices.size() / 3;
+
+		if (triangleCount == 0)
+			return;
+
+		std::vector<size_t> hardClusters;
+		findCacheRestarts(p_indices, p_vertices.size(), hardClusters);
+
+		// Splits the clusters further wherever their miss ratio so far is close enough to their whole miss ratio
+		std::vector<size_t> clusters;
+		FifoCache cache(p_vertices.size(), DEFAULT_CACHE_SIZE);
+
+		for (size_t i = 0; i + 1 < hardClusters.size(); i++)
+		{
+			const size_t start = hardClusters[i];
+			const size_t end = hardClusters[i + 1];
+
+			cache.clear();
+			size_t clusterMissCount = 0;
+
+			for (size_t triangle = start; triangle < end; triangle++)
+				clusterMissCount += cache.addTriangle(&p_indices[triangle * 3]);
+
+			const float maxMissRatio = static_cast<float>(clusterMissCount) / static_cast<float>(end - start)
+				* p_threshold;
+
+			cache.clear();
+			clusters.push_back(start);
+
+			size_t clusterStart = start;
+			size_t missCount = 0;
+
+			for (size_t triangle = start; triangle < end; triangle++)
+			{
+				missCount += cache.addTriangle(&p_indices[triangle * 3]);
+
+				const size_t clusterSize = triangle + 1 - clusterStart;
+
+				if (clusterSize >= MIN_CLUSTER_SIZE && triangle + 1 < end
+					&& static_cast<float>(missCount) <= maxMissRatio * static_cast<float>(clusterSize))
+				{
+					clusterStart = triangle + 1;
+					clusters.push_back(clusterStart);
+
+					cache.clear();
+					missCount = 0;
+				}
+			}
+		}
+
+		clusters.push_back(triangleCount);
+
+		const size_t clusterCount = clusters.size() - 1;
+
+		// Area weighted centroid and normal of each cluster
+		std::vector<LibMath::Vector3> centroids(clusterCount);
+		std::vector<LibMath::Vector3> normals(clusterCount);
+		LibMath::Vector3 meshCentroid;
+		float meshArea = 0.f;
+
+		for (size_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			float centroid[3] = { 0.f, 0.f, 0.f };
+			float normal[3] = { 0.f, 0.f, 0.f };
+			float clusterArea = 0.f;
+
+			for (size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++)
+			{
+				const LibMath::Vector3& a = p_vertices[p_indices[triangle * 3]].m_position;
+				const LibMath::Vector3& b = p_vertices[p_indices[triangle * 3 + 1]].m_position;
+				const LibMath::Vector3& c = p_vertices[p_indices[triangle * 3 + 2]].m_position;
+
+				const float ab[3] = { b.m_x - a.m_x, b.m_y - a.m_y, b.m_z - a.m_z };
+				const float ac[3] = { c.m_x - a.m_x, c.m_y - a.m_y, c.m_z - a.m_z };
+
+				// The cross product's length is twice the triangle's area
+				const float cross[3] =
+				{
+					ab[1] * ac[2] - ab[2] * ac[1],
+					ab[2] * ac[0] - ab[0] * ac[2],
+					ab[0] * ac[1] - ab[1] * ac[0]
+				};
+
+				const float area = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+				centroid[0] += (a.m_x + b.m_x + c.m_x) * area / 3.f;
+				centroid[1] += (a.m_y + b.m_y + c.m_y) * area / 3.f;
+				centroid[2] += (a.m_z + b.m_z + c.m_z) * area / 3.f;
+
+				for (size_t axis = 0; axis < 3; axis++)
+					normal[axis] += cross[axis];
+
+				clusterArea += area;
+			}
+
+			const float invArea = clusterArea > 0.f ? 1.f / clusterArea : 0.f;
+
+			centroids[cluster] = { centroid[0] * invArea, centroid[1] * invArea, centroid[2] * invArea };
+
+			const float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			const float invNormalLength = normalLength > 0.f ? 1.f / normalLength : 0.f;
+
+			normals[cluster] = { normal[0] * invNormalLength, normal[1] * invNormalLength, normal[2] * invNormalLength };
+
+			meshCentroid.m_x += centroid[0];
+			meshCentroid.m_y += centroid[1];
+			meshCentroid.m_z += centroid[2];
+			meshArea += clusterArea;
+		}
+
+		if (meshArea > 0.f)
+		{
+			meshCentroid.m_x /= meshArea;
+			meshCentroid.m_y /= meshArea;
+			meshCentroid.m_z /= meshArea;
+		}
+
+		// Clusters facing away from the mesh's center hide the others from most view points
+		std::vector<float> sortKeys(clusterCount);
+
+		for (size_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			const LibMath::Vector3& centroid = centroids[cluster];
+			const LibMath::Vector3& normal = normals[cluster];
+
+			sortKeys[cluster] = (centroid.m_x - meshCentroid.m_x) * normal.m_x
+				+ (centroid.m_y - meshCentroid.m_y) * normal.m_y + (centroid.m_z - meshCentroid.m_z) * normal.m_z;
+		}
+
+		std::vector<size_t> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0);
+
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](const size_t p_lhs, const size_t p_rhs)
+		{
+			return sortKeys[p_lhs] > sortKeys[p_rhs];
+		});
+
+		std::vector<size_t> indices;
+		indices.reserve(p_indices.size());
+
+		for (const size_t cluster : order)
+		{
+			indices.insert(indices.end(), p_indices.begin() + static_cast<std::ptrdiff_t>(clusters[cluster] * 3),
+				p_indices.begin() + static_cast<std::ptrdiff_t>(clusters[cluster + 1] * 3));
+		}
+
+		p_indices.swap(indices);
+	}
+
+	void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& p_vertices, std::vector<size_t>& p_indices)
+	{
+		std::vector<uint32_t> remap(p_vertices.size(), INVALID_INDEX);
+		std::vector<Vertex> vertices;
+		vertices.reserve(p_vertices.size());
+
+		for (size_t& index : p_indices)
+		{
+			if (remap[index] == INVALID_INDEX)
+			{
+				remap[index] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(p_vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		for (size_t vertex = 0; vertex < p_vertices.size(); vertex++)
+		{
+			if (remap[vertex] == INVALID_INDEX)
+				vertices.push_back(p_vertices[vertex]);
+		}
+
+		p_vertices.swap(vertices);
+	}
+
+	float MeshOptimizer::getCacheMissRatio(const std::vector<size_t>& p_indices, const size_t p_vertexCount,
+		const size_t p_cacheSize)
+	{
+		const size_t triangleCount = p_indices.size() / 3;
+
+		if (triangleCount == 0)
+			return 0.f;
+
+		FifoCache cache(p_vertexCount, p_cacheSize);
+		size_t missCount = 0;
+
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+			missCount += cache.addTriangle(&p_indices[triangle * 3]);
+
+		return static_cast<float>(missCount) / static_cast<float>(triangleCount);
+	}
+
+	float MeshOptimizer::getVertexScore(const int p_cachePosition, const uint32_t p_liveTriangleCount)
+	{
+		// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+		static constexpr float CACHE_DECAY_POWER = 1.5f;
+		static constexpr float LAST_TRIANGLE_SCORE = .75f;
+		static constexpr float VALENCE_BOOST_SCALE = 2.f;
+		static constexpr float VALENCE_BOOST_POWER = .5f;
+
+		// Used by no more triangles
+		if (p_liveTriangleCount == 0)
+			return -1.f;
+
+		float score = 0.f;
+
+		if (p_cachePosition >= 0)
+		{
+			// The last triangle's vertices get the same score whatever their order to avoid favouring strips
+			if (p_cachePosition < 3)
+			{
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				const float scaler = 1.f / static_cast<float>(MAX_CACHE_SIZE - 3);
+				score = powf(1.f - static_cast<float>(p_cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+
+		// Finishing off the vertices with few triangles left frees the cache sooner
+		return score + VALENCE_BOOST_SCALE * powf(static_cast<float>(p_liveTriangleCount), -VALENCE_BOOST_POWER);
+	}
+
+	void MeshOptimizer::findCacheRestarts(const std::vector<size_t>& p_indices, const size_t p_vertexCount,
+		std::vector<size_t>& p_clusters)
+	{
+		const size_t triangleCount = p_indices.size() / 3;
+
+		FifoCache cache(p_vertexCount, DEFAULT_CACHE_SIZE);
+		p_clusters.push_back(0);
+
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			if (cache.addTriangle(&p_indices[triangle * 3]) == 3 && triangle != 0)
+				p_clusters.push_back(triangle);
+		}
+
+		p_clusters.push_back(triangleCount);
+	}
+}
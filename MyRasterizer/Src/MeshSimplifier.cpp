@@ -0,0 +1,737 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+namespace My
+{
+	namespace
+	{
+		struct PositionKey
+		{
+			float	m_x;
+			float	m_y;
+			float	m_z;
+
+			bool operator==(const PositionKey& p_other) const
+			{
+				return m_x == p_other.m_x && m_y == p_other.m_y && m_z == p_other.m_z;
+			}
+		};
+
+		struct PositionHash
+		{
+			size_t operator()(const PositionKey& p_key) const
+			{
+				uint32_t bits[3];
+				std::memcpy(bits, &p_key, sizeof(bits));
+
+				// Folds -0 onto 0 so both welds together
+				for (uint32_t& component : bits)
+					component = component == 0x80000000u ? 0u : component;
+
+				return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+			}
+		};
+
+		void cross(const float* p_a, const float* p_b, float* p_result)
+		{
+			p_result[0] = p_a[1] * p_b[2] - p_a[2] * p_b[1];
+			p_result[1] = p_a[2] * p_b[0] - p_a[0] * p_b[2];
+			p_result[2] = p_a[0] * p_b[1] - p_a[1] * p_b[0];
+		}
+
+		float dot(const float* p_a, const float* p_b)
+		{
+			return p_a[0] * p_b[0] + p_a[1] * p_b[1] + p_a[2] * p_b[2];
+		}
+
+		/**
+		 * \brief Computes the non normalized normal of the given triangle
+		 */
+		void triangleNormal(const float* p_a, const float* p_b, const float* p_c, float* p_normal)
+		{
+			const float ab[3] = { p_b[0] - p_a[0], p_b[1] - p_a[1], p_b[2] - p_a[2] };
+			const float ac[3] = { p_c[0] - p_a[0], p_c[1] - p_a[1], p_c[2] - p_a[2] };
+
+			cross(ab, ac, p_normal);
+		}
+
+		template <typename TQuadric>
+		void addPlane(TQuadric& p_quadric, const float* p_normal, const double p_distance, const double p_weight)
+		{
+			const double x = p_normal[0];
+			const double y = p_normal[1];
+			const double z = p_normal[2];
+
+			p_quadric.m_a00 += p_weight * x * x;
+			p_quadric.m_a11 += p_weight * y * y;
+			p_quadric.m_a22 += p_weight * z * z;
+			p_quadric.m_a01 += p_weight * x * y;
+			p_quadric.m_a02 += p_weight * x * z;
+			p_quadric.m_a12 += p_weight * y * z;
+			p_quadric.m_b0 += p_weight * x * p_distance;
+			p_quadric.m_b1 += p_weight * y * p_distance;
+			p_quadric.m_b2 += p_weight * z * p_distance;
+			p_quadric.m_c += p_weight * p_distance * p_distance;
+			p_quadric.m_weight += p_weight;
+		}
+
+		template <typename TQuadric>
+		void addQuadric(TQuadric& p_quadric, const TQuadric& p_other)
+		{
+			p_quadric.m_a00 += p_other.m_a00;
+			p_quadric.m_a11 += p_other.m_a11;
+			p_quadric.m_a22 += p_other.m_a22;
+			p_quadric.m_a01 += p_other.m_a01;
+			p_quadric.m_a02 += p_other.m_a02;
+			p_quadric.m_a12 += p_other.m_a12;
+			p_quadric.m_b0 += p_other.m_b0;
+			p_quadric.m_b1 += p_other.m_b1;
+			p_quadric.m_b2 += p_other.m_b2;
+			p_quadric.m_c += p_other.m_c;
+			p_quadric.m_weight += p_other.m_weight;
+		}
+
+		template <typename TQuadric>
+		float evaluate(const TQuadric& p_quadric, const float* p_point)
+		{
+			const double x = p_point[0];
+			const double y = p_point[1];
+			const double z = p_point[2];
+
+			const double error = p_quadric.m_a00 * x * x + p_quadric.m_a11 * y * y + p_quadric.m_a22 * z * z
+				+ 2. * (p_quadric.m_a01 * x * y + p_quadric.m_a02 * x * z + p_quadric.m_a12 * y * z)
+				+ 2. * (p_quadric.m_b0 * x + p_quadric.m_b1 * y + p_quadric.m_b2 * z)
+				+ p_quadric.m_c;
+
+			// Rounding can make the error of a point on all the planes slightly negative
+			return static_cast<float>(std::max(error, 0.));
+		}
+	}
+
+	MeshSimplifier::MeshSimplifier(const Mesh& p_mesh) :
+		m_vertices(p_mesh.decodeVertices())
+	{
+		const IndexBuffer& indices = p_mesh.getIndices();
+
+		if (m_vertices.size() >= INVALID_INDEX)
+			throw std::invalid_argument("Mesh has too many vertices to be simplified: " + std::to_string(m_vertices.size()));
+
+		const size_t vertexCount = m_vertices.size();
+
+		// Vertices only differing by their attributes share a position
+		m_positionIds.resize(vertexCount);
+
+		std::unordered_map<PositionKey, uint32_t, PositionHash> positionIds;
+		positionIds.reserve(vertexCount);
+
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			const LibMath::Vector3& position = m_vertices[i].m_position;
+			m_positionIds[i] = positionIds.emplace(PositionKey{ position.m_x, position.m_y, position.m_z }, i).first->second;
+		}
+
+		// Triangles collapsed from the start would break the adjacency
+		m_indices.reserve(indices.size());
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const uint32_t a = static_cast<uint32_t>(indices[i]);
+			const uint32_t b = static_cast<uint32_t>(indices[i + 1]);
+			const uint32_t c = static_cast<uint32_t>(indices[i + 2]);
+
+			if (m_positionIds[a] == m_positionIds[b] || m_positionIds[b] == m_positionIds[c]
+				|| m_positionIds[c] == m_positionIds[a])
+				continue;
+
+			m_indices.insert(m_indices.end(), { a, b, c });
+		}
+
+		// Keeps the quadrics' precision independent of the mesh's size and location
+		const AABB& bounds = p_mesh.getBoundingBox();
+		const LibMath::Vector3 size = bounds.m_max - bounds.m_min;
+		const float maxSize = std::max({ size.m_x, size.m_y, size.m_z });
+		const float scale = maxSize > 0.f ? 1.f / maxSize : 1.f;
+
+		m_positions.resize(vertexCount * 3);
+
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			const LibMath::Vector3& position = m_vertices[i].m_position;
+
+			m_positions[i * 3] = (position.m_x - bounds.m_min.m_x) * scale;
+			m_positions[i * 3 + 1] = (position.m_y - bounds.m_min.m_y) * scale;
+			m_positions[i * 3 + 2] = (position.m_z - bounds.m_min.m_z) * scale;
+		}
+
+		buildAdjacency();
+		classifyVertices();
+		initQuadrics();
+	}
+
+	size_t MeshSimplifier::getTriangleCount() const
+	{
+		return m_indices.size() / 3;
+	}
+
+	float MeshSimplifier::getError() const
+	{
+		return m_error;
+	}
+
+	void MeshSimplifier::simplify(const size_t p_targetTriangleCount)
+	{
+		bool isErrorLimited = true;
+
+		while (getTriangleCount() > p_targetTriangleCount)
+		{
+			if (!m_isAdjacencyValid)
+			{
+				buildAdjacency();
+				classifyVertices();
+			}
+
+			collectCollapses(p_targetTriangleCount, isErrorLimited);
+
+			if (m_collapses.empty())
+				break;
+
+			if (performCollapses(p_targetTriangleCount) == 0)
+			{
+				// Every cheap collapse was rejected - try the expensive ones before giving up
+				if (!isErrorLimited)
+					break;
+
+				isErrorLimited = false;
+				continue;
+			}
+
+			isErrorLimited = true;
+			applyCollapses();
+		}
+	}
+
+	Mesh MeshSimplifier::createMesh() const
+	{
+		std::vector<uint32_t> newIndices(m_vertices.size(), INVALID_INDEX);
+		std::vector<Vertex> vertices;
+		std::vector<size_t> indices;
+
+		indices.reserve(m_indices.size());
+
+		for (const uint32_t index : m_indices)
+		{
+			if (newIndices[index] == INVALID_INDEX)
+			{
+				newIndices[index] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(m_vertices[index]);
+			}
+
+			indices.push_back(newIndices[index]);
+		}
+
+		return { vertices, indices };
+	}
+
+	void MeshSimplifier::buildAdjacency()
+	{
+		const size_t vertexCount = m_vertices.size();
+
+		m_adjacencyOffsets.assign(vertexCount + 1, 0);
+
+		for (const uint32_t index : m_indices)
+			m_adjacencyOffsets[m_positionIds[index] + 1]++;
+
+		std::partial_sum(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end(), m_adjacencyOffsets.begin());
+
+		m_adjacency.resize(m_indices.size());
+
+		std::vector<uint32_t> cursors(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+
+		for (size_t i = 0; i < m_indices.size(); i++)
+			m_adjacency[cursors[m_positionIds[m_indices[i]]]++] = static_cast<uint32_t>(i / 3);
+
+		m_isAdjacencyValid = true;
+	}
+
+	void MeshSimplifier::classifyVertices()
+	{
+		m_edgeFlags.assign(m_indices.size(), 0);
+
+		ThreadPool::getDefault().parallelFor(getTriangleCount(), [this](const size_t p_begin, const size_t p_end)
+		{
+			for (size_t triangle = p_begin; triangle < p_end; triangle++)
+			{
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					const uint32_t a = m_indices[triangle * 3 + corner];
+					const uint32_t b = m_indices[triangle * 3 + (corner + 1) % 3];
+					const uint32_t positionA = m_positionIds[a];
+					const uint32_t positionB = m_positionIds[b];
+
+					size_t twinCount = 0;
+					bool isSameVertices = false;
+
+					// The twin goes from b to a in one of the triangles around b
+					for (uint32_t i = m_adjacencyOffsets[positionB]; i < m_adjacencyOffsets[positionB + 1]; i++)
+					{
+						const uint32_t* other = &m_indices[static_cast<size_t>(m_adjacency[i]) * 3];
+
+						for (size_t otherCorner = 0; otherCorner < 3; otherCorner++)
+						{
+							const uint32_t c = other[otherCorner];
+							const uint32_t d = other[(otherCorner + 1) % 3];
+
+							if (m_positionIds[c] == positionB && m_positionIds[d] == positionA)
+							{
+								twinCount++;
+								isSameVertices |= c == b && d == a;
+							}
+						}
+					}
+
+					uint8_t& flags = m_edgeFlags[triangle * 3 + corner];
+
+					if (twinCount == 0)
+						flags = E_OPEN_EDGE;
+					else if (twinCount > 1)
+						flags = E_COMPLEX_EDGE;
+					else if (!isSameVertices)
+						flags = E_SEAM_EDGE;
+				}
+			}
+		}, 1024);
+
+		const size_t vertexCount = m_vertices.size();
+
+		std::vector<uint8_t> openCounts(vertexCount, 0);
+		std::vector<uint8_t> seamCounts(vertexCount, 0);
+		std::vector<uint8_t> isComplex(vertexCount, 0);
+		std::vector<uint32_t> firstVertices(vertexCount, INVALID_INDEX);
+
+		const auto increment = [](uint8_t& p_count)
+		{
+			p_count = static_cast<uint8_t>(std::min(p_count + 1, static_cast<int>(UINT8_MAX)));
+		};
+
+		for (size_t i = 0; i < m_indices.size(); i++)
+		{
+			const uint32_t vertex = m_indices[i];
+			const uint32_t position = m_positionIds[vertex];
+			const uint32_t nextPosition = m_positionIds[m_indices[i - i % 3 + (i + 1) % 3]];
+			const uint8_t flags = m_edgeFlags[i];
+
+			// Only seams may have several vertices at the same position
+			if (firstVertices[position] == INVALID_INDEX)
+				firstVertices[position] = vertex;
+			else if (firstVertices[position] != vertex)
+				isComplex[position] |= 2;
+
+			if (flags & E_COMPLEX_EDGE)
+			{
+				isComplex[position] = 1;
+				isComplex[nextPosition] = 1;
+			}
+
+			if (flags & E_OPEN_EDGE)
+			{
+				increment(openCounts[position]);
+				increment(openCounts[nextPosition]);
+			}
+
+			if (flags & E_SEAM_EDGE)
+			{
+				increment(seamCounts[position]);
+				increment(seamCounts[nextPosition]);
+			}
+		}
+
+		m_kinds.assign(vertexCount, EVertexKind::E_LOCKED);
+
+		for (size_t position = 0; position < vertexCount; position++)
+		{
+			if (m_positionIds[position] != position || (isComplex[position] & 1))
+				continue;
+
+			const bool isSingleVertex = (isComplex[position] & 2) == 0;
+
+			// Each edge is seen from both its ends and seams from both of their sides
+			if (openCounts[position] == 0 && seamCounts[position] == 0 && isSingleVertex)
+				m_kinds[position] = EVertexKind::E_MANIFOLD;
+			else if (openCounts[position] == 2 && seamCounts[position] == 0 && isSingleVertex)
+				m_kinds[position] = EVertexKind::E_BORDER;
+			else if (openCounts[position] == 0 && seamCounts[position] == 4)
+				m_kinds[position] = EVertexKind::E_SEAM;
+		}
+	}
+
+	void MeshSimplifier::initQuadrics()
+	{
+		m_quadrics.assign(m_vertices.size(), {});
+
+		ThreadPool::getDefault().parallelFor(m_vertices.size(), [this](const size_t p_begin, const size_t p_end)
+		{
+			for (size_t position = p_begin; position < p_end; position++)
+			{
+				if (m_positionIds[position] != position)
+					continue;
+
+				Quadric& quadric = m_quadrics[position];
+
+				for (uint32_t i = m_adjacencyOffsets[position]; i < m_adjacencyOffsets[position + 1]; i++)
+				{
+					const size_t triangle = m_adjacency[i];
+					const uint32_t* vertices = &m_indices[triangle * 3];
+
+					const float* a = &m_positions[static_cast<size_t>(vertices[0]) * 3];
+					const float* b = &m_positions[static_cast<size_t>(vertices[1]) * 3];
+					const float* c = &m_positions[static_cast<size_t>(vertices[2]) * 3];
+
+					float normal[3];
+					triangleNormal(a, b, c, normal);
+
+					const float doubleArea = sqrtf(dot(normal, normal));
+
+					if (doubleArea == 0.f)
+						continue;
+
+					for (float& component : normal)
+						component /= doubleArea;
+
+					addPlane(quadric, normal, -dot(normal, a), doubleArea * .5f);
+
+					// Borders and seams are held in place by a plane perpendicular to the triangle
+					for (size_t corner = 0; corner < 3; corner++)
+					{
+						if ((m_edgeFlags[triangle * 3 + corner] & (E_OPEN_EDGE | E_SEAM_EDGE)) == 0)
+							continue;
+
+						const uint32_t start = vertices[corner];
+						const uint32_t end = vertices[(corner + 1) % 3];
+
+						if (m_positionIds[start] != position && m_positionIds[end] != position)
+							continue;
+
+						const float* startPosition = &m_positions[static_cast<size_t>(start) * 3];
+						const float* endPosition = &m_positions[static_cast<size_t>(end) * 3];
+
+						const float edge[3] =
+						{
+							endPosition[0] - startPosition[0],
+							endPosition[1] - startPosition[1],
+							endPosition[2] - startPosition[2]
+						};
+
+						float edgeNormal[3];
+						cross(edge, normal, edgeNormal);
+
+						const float length = sqrtf(dot(edgeNormal, edgeNormal));
+
+						if (length == 0.f)
+							continue;
+
+						for (float& component : edgeNormal)
+							component /= length;
+
+						addPlane(quadric, edgeNormal, -dot(edgeNormal, startPosition), dot(edge, edge) * EDGE_WEIGHT);
+					}
+				}
+			}
+		}, 1024);
+	}
+
+	void MeshSimplifier::collectCollapses(const size_t p_targetTriangleCount, const bool p_isErrorLimited)
+	{
+		m_collapses.resize(m_indices.size());
+
+		const auto canCollapse = [this](const uint32_t p_source, const uint32_t p_target, const uint8_t p_flags)
+		{
+			switch (m_kinds[p_source])
+			{
+			case EVertexKind::E_MANIFOLD:
+				return true;
+			case EVertexKind::E_BORDER:
+				return (p_flags & E_OPEN_EDGE) != 0 && m_kinds[p_target] != EVertexKind::E_MANIFOLD
+					&& m_kinds[p_target] != EVertexKind::E_SEAM;
+			case EVertexKind::E_SEAM:
+				return (p_flags & E_SEAM_EDGE) != 0 && m_kinds[p_target] != EVertexKind::E_MANIFOLD
+					&& m_kinds[p_target] != EVertexKind::E_BORDER;
+			default:
+				return false;
+			}
+		};
+
+		ThreadPool::getDefault().parallelFor(m_indices.size(), [this, &canCollapse](const size_t p_begin, const size_t p_end)
+		{
+			for (size_t i = p_begin; i < p_end; i++)
+			{
+				const uint32_t a = m_indices[i];
+				const uint32_t b = m_indices[i - i % 3 + (i + 1) % 3];
+				const uint32_t positionA = m_positionIds[a];
+				const uint32_t positionB = m_positionIds[b];
+				const uint8_t flags = m_edgeFlags[i];
+
+				Collapse& collapse = m_collapses[i];
+				collapse = { a, b, INFINITY };
+
+				// Shared edges are handled by the half-edge going to the higher position
+				if ((flags & E_COMPLEX_EDGE) != 0 || (positionA > positionB && (flags & E_OPEN_EDGE) == 0))
+					continue;
+
+				const Quadric& quadricA = m_quadrics[positionA];
+				const Quadric& quadricB = m_quadrics[positionB];
+
+				if (canCollapse(positionA, positionB, flags))
+				{
+					const float* target = &m_positions[static_cast<size_t>(positionB) * 3];
+					collapse.m_error = evaluate(quadricA, target) + evaluate(quadricB, target);
+				}
+
+				if (canCollapse(positionB, positionA, flags))
+				{
+					const float* target = &m_positions[static_cast<size_t>(positionA) * 3];
+					const float error = evaluate(quadricA, target) + evaluate(quadricB, target);
+
+					if (error < collapse.m_error)
+						collapse = { b, a, error };
+				}
+			}
+		}, 1024);
+
+		m_collapses.erase(std::remove_if(m_collapses.begin(), m_collapses.end(),
+			[](const Collapse& p_collapse) { return p_collapse.m_error == INFINITY; }), m_collapses.end());
+
+		const auto isCheaper = [](const Collapse& p_lhs, const Collapse& p_rhs)
+		{
+			return p_lhs.m_error < p_rhs.m_error;
+		};
+
+		// Most collapses remove two triangles
+		const size_t wantedCount = (getTriangleCount() - p_targetTriangleCount + 1) / 2;
+
+		// Only the collapses close to the pass' expected error are worth sorting
+		if (p_isErrorLimited && wantedCount < m_collapses.size())
+		{
+			std::nth_element(m_collapses.begin(), m_collapses.begin() + wantedCount, m_collapses.end(), isCheaper);
+
+			const float maxError = m_collapses[wantedCount].m_error * PASS_ERROR_MARGIN;
+
+			m_collapses.erase(std::partition(m_collapses.begin(), m_collapses.end(),
+				[maxError](const Collapse& p_collapse) { return p_collapse.m_error <= maxError; }), m_collapses.end());
+		}
+
+		std::sort(m_collapses.begin(), m_collapses.end(), isCheaper);
+	}
+
+	size_t MeshSimplifier::performCollapses(const size_t p_targetTriangleCount)
+	{
+		const size_t vertexCount = m_vertices.size();
+
+		m_vertexRemap.resize(vertexCount);
+		m_positionRemap.resize(vertexCount);
+		std::iota(m_vertexRemap.begin(), m_vertexRemap.end(), 0u);
+		std::iota(m_positionRemap.begin(), m_positionRemap.end(), 0u);
+		m_isLocked.assign(vertexCount, 0);
+
+		const size_t triangleCount = getTriangleCount();
+		size_t removedCount = 0;
+
+		for (const Collapse& collapse : m_collapses)
+		{
+			if (triangleCount - removedCount <= p_targetTriangleCount)
+				break;
+
+			const uint32_t source = m_positionIds[collapse.m_source];
+			const uint32_t target = m_positionIds[collapse.m_target];
+
+			// Keeps the positions each collapse checked from moving again in the same pass
+			if (m_isLocked[source] || m_isLocked[target])
+				continue;
+
+			// The vertices on the seam's other side slide along the same edge
+			uint32_t otherSource = INVALID_INDEX;
+			uint32_t otherTarget = INVALID_INDEX;
+
+			if (m_kinds[source] == EVertexKind::E_SEAM)
+			{
+				for (uint32_t i = m_adjacencyOffsets[source]; i < m_adjacencyOffsets[source + 1]; i++)
+				{
+					const uint32_t* vertices = &m_indices[static_cast<size_t>(m_adjacency[i]) * 3];
+
+					for (size_t corner = 0; corner < 3; corner++)
+					{
+						if (m_positionIds[vertices[corner]] != source || vertices[corner] == collapse.m_source)
+							continue;
+
+						otherSource = vertices[corner];
+
+						const uint32_t next = vertices[(corner + 1) % 3];
+						const uint32_t previous = vertices[(corner + 2) % 3];
+
+						if (m_positionIds[next] == target)
+							otherTarget = next;
+						else if (m_positionIds[previous] == target)
+							otherTarget = previous;
+					}
+				}
+
+				if (otherSource == INVALID_INDEX || otherTarget == INVALID_INDEX)
+					continue;
+			}
+
+			size_t collapseRemovedCount = 0;
+
+			if (!isCollapseValid(source, target, collapseRemovedCount))
+				continue;
+
+			m_positionRemap[source] = target;
+			m_vertexRemap[collapse.m_source] = collapse.m_target;
+
+			if (otherSource != INVALID_INDEX)
+				m_vertexRemap[otherSource] = otherTarget;
+
+			addQuadric(m_quadrics[target], m_quadrics[source]);
+
+			const Quadric& quadric = m_quadrics[target];
+
+			if (quadric.m_weight > 0.)
+				m_error = std::max(m_error, static_cast<float>(sqrt(collapse.m_error / quadric.m_weight)));
+
+			m_isLocked[source] = 1;
+			m_isLocked[target] = 1;
+			removedCount += collapseRemovedCount;
+		}
+
+		return removedCount;
+	}
+
+	bool MeshSimplifier::isCollapseValid(const uint32_t p_source, const uint32_t p_target, size_t& p_removedCount)
+	{
+		m_sourceNeighbours.clear();
+		m_targetNeighbours.clear();
+
+		const auto addNeighbour = [](std::vector<uint32_t>& p_neighbours, const uint32_t p_position)
+		{
+			if (std::find(p_neighbours.begin(), p_neighbours.end(), p_position) == p_neighbours.end())
+				p_neighbours.push_back(p_position);
+		};
+
+		const float* targetPosition = &m_positions[static_cast<size_t>(p_target) * 3];
+		size_t sharedCount = 0;
+
+		for (uint32_t i = m_adjacencyOffsets[p_source]; i < m_adjacencyOffsets[p_source + 1]; i++)
+		{
+			const uint32_t* vertices = &m_indices[static_cast<size_t>(m_adjacency[i]) * 3];
+
+			const uint32_t positions[3] =
+			{
+				resolve(m_positionIds[vertices[0]]),
+				resolve(m_positionIds[vertices[1]]),
+				resolve(m_positionIds[vertices[2]])
+			};
+
+			// Already removed by an earlier collapse of the pass
+			if (positions[0] == positions[1] || positions[1] == positions[2] || positions[2] == positions[0])
+				continue;
+
+			if (positions[0] == p_target || positions[1] == p_target || positions[2] == p_target)
+			{
+				sharedCount++;
+				continue;
+			}
+
+			const float* corners[3];
+			const float* movedCorners[3];
+
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				corners[corner] = &m_positions[static_cast<size_t>(positions[corner]) * 3];
+				movedCorners[corner] = positions[corner] == p_source ? targetPosition : corners[corner];
+
+				if (positions[corner] != p_source)
+					addNeighbour(m_sourceNeighbours, positions[corner]);
+			}
+
+			float normal[3];
+			float movedNormal[3];
+			triangleNormal(corners[0], corners[1], corners[2], normal);
+			triangleNormal(movedCorners[0], movedCorners[1], movedCorners[2], movedNormal);
+
+			// Rejects flipped triangles as well as the ones turned almost edge-on
+			if (dot(normal, movedNormal) <= 1e-2f * sqrtf(dot(normal, normal) * dot(movedNormal, movedNormal)))
+				return false;
+		}
+
+		// Link condition: the ends may only share the neighbours of the removed triangles
+		for (uint32_t i = m_adjacencyOffsets[p_target]; i < m_adjacencyOffsets[p_target + 1]; i++)
+		{
+			const uint32_t* vertices = &m_indices[static_cast<size_t>(m_adjacency[i]) * 3];
+
+			const uint32_t positions[3] =
+			{
+				resolve(m_positionIds[vertices[0]]),
+				resolve(m_positionIds[vertices[1]]),
+				resolve(m_positionIds[vertices[2]])
+			};
+
+			if (positions[0] == positions[1] || positions[1] == positions[2] || positions[2] == positions[0])
+				continue;
+
+			for (const uint32_t position : positions)
+			{
+				if (position != p_target && position != p_source)
+					addNeighbour(m_targetNeighbours, position);
+			}
+		}
+
+		size_t commonCount = 0;
+
+		for (const uint32_t neighbour : m_sourceNeighbours)
+		{
+			if (std::find(m_targetNeighbours.begin(), m_targetNeighbours.end(), neighbour) != m_targetNeighbours.end())
+				commonCount++;
+		}
+
+		if (sharedCount == 0 || commonCount != sharedCount)
+			return false;
+
+		p_removedCount = sharedCount;
+		return true;
+	}
+
+	void MeshSimplifier::applyCollapses()
+	{
+		size_t writeIndex = 0;
+
+		for (size_t i = 0; i + 2 < m_indices.size(); i += 3)
+		{
+			const uint32_t a = m_vertexRemap[m_indices[i]];
+			const uint32_t b = m_vertexRemap[m_indices[i + 1]];
+			const uint32_t c = m_vertexRemap[m_indices[i + 2]];
+
+			if (m_positionIds[a] == m_positionIds[b] || m_positionIds[b] == m_positionIds[c]
+				|| m_positionIds[c] == m_positionIds[a])
+				continue;
+
+			m_indices[writeIndex++] = a;
+			m_indices[writeIndex++] = b;
+			m_indices[writeIndex++] = c;
+		}
+
+		m_indices.resize(writeIndex);
+		m_isAdjacencyValid = false;
+	}
+
+	uint32_t MeshSimplifier::resolve(const uint32_t p_position) const
+	{
+		return m_positionRemap[p_position];
+	}
+}
@@ -0,0 +1,278 @@
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+#include <stdexcept>
+#include <string>
+
+#include "Mesh.h"
+
+namespace My
+{
+	OcclusionBuffer::OcclusionBuffer(const uint32_t p_width, const uint32_t p_height)
+		: m_width(p_width), m_height(p_height)
+	{
+		// The rows are processed four pixels at a time
+		if (p_width == 0 || p_width % 4 != 0 || p_height == 0)
+			throw std::invalid_argument("Occlusion buffer width must be a non-zero multiple of 4 and its height non-zero."
+				" Received: " + std::to_string(p_width) + "x" + std::to_string(p_height));
+
+		m_depths.resize(static_cast<size_t>(m_width) * m_height, INFINITY);
+	}
+
+	uint32_t OcclusionBuffer::getWidth() const
+	{
+		return m_width;
+	}
+
+	uint32_t OcclusionBuffer::getHeight() const
+	{
+		return m_height;
+	}
+
+	void OcclusionBuffer::clear(const Mat4& p_viewProjection)
+	{
+		std::fill(m_depths.begin(), m_depths.end(), INFINITY);
+
+		for (size_t i = 0; i < 16; i++)
+			m_viewProjection[i] = p_viewProjection[i];
+	}
+
+	void OcclusionBuffer::rasterizeOccluder(const Mesh& p_mesh, const Mat4& p_transform)
+	{
+		float mvp[16];
+
+		for (size_t row = 0; row < 4; row++)
+		{
+			for (size_t col = 0; col < 4; col++)
+			{
+				mvp[row * 4 + col] = m_viewProjection[row * 4] * p_transform[col]
+					+ m_viewProjection[row * 4 + 1] * p_transform[4 + col]
+					+ m_viewProjection[row * 4 + 2] * p_transform[8 + col]
+					+ m_viewProjection[row * 4 + 3] * p_transform[12 + col];
+			}
+		}
+
+		const IndexBuffer& indexBuffer = p_mesh.getIndices();
+		const size_t vertexCount = p_mesh.getVertexCount();
+
+		std::vector<ScreenVertex> screenVertices(vertexCount);
+		std::vector<uint8_t> isInFront(vertexCount);
+
+		if (p_mesh.hasCompressedVertices())
+		{
+			const std::vector<PackedVertex>& vertices = p_mesh.getPackedVertices();
+			const VertexQuantization& quantization = p_mesh.getVertexQuantization();
+
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				const LibMath::Vector3 position = quantization.decodePosition(vertices[i]);
+				isInFront[i] = project(mvp, position.m_x, position.m_y, position.m_z, screenVertices[i]);
+			}
+		}
+		else if (p_mesh.getVertexLayout() == EVertexLayout::E_SEPARATE)
+		{
+			// Only the position streams are read
+			const Vector3Streams positions = p_mesh.getVertexStreams().getPositions();
+
+			for (size_t i = 0; i < vertexCount; i++)
+				isInFront[i] = project(mvp, positions.m_x[i], positions.m_y[i], positions.m_z[i], screenVertices[i]);
+		}
+		else
+		{
+			const StreamView<Vertex> vertices = p_mesh.getVertices();
+
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				const LibMath::Vector3& position = vertices[i].m_position;
+				isInFront[i] = project(mvp, position.m_x, position.m_y, position.m_z, screenVertices[i]);
+			}
+		}
+
+		indexBuffer.visit([&](const auto* p_indices)
+		{
+			for (size_t i = 0; i + 2 < indexBuffer.size(); i += 3)
+			{
+				// Clipping would need new vertices - skipping the triangle is always safe
+				if (!isInFront[p_indices[i]] || !isInFront[p_indices[i + 1]] || !isInFront[p_indices[i + 2]])
+					continue;
+
+				rasterizeTriangle(screenVertices[p_indices[i]], screenVertices[p_indices[i + 1]],
+					screenVertices[p_indices[i + 2]]);
+			}
+		});
+	}
+
+	bool OcclusionBuffer::isVisible(const AABB& p_bounds) const
+	{
+		float minX = INFINITY;
+		float minY = INFINITY;
+		float maxX = -INFINITY;
+		float maxY = -INFINITY;
+		float minDepth = INFINITY;
+
+		for (int corner = 0; corner < 8; corner++)
+		{
+			const float x = corner & 1 ? p_bounds.m_max.m_x : p_bounds.m_min.m_x;
+			const float y = corner & 2 ? p_bounds.m_max.m_y : p_bounds.m_min.m_y;
+			const float z = corner & 4 ? p_bounds.m_max.m_z : p_bounds.m_min.m_z;
+
+			ScreenVertex vertex;
+
+			// The box reaches the camera - its screen rectangle is unbounded
+			if (!project(m_viewProjection, x, y, z, vertex))
+				return true;
+
+			minX = std::min(minX, vertex.m_x);
+			minY = std::min(minY, vertex.m_y);
+			maxX = std::max(maxX, vertex.m_x);
+			maxY = std::max(maxY, vertex.m_y);
+			minDepth = std::min(minDepth, vertex.m_depth);
+		}
+
+		if (maxX <= 0.f || maxY <= 0.f || minX >= static_cast<float>(m_width) || minY >= static_cast<float>(m_height))
+			return false;
+
+		// Every pixel touched by the rectangle has to be hidden
+		const int firstX = std::max(0, static_cast<int>(floorf(minX)));
+		const int firstY = std::max(0, static_cast<int>(floorf(minY)));
+		const int lastX = std::min(static_cast<int>(m_width), std::max(firstX + 1, static_cast<int>(ceilf(maxX))));
+		const int lastY = std::min(static_cast<int>(m_height), std::max(firstY + 1, static_cast<int>(ceilf(maxY))));
+
+		const __m128 depth = _mm_set1_ps(minDepth);
+		const __m128i firstXs = _mm_set1_epi32(firstX);
+		const __m128i lastXs = _mm_set1_epi32(lastX);
+		const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+
+		for (int y = firstY; y < lastY; y++)
+		{
+			const float* row = m_depths.data() + static_cast<size_t>(y) * m_width;
+
+			for (int x = firstX & ~3; x < lastX; x += 4)
+			{
+				// Ignore the lanes outside of the rectangle
+				const __m128i columns = _mm_add_epi32(_mm_set1_epi32(x), laneOffsets);
+				const __m128i isInRect = _mm_andnot_si128(_mm_cmplt_epi32(columns, firstXs),
+					_mm_cmplt_epi32(columns, lastXs));
+
+				const __m128 isInFront = _mm_and_ps(_mm_cmpgt_ps(_mm_loadu_ps(row + x), depth),
+					_mm_castsi128_ps(isInRect));
+
+				if (_mm_movemask_ps(isInFront) != 0)
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool OcclusionBuffer::project(const float p_matrix[16], const float p_x, const float p_y, const float p_z,
+		ScreenVertex& p_vertex) const
+	{
+		const float x = p_matrix[0] * p_x + p_matrix[1] * p_y + p_matrix[2] * p_z + p_matrix[3];
+		const float y = p_matrix[4] * p_x + p_matrix[5] * p_y + p_matrix[6] * p_z + p_matrix[7];
+		const float z = p_matrix[8] * p_x + p_matrix[9] * p_y + p_matrix[10] * p_z + p_matrix[11];
+		const float w = p_matrix[12] * p_x + p_matrix[13] * p_y + p_matrix[14] * p_z + p_matrix[15];
+
+		if (w <= 0.f || z < -w)
+			return false;
+
+		// Same mapping as the rasterizer's, with y pointing down
+		p_vertex.m_x = (x / w + 1.f) * .5f * static_cast<float>(m_width);
+		p_vertex.m_y = (1.f - y / w) * .5f * static_cast<float>(m_height);
+		p_vertex.m_depth = w;
+
+		return true;
+	}
+
+	void OcclusionBuffer::rasterizeTriangle(const ScreenVertex& p_a, const ScreenVertex& p_b, const ScreenVertex& p_c)
+	{
+		const ScreenVertex* a = &p_a;
+		const ScreenVertex* b = &p_b;
+		const ScreenVertex* c = &p_c;
+
+		const float area = (b->m_x - a->m_x) * (c->m_y - a->m_y) - (b->m_y - a->m_y) * (c->m_x - a->m_x);
+
+		if (area == 0.f)
+			return;
+
+		// Both faces occlude - make the edge functions positive inside the triangle
+		if (area < 0.f)
+			std::swap(b, c);
+
+		const int firstX = std::max(0, static_cast<int>(floorf(std::min({ a->m_x, b->m_x, c->m_x }))));
+		const int firstY = std::max(0, static_cast<int>(floorf(std::min({ a->m_y, b->m_y, c->m_y }))));
+		const int lastX = std::min(static_cast<int>(m_width), static_cast<int>(ceilf(std::max({ a->m_x, b->m_x, c->m_x }))));
+		const int lastY = std::min(static_cast<int>(m_height), static_cast<int>(ceilf(std::max({ a->m_y, b->m_y, c->m_y }))));
+
+		if (firstX >= lastX || firstY >= lastY)
+			return;
+
+		const ScreenVertex* edges[3][2] = { { a, b }, { b, c }, { c, a } };
+
+		__m128 stepX[3];
+		__m128 stepY[3];
+		__m128 rowStart[3];
+
+		const int alignedFirstX = firstX & ~3;
+		const __m128 laneOffsets = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+
+		for (int i = 0; i < 3; i++)
+		{
+			const ScreenVertex& start = *edges[i][0];
+			const ScreenVertex& end = *edges[i][1];
+
+			const float edgeA = start.m_y - end.m_y;
+			const float edgeB = end.m_x - start.m_x;
+
+			/*
+			 * Evaluated at the pixel centers and moved inwards by half a pixel on each axis
+			 * so that only the pixels entirely inside the triangle pass
+			 */
+			const float edgeC = -(edgeA * start.m_x + edgeB * start.m_y)
+				- .5f * (std::abs(edgeA) + std::abs(edgeB));
+
+			const float firstCenterX = static_cast<float>(alignedFirstX) + .5f;
+			const float firstCenterY = static_cast<float>(firstY) + .5f;
+
+			stepX[i] = _mm_set1_ps(edgeA * 4.f);
+			stepY[i] = _mm_set1_ps(edgeB);
+			rowStart[i] = _mm_add_ps(_mm_set1_ps(edgeA * firstCenterX + edgeB * firstCenterY + edgeC),
+				_mm_mul_ps(_mm_set1_ps(edgeA), laneOffsets));
+		}
+
+		const __m128 depth = _mm_set1_ps(std::max({ a->m_depth, b->m_depth, c->m_depth }));
+		const __m128 zero = _mm_setzero_ps();
+
+		for (int y = firstY; y < lastY; y++)
+		{
+			float* row = m_depths.data() + static_cast<size_t>(y) * m_width;
+
+			__m128 edge0 = rowStart[0];
+			__m128 edge1 = rowStart[1];
+			__m128 edge2 = rowStart[2];
+
+			for (int x = alignedFirstX; x < lastX; x += 4)
+			{
+				const __m128 isCovered = _mm_and_ps(_mm_cmpge_ps(edge0, zero),
+					_mm_and_ps(_mm_cmpge_ps(edge1, zero), _mm_cmpge_ps(edge2, zero)));
+
+				if (_mm_movemask_ps(isCovered) != 0)
+				{
+					const __m128 previous = _mm_loadu_ps(row + x);
+					const __m128 closest = _mm_min_ps(previous, depth);
+
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(isCovered, closest),
+						_mm_andnot_ps(isCovered, previous)));
+				}
+
+				edge0 = _mm_add_ps(edge0, stepX[0]);
+				edge1 = _mm_add_ps(edge1, stepX[1]);
+				edge2 = _mm_add_ps(edge2, stepX[2]);
+			}
+
+			for (int i = 0; i < 3; i++)
+				rowStart[i] = _mm_add_ps(rowStart[i], stepY[i]);
+		}
+	}
+}
@@ -0,0 +1,150 @@
+#include "PackedVertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Arithmetic.h"
+
+namespace My
+{
+	VertexQuantization::VertexQuantization(const AABB& p_bounds)
+	{
+		const float minimums[3] = { p_bounds.m_min.m_x, p_bounds.m_min.m_y, p_bounds.m_min.m_z };
+		const float maximums[3] = { p_bounds.m_max.m_x, p_bounds.m_max.m_y, p_bounds.m_max.m_z };
+
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			m_offset[axis] = minimums[axis];
+			m_scale[axis] = std::max(maximums[axis] - minimums[axis], 0.f) / static_cast<float>(UINT16_MAX);
+		}
+	}
+
+	PackedVertex VertexQuantization::encode(const Vertex& p_vertex) const
+	{
+		PackedVertex packed;
+
+		const float position[3] = { p_vertex.m_position.m_x, p_vertex.m_position.m_y, p_vertex.m_position.m_z };
+
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			const float steps = m_scale[axis] > 0.f ? (position[axis] - m_offset[axis]) / m_scale[axis] : 0.f;
+			packed.m_position[axis] = static_cast<uint16_t>(lroundf(LibMath::clamp(steps, 0.f, static_cast<float>(UINT16_MAX))));
+		}
+
+		/*
+		 * Projects the normal on the octahedron then unfolds the lower half over the corners
+		 * http://jcgt.org/published/0003/02/01/
+		 */
+		const LibMath::Vector3& normal = p_vertex.m_normal;
+		const float length = std::abs(normal.m_x) + std::abs(normal.m_y) + std::abs(normal.m_z);
+
+		float x = length > 0.f ? normal.m_x / length : 0.f;
+		float y = length > 0.f ? normal.m_y / length : 0.f;
+
+		if (normal.m_z < 0.f)
+		{
+			const float foldedX = (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f);
+			const float foldedY = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+
+			x = foldedX;
+			y = foldedY;
+		}
+
+		packed.m_normal[0] = static_cast<int8_t>(lroundf(LibMath::clamp(x, -1.f, 1.f) * INT8_MAX));
+		packed.m_normal[1] = static_cast<int8_t>(lroundf(LibMath::clamp(y, -1.f, 1.f) * INT8_MAX));
+
+		packed.m_color = p_vertex.m_color;
+		packed.m_uv[0] = floatToHalf(p_vertex.m_u);
+		packed.m_uv[1] = floatToHalf(p_vertex.m_v);
+
+		return packed;
+	}
+
+	Vertex VertexQuantization::decode(const PackedVertex& p_vertex) const
+	{
+		Vertex vertex;
+
+		vertex.m_position = decodePosition(p_vertex);
+
+		float x = static_cast<float>(p_vertex.m_normal[0]) / INT8_MAX;
+		float y = static_cast<float>(p_vertex.m_normal[1]) / INT8_MAX;
+		const float z = 1.f - std::abs(x) - std::abs(y);
+
+		// Folds the corners back onto the lower half
+		const float fold = std::max(-z, 0.f);
+		x += x >= 0.f ? -fold : fold;
+		y += y >= 0.f ? -fold : fold;
+
+		const float invLength = 1.f / sqrtf(x * x + y * y + z * z);
+		vertex.m_normal = { x * invLength, y * invLength, z * invLength };
+
+		vertex.m_color = p_vertex.m_color;
+		vertex.m_u = halfToFloat(p_vertex.m_uv[0]);
+		vertex.m_v = halfToFloat(p_vertex.m_uv[1]);
+
+		return vertex;
+	}
+
+	LibMath::Vector3 VertexQuantization::decodePosition(const PackedVertex& p_vertex) const
+	{
+		return
+		{
+			m_offset[0] + static_cast<float>(p_vertex.m_position[0]) * m_scale[0],
+			m_offset[1] + static_cast<float>(p_vertex.m_position[1]) * m_scale[1],
+			m_offset[2] + static_cast<float>(p_vertex.m_position[2]) * m_scale[2]
+		};
+	}
+
+	uint16_t VertexQuantization::floatToHalf(const float p_value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &p_value, sizeof(bits));
+
+		const uint32_t sign = (bits >> 16) & 0x8000u;
+		const uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+		// Infinity and NaN
+		if (magnitude >= 0x7F800000u)
+			return static_cast<uint16_t>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u));
+
+		// Rounds to infinity from 65520
+		if (magnitude >= 0x477FF000u)
+			return static_cast<uint16_t>(sign | 0x7C00u);
+
+		// Below the smallest normal half, the mantissa counts multiples of 2^-24
+		if (magnitude < 0x38800000u)
+		{
+			float absValue;
+			std::memcpy(&absValue, &magnitude, sizeof(absValue));
+
+			return static_cast<uint16_t>(sign | static_cast<uint32_t>(lrintf(absValue * 16777216.f)));
+		}
+
+		// Rebiases the exponent from 127 to 15 and rounds the mantissa to nearest even
+		const uint32_t rebiased = magnitude - 0x38000000u;
+		return static_cast<uint16_t>(sign | ((rebiased + 0xFFFu + ((rebiased >> 13) & 1u)) >> 13));
+	}
+
+	float VertexQuantization::halfToFloat(const uint16_t p_half)
+	{
+		const uint32_t sign = static_cast<uint32_t>(p_half & 0x8000u) << 16;
+		const uint32_t exponent = (p_half >> 10) & 0x1Fu;
+		const uint32_t mantissa = p_half & 0x3FFu;
+
+		if (exponent == 0)
+		{
+			const float value = static_cast<float>(mantissa) * 5.96046448e-8f;
+			return sign != 0 ? -value : value;
+		}
+
+		const uint32_t bits = exponent == 0x1Fu ?
+			sign | 0x7F800000u | (mantissa << 13) :
+			sign | ((exponent + 112u) << 23) | (mantissa << 13);
+
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+}
@@ -0,0 +1,337 @@
+#include "PostProcess.h"
+
+#include <emmintrin.h>
+#include <stdexcept>
+
+#include "Arithmetic.h"
+#include "Color.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+namespace My
+{
+	namespace
+	{
+		// Minimum local contrast for a pixel to be considered part of an edge
+		constexpr float EDGE_THRESHOLD_MIN = 0.0312f;
+
+		// Minimum local contrast relative to the brightest neighbour
+		constexpr float EDGE_THRESHOLD_MAX = 0.125f;
+
+		// How much of the sub-pixel aliasing should be removed
+		constexpr float SUBPIXEL_QUALITY = 0.75f;
+
+		// Distances walked along the edge at each step of the end search
+		constexpr size_t EDGE_SEARCH_STEP_COUNT = 12;
+		constexpr float EDGE_SEARCH_STEPS[EDGE_SEARCH_STEP_COUNT] = { 1.f, 1.f, 1.f, 1.f, 1.f, 1.5f, 2.f, 2.f, 2.f, 2.f, 4.f, 8.f };
+
+		// Copies of the frame and its luminance, kept between frames to reuse their memory
+		thread_local std::vector<Color> g_sourceScratch;
+		thread_local std::vector<float> g_lumaScratch;
+
+		/**
+		 * \brief Lookups in a luminance buffer with the coordinates clamped to its edges
+		 */
+		struct LumaView
+		{
+			const float*	m_luma;
+			int				m_width;
+			int				m_height;
+
+			float at(const int p_x, const int p_y) const
+			{
+				const int x = LibMath::min(LibMath::max(p_x, 0), m_width - 1);
+				const int y = LibMath::min(LibMath::max(p_y, 0), m_height - 1);
+
+				return m_luma[static_cast<size_t>(y) * m_width + x];
+			}
+
+			float sample(const float p_x, const float p_y) const
+			{
+				// Pixel centers are at .5 so shift the position to get the top left texel
+				const float x = p_x - .5f;
+				const float y = p_y - .5f;
+				const float floorX = LibMath::floor(x);
+				const float floorY = LibMath::floor(y);
+				const float tx = x - floorX;
+				const float ty = y - floorY;
+				const int ix = static_cast<int>(floorX);
+				const int iy = static_cast<int>(floorY);
+
+				const float top = at(ix, iy) + (at(ix + 1, iy) - at(ix, iy)) * tx;
+				const float bottom = at(ix, iy + 1) + (at(ix + 1, iy + 1) - at(ix, iy + 1)) * tx;
+
+				return top + (bottom - top) * ty;
+			}
+		};
+
+		Color sampleBilinear(const Color* p_pixels, const int p_width, const int p_height, const float p_x, const float p_y)
+		{
+			const float x = p_x - .5f;
+			const float y = p_y - .5f;
+			const float floorX = LibMath::floor(x);
+			const float floorY = LibMath::floor(y);
+
+			const int x0 = LibMath::min(LibMath::max(static_cast<int>(floorX), 0), p_width - 1);
+			const int y0 = LibMath::min(LibMath::max(static_cast<int>(floorY), 0), p_height - 1);
+			const int x1 = LibMath::min(x0 + 1, p_width - 1);
+			const int y1 = LibMath::min(y0 + 1, p_height - 1);
+
+			const Color top = Color::lerp(p_pixels[static_cast<size_t>(y0) * p_width + x0],
+				p_pixels[static_cast<size_t>(y0) * p_width + x1], x - floorX);
+
+			const Color bottom = Color::lerp(p_pixels[static_cast<size_t>(y1) * p_width + x0],
+				p_pixels[static_cast<size_t>(y1) * p_width + x1], x - floorX);
+
+			return Color::lerp(top, bottom, y - floorY);
+		}
+
+		/**
+		 * \brief Runs the full FXAA edge search and blend for a single pixel
+		 * \return The anti-aliased color of the pixel
+		 */
+		Color fxaaPixel(const Color* p_source, const LumaView& p_luma, const int p_x, const int p_y)
+		{
+			const float lumaM = p_luma.at(p_x, p_y);
+			const float lumaN = p_luma.at(p_x, p_y - 1);
+			const float lumaS = p_luma.at(p_x, p_y + 1);
+			const float lumaW = p_luma.at(p_x - 1, p_y);
+			const float lumaE = p_luma.at(p_x + 1, p_y);
+
+			const float lumaMin = LibMath::min(lumaM, LibMath::min(LibMath::min(lumaN, lumaS), LibMath::min(lumaW, lumaE)));
+			const float lumaMax = LibMath::max(lumaM, LibMath::max(LibMath::max(lumaN, lumaS), LibMath::max(lumaW, lumaE)));
+			const float lumaRange = lumaMax - lumaMin;
+
+			const Color center = p_source[static_cast<size_t>(p_y) * p_luma.m_width + p_x];
+
+			if (lumaRange < LibMath::max(EDGE_THRESHOLD_MIN, lumaMax * EDGE_THRESHOLD_MAX))
+				return center;
+
+			const float lumaNW = p_luma.at(p_x - 1, p_y - 1);
+			const float lumaNE = p_luma.at(p_x + 1, p_y - 1);
+			const float lumaSW = p_luma.at(p_x - 1, p_y + 1);
+			const float lumaSE = p_luma.at(p_x + 1, p_y + 1);
+
+			// Find whether the edge is horizontal or vertical
+			const float edgeHorizontal = LibMath::abs(lumaN + lumaS - 2.f * lumaM) * 2.f
+				+ LibMath::abs(lumaNE + lumaSE - 2.f * lumaE)
+				+ LibMath::abs(lumaNW + lumaSW - 2.f * lumaW);
+
+			const float edgeVertical = LibMath::abs(lumaW + lumaE - 2.f * lumaM) * 2.f
+				+ LibMath::abs(lumaNE + lumaNW - 2.f * lumaN)
+				+ LibMath::abs(lumaSE + lumaSW - 2.f * lumaS);
+
+			const bool isHorizontal = edgeHorizontal >= edgeVertical;
+
+			// Find on which side of the pixel the edge is
+			const float luma1 = isHorizontal ? lumaN : lumaW;
+			const float luma2 = isHorizontal ? lumaS : lumaE;
+			const float gradient1 = luma1 - lumaM;
+			const float gradient2 = luma2 - lumaM;
+			const bool is1Steepest = LibMath::abs(gradient1) >= LibMath::abs(gradient2);
+			const float gradientScaled = .25f * LibMath::max(LibMath::abs(gradient1), LibMath::abs(gradient2));
+
+			const float stepLength = is1Steepest ? -1.f : 1.f;
+			const float lumaLocalAverage = .5f * ((is1Steepest ? luma1 : luma2) + lumaM);
+
+			// Start half a pixel away, on the edge itself
+			float startX = static_cast<float>(p_x) + .5f;
+			float startY = static_cast<float>(p_y) + .5f;
+
+			if (isHorizontal)
+				startY += stepLength * .5f;
+			else
+				startX += stepLength * .5f;
+
+			const float offsetX = isHorizontal ? 1.f : 0.f;
+			const float offsetY = isHorizontal ? 0.f : 1.f;
+
+			// Walk along the edge in both directions until its end
+			float x1 = startX - offsetX;
+			float y1 = startY - offsetY;
+			float x2 = startX + offsetX;
+			float y2 = startY + offsetY;
+
+			float lumaEnd1 = p_luma.sample(x1, y1) - lumaLocalAverage;
+			float lumaEnd2 = p_luma.sample(x2, y2) - lumaLocalAverage;
+			bool reached1 = LibMath::abs(lumaEnd1) >= gradientScaled;
+			bool reached2 = LibMath::abs(lumaEnd2) >= gradientScaled;
+
+			for (size_t i = 1; i < EDGE_SEARCH_STEP_COUNT && !(reached1 && reached2); i++)
+			{
+				if (!reached1)
+				{
+					x1 -= offsetX * EDGE_SEARCH_STEPS[i];
+					y1 -= offsetY * EDGE_SEARCH_STEPS[i];
+					lumaEnd1 = p_luma.sample(x1, y1) - lumaLocalAverage;
+					reached1 = LibMath::abs(lumaEnd1) >= gradientScaled;
+				}
+
+				if (!reached2)
+				{
+					x2 += offsetX * EDGE_SEARCH_STEPS[i];
+					y2 += offsetY * EDGE_SEARCH_STEPS[i];
+					lumaEnd2 = p_luma.sample(x2, y2) - lumaLocalAverage;
+					reached2 = LibMath::abs(lumaEnd2) >= gradientScaled;
+				}
+			}
+
+			const float centerX = static_cast<float>(p_x) + .5f;
+			const float centerY = static_cast<float>(p_y) + .5f;
+
+			const float distance1 = isHorizontal ? centerX - x1 : centerY - y1;
+			const float distance2 = isHorizontal ? x2 - centerX : y2 - centerY;
+			const bool isDirection1 = distance1 < distance2;
+			const float edgeLength = distance1 + distance2;
+
+			// Only blend if the luminance variation at the closest end matches the center's
+			const bool isLumaCenterSmaller = lumaM < lumaLocalAverage;
+			const bool isCorrectVariation = ((isDirection1 ? lumaEnd1 : lumaEnd2) < 0.f) != isLumaCenterSmaller;
+			const float edgeOffset = isCorrectVariation
+				? .5f - LibMath::min(distance1, distance2) / edgeLength
+				: 0.f;
+
+			// Sub-pixel anti-aliasing for details smaller than a pixel
+			const float lumaAverage = (2.f * (lumaN + lumaS + lumaW + lumaE)
+				+ lumaNW + lumaNE + lumaSW + lumaSE) / 12.f;
+			const float subPixelOffset1 = LibMath::clamp(LibMath::abs(lumaAverage - lumaM) / lumaRange, 0.f, 1.f);
+			const float subPixelOffset2 = (-2.f * subPixelOffset1 + 3.f) * subPixelOffset1 * subPixelOffset1;
+			const float subPixelOffset = subPixelOffset2 * subPixelOffset2 * SUBPIXEL_QUALITY;
+
+			const float finalOffset = LibMath::max(edgeOffset, subPixelOffset) * stepLength;
+
+			if (isHorizontal)
+				return sampleBilinear(p_source, p_luma.m_width, p_luma.m_height, centerX, centerY + finalOffset);
+
+			return sampleBilinear(p_source, p_luma.m_width, p_luma.m_height, centerX + finalOffset, centerY);
+		}
+	}
+
+	void PostProcess::applyFxaa(Texture& p_target, ThreadPool& p_threadPool)
+	{
+		// The passes walk the pixels row by row
+		if (p_target.getLayout() != ETextureLayout::E_LINEAR || p_target.getCompression() != ETextureCompression::E_NONE
+			|| p_target.getVirtualTexture() != nullptr)
+			throw std::invalid_argument("FXAA can only be applied to uncompressed textures using the linear layout");
+
+		const size_t height = p_target.getHeight();
+
+		if (p_target.getWidth() == 0 || height == 0)
+			return;
+
+		// Only the base level is read, so the mipmaps aren't copied with it
+		const size_t pixelCount = static_cast<size_t>(p_target.getWidth()) * height;
+		const Color* pixels = p_target.getPixels();
+
+		std::vector<Color>& source = g_sourceScratch;
+		std::vector<float>& luma = g_lumaScratch;
+		source.assign(pixels, pixels + pixelCount);
+		luma.resize(pixelCount);
+
+		p_threadPool.parallelFor(height, [&p_target, &luma](const size_t p_begin, const size_t p_end)
+		{
+			computeLuma(p_target, luma, p_begin, p_end);
+		}, 16);
+
+		p_threadPool.parallelFor(height, [&source, &luma, &p_target](const size_t p_begin, const size_t p_end)
+		{
+			fxaaRows(source, luma, p_target, p_begin, p_end);
+		}, 16);
+	}
+
+	void PostProcess::computeLuma(const Texture& p_source, std::vector<float>& p_luma,
+		const size_t p_firstRow, const size_t p_lastRow)
+	{
+		const size_t width = p_source.getWidth();
+		const Color* pixels = p_source.getPixels();
+
+		const __m128i byteMask = _mm_set1_epi32(0xFF);
+		const __m128 weightR = _mm_set1_ps(.299f / UINT8_MAX);
+		const __m128 weightG = _mm_set1_ps(.587f / UINT8_MAX);
+		const __m128 weightB = _mm_set1_ps(.114f / UINT8_MAX);
+
+		for (size_t y = p_firstRow; y < p_lastRow; y++)
+		{
+			const Color* row = pixels + y * width;
+			float* lumaRow = p_luma.data() + y * width;
+
+			size_t x = 0;
+
+			for (; x + 4 <= width; x += 4)
+			{
+				// Each color is 4 bytes so 4 pixels fit in a single register
+				const __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+
+				const __m128 r = _mm_cvtepi32_ps(_mm_and_si128(colors, byteMask));
+				const __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(colors, 8), byteMask));
+				const __m128 b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(colors, 16), byteMask));
+
+				const __m128 luma = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, weightR), _mm_mul_ps(g, weightG)),
+					_mm_mul_ps(b, weightB));
+
+				_mm_storeu_ps(lumaRow + x, luma);
+			}
+
+			for (; x < width; x++)
+			{
+				lumaRow[x] = .299f / UINT8_MAX * row[x].m_r
+					+ .587f / UINT8_MAX * row[x].m_g
+					+ .114f / UINT8_MAX * row[x].m_b;
+			}
+		}
+	}
+
+	void PostProcess::fxaaRows(const std::vector<Color>& p_source, const std::vector<float>& p_luma,
+		Texture& p_target, const size_t p_firstRow, const size_t p_lastRow)
+	{
+		const int width = static_cast<int>(p_target.getWidth());
+		const int height = static_cast<int>(p_target.getHeight());
+		const LumaView lumaView{ p_luma.data(), width, height };
+
+		Color* targetPixels = p_target.getPixels();
+
+		const __m128 thresholdMin = _mm_set1_ps(EDGE_THRESHOLD_MIN);
+		const __m128 thresholdMax = _mm_set1_ps(EDGE_THRESHOLD_MAX);
+
+		for (size_t row = p_firstRow; row < p_lastRow; row++)
+		{
+			const int y = static_cast<int>(row);
+			const float* lumaRow = p_luma.data() + row * width;
+			const float* lumaRowN = p_luma.data() + static_cast<size_t>(LibMath::max(y - 1, 0)) * width;
+			const float* lumaRowS = p_luma.data() + static_cast<size_t>(LibMath::min(y + 1, height - 1)) * width;
+
+			Color* targetRow = targetPixels + row * width;
+
+			int x = 0;
+
+			// Left border (the vector loop needs a left neighbour)
+			for (; x < LibMath::min(1, width); x++)
+				targetRow[x] = fxaaPixel(p_source.data(), lumaView, x, y);
+
+			// Most pixels aren't on an edge so reject them four at a time
+			for (; x + 4 < width; x += 4)
+			{
+				const __m128 lumaM = _mm_loadu_ps(lumaRow + x);
+				const __m128 lumaN = _mm_loadu_ps(lumaRowN + x);
+				const __m128 lumaS = _mm_loadu_ps(lumaRowS + x);
+				const __m128 lumaW = _mm_loadu_ps(lumaRow + x - 1);
+				const __m128 lumaE = _mm_loadu_ps(lumaRow + x + 1);
+
+				const __m128 lumaMin = _mm_min_ps(lumaM, _mm_min_ps(_mm_min_ps(lumaN, lumaS), _mm_min_ps(lumaW, lumaE)));
+				const __m128 lumaMax = _mm_max_ps(lumaM, _mm_max_ps(_mm_max_ps(lumaN, lumaS), _mm_max_ps(lumaW, lumaE)));
+				const __m128 threshold = _mm_max_ps(thresholdMin, _mm_mul_ps(lumaMax, thresholdMax));
+				const int edgeMask = _mm_movemask_ps(_mm_cmpge_ps(_mm_sub_ps(lumaMax, lumaMin), threshold));
+
+				for (int i = 0; i < 4; i++)
+				{
+					if (edgeMask & (1 << i))
+						targetRow[x + i] = fxaaPixel(p_source.data(), lumaView, x + i, y);
+				}
+			}
+
+			// Right border
+			for (; x < width; x++)
+				targetRow[x] = fxaaPixel(p_source.data(), lumaView, x, y);
+		}
+	}
+}
@@ -1,170 +1,1175 @@
 #include "Rasterizer.h"
 
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <emmintrin.h>
+
 #include "Arithmetic.h"
 #include "Camera.h"
 #include "Color.h"
 #include "Mesh.h"
+#include "PostProcess.h"
 #include "Texture.h"
 #include "Scene.h"
 #include "Light.h"
+#include "ThreadPool.h"
 #include "Vector/Vector2.h"
 #include "Vector/Vector4.h"
 
 namespace My
 {
-	Rasterizer::Rasterizer(const uint8_t p_sampleCount)
-		: m_sampleCount(p_sampleCount)
+	static_assert(sizeof(Color) == 4, "The resolve kernels expect tightly packed RGBA8 colors");
+
+	namespace
+	{
+		const Vertex& decodeVertex(const Vertex& p_vertex, const VertexQuantization&)
+		{
+			return p_vertex;
+		}
+
+		Vertex decodeVertex(const PackedVertex& p_vertex, const VertexQuantization& p_quantization)
+		{
+			return p_quantization.decode(p_vertex);
+		}
+
+		/**
+		 * \brief Multiplies four vectors by a row of a matrix, in the same order as the scalar code
+		 * \param p_row The broadcast elements of the row
+		 * \param p_x The x components of the vectors
+		 * \param p_y The y components of the vectors
+		 * \param p_z The z components of the vectors
+		 * \return The dot products of the row with the vectors, w being 0
+		 */
+		__m128 transformDirections(const __m128* p_row, const __m128 p_x, const __m128 p_y, const __m128 p_z)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(p_row[0], p_x), _mm_mul_ps(p_row[1], p_y)),
+				_mm_mul_ps(p_row[2], p_z));
+		}
+
+		/**
+		 * \brief Multiplies four points by a row of a matrix, in the same order as the scalar code
+		 * \param p_row The broadcast elements of the row
+		 * \param p_x The x components of the points
+		 * \param p_y The y components of the points
+		 * \param p_z The z components of the points
+		 * \return The dot products of the row with the points, w being 1
+		 */
+		__m128 transformPoints(const __m128* p_row, const __m128 p_x, const __m128 p_y, const __m128 p_z)
+		{
+			return _mm_add_ps(transformDirections(p_row, p_x, p_y, p_z), p_row[3]);
+		}
+
+		/**
+		 * \brief Finds the mip level to sample the given triangle's texture from. The attributes are interpolated
+		 * linearly in screen space so the texture coordinates' derivatives are the same for every pixel quad
+		 * \param p_vertices The textured triangle
+		 * \param p_vs1 The pixel space edge from the first vertex to the second one
+		 * \param p_vs2 The pixel space edge from the first vertex to the third one
+		 * \param p_area The cross product of the two edges
+		 * \param p_texture The triangle's texture
+		 * \return The base 2 logarithm of the number of texels covered by a pixel along its longest axis
+		 */
+		float computeTextureLod(const Vertex p_vertices[3], const LibMath::Vector2& p_vs1, const LibMath::Vector2& p_vs2,
+			const float p_area, const Texture& p_texture)
+		{
+			if (LibMath::floatEquals(p_area, 0.f))
+				return 0.f;
+
+			// Derivatives of the second and third barycentric coordinates along x and y
+			const float dtdx = p_vs2.m_y / p_area;
+			const float dtdy = -p_vs2.m_x / p_area;
+			const float dwdx = -p_vs1.m_y / p_area;
+			const float dwdy = p_vs1.m_x / p_area;
+
+			const float width = static_cast<float>(p_texture.getWidth());
+			const float height = static_cast<float>(p_texture.getHeight());
+
+			const float du1 = (p_vertices[1].m_u - p_vertices[0].m_u) * width;
+			const float du2 = (p_vertices[2].m_u - p_vertices[0].m_u) * width;
+			const float dv1 = (p_vertices[1].m_v - p_vertices[0].m_v) * height;
+			const float dv2 = (p_vertices[2].m_v - p_vertices[0].m_v) * height;
+
+			const float dudx = du1 * dtdx + du2 * dwdx;
+			const float dvdx = dv1 * dtdx + dv2 * dwdx;
+			const float dudy = du1 * dtdy + du2 * dwdy;
+			const float dvdy = dv1 * dtdy + dv2 * dwdy;
+
+			const float footprint = LibMath::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+
+			// Half the logarithm of the squared length avoids the square root
+			return footprint > 0.f ? .5f * std::log2(footprint) : 0.f;
+		}
+
+		// Number of entries of the linear to sRGB table
+		constexpr size_t SRGB_ENCODE_STEPS = 4096;
+
+		/**
+		 * \brief Gives the linear value of each 8 bit sRGB value
+		 */
+		const float* getSrgbDecodeTable()
+		{
+			static const std::array<float, 256> table = []
+			{
+				std::array<float, 256> values {};
+
+				for (size_t i = 0; i < values.size(); i++)
+				{
+					const float value = static_cast<float>(i) / 255.f;
+					values[i] = value <= .04045f ? value / 12.92f : std::pow((value + .055f) / 1.055f, 2.4f);
+				}
+
+				return values;
+			}();
+
+			return table.data();
+		}
+
+		/**
+		 * \brief Gives the 8 bit sRGB value of linear values in [0, 1]. The table is indexed by the square root
+		 * of the linear value to spend more entries on the dark values, where the sRGB curve is the steepest
+		 */
+		const uint8_t* getSrgbEncodeTable()
+		{
+			static const std::array<uint8_t, SRGB_ENCODE_STEPS> table = []
+			{
+				std::array<uint8_t, SRGB_ENCODE_STEPS> values {};
+
+				for (size_t i = 0; i < values.size(); i++)
+				{
+					const float root = static_cast<float>(i) / static_cast<float>(SRGB_ENCODE_STEPS - 1);
+					const float value = root * root;
+					const float encoded = value <= .0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - .055f;
+
+					values[i] = static_cast<uint8_t>(encoded * 255.f + .5f);
+				}
+
+				return values;
+			}();
+
+			return table.data();
+		}
+
+		/**
+		 * \brief Converts the given sRGB color to linear, keeping its alpha linear
+		 * \return The linear red, green, blue and alpha in [0, 1]
+		 */
+		__m128 decodeSrgb(const Color& p_color)
+		{
+			const float* toLinear = getSrgbDecodeTable();
+			return _mm_setr_ps(toLinear[p_color.m_r], toLinear[p_color.m_g], toLinear[p_color.m_b],
+				static_cast<float>(p_color.m_a) / 255.f);
+		}
+
+		/**
+		 * \brief Exposes and tone maps the given linear color with a fit of the ACES filmic curve, then encodes it in sRGB
+		 * \param p_color The linear color to encode. Its alpha is only clamped
+		 * \param p_exposure The broadcast factor the color is scaled by before being tone mapped
+		 * \return The displayable color
+		 */
+		Color encodeHdr(const __m128 p_color, const __m128 p_exposure)
+		{
+			const __m128 x = _mm_mul_ps(p_color, p_exposure);
+
+			const __m128 numerator = _mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.51f)), _mm_set1_ps(.03f)));
+			const __m128 denominator = _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.43f)),
+				_mm_set1_ps(.59f))), _mm_set1_ps(.14f));
+
+			const __m128 mapped = _mm_min_ps(_mm_max_ps(_mm_div_ps(numerator, denominator), _mm_setzero_ps()),
+				_mm_set1_ps(1.f));
+
+			alignas(16) int32_t indices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(_mm_add_ps(
+				_mm_mul_ps(_mm_sqrt_ps(mapped), _mm_set1_ps(static_cast<float>(SRGB_ENCODE_STEPS - 1))),
+				_mm_set1_ps(.5f))));
+
+			const uint8_t* toSrgb = getSrgbEncodeTable();
+			const float alpha = LibMath::clamp(_mm_cvtss_f32(_mm_shuffle_ps(p_color, p_color, _MM_SHUFFLE(3, 3, 3, 3))),
+				0.f, 1.f);
+
+			return { toSrgb[indices[0]], toSrgb[indices[1]], toSrgb[indices[2]],
+				static_cast<uint8_t>(alpha * 255.f + .5f) };
+		}
+
+		/**
+		 * \brief Raises each element of the given vector to the given power by squaring
+		 */
+		__m128 powInt(__m128 p_base, int p_exponent)
+		{
+			__m128 result = _mm_set1_ps(1.f);
+
+			for (; p_exponent > 0; p_exponent >>= 1)
+			{
+				if (p_exponent & 1)
+					result = _mm_mul_ps(result, p_base);
+
+				p_base = _mm_mul_ps(p_base, p_base);
+			}
+
+			return result;
+		}
+	}
+
+	Rasterizer::Rasterizer(const uint8_t p_sampleCount, const EAntiAliasing p_antiAliasing)
+		: m_sampleCount(p_sampleCount), m_antiAliasing(p_antiAliasing)
 	{
-		if (p_sampleCount == 0)
+		if (p_sampleCount == 0 || p_sampleCount > MAX_SAMPLE_COUNT)
 			throw std::invalid_argument(
-				"Sample count must be greater than or equal to 1. Received: "
-				+ std::to_string(p_sampleCount));
+				"Sample count must be in range [1, " + std::to_string(MAX_SAMPLE_COUNT)
+				+ "]. Received: " + std::to_string(p_sampleCount));
 	}
 
 	void Rasterizer::renderScene(const Scene& p_scene, const Camera& p_camera,
 		Texture& p_target)
 	{
-		Texture target = p_target;
-
-		if (!LibMath::floatEquals(m_sampleCount, 1.f))
-		{
-			const uint32_t msaaWidth = (p_target.getWidth() + 1) * m_sampleCount;
-			const uint32_t msaaHeight = (p_target.getHeight() + 1) * m_sampleCount;
+		// The resolve writes whole rows of pixels
+		if (p_target.getLayout() != ETextureLayout::E_LINEAR)
+			throw std::invalid_argument("The target texture must use the linear layout");
 
-			target = Texture(msaaWidth, msaaHeight);
-		}
+		m_target = &p_target;
+		m_frameWidth = p_target.getWidth();
+		m_frameHeight = p_target.getHeight();
+		m_isHdrFrame = m_isHdrEnabled;
 
-		m_target = &target;
+		updateSampleOffsets();
 
-		// Set every pixel to black
-		for (uint32_t x = 0; x < m_target->getWidth(); x++)
-			for (uint32_t y = 0; y < m_target->getHeight(); y++)
-				m_target->setPixelColor(x, y, Color::black);
+		// Every sample of every pixel gets its own color and depth
+		const size_t sampleBufferSize = static_cast<size_t>(m_frameWidth) * m_frameHeight * getSamplesPerPixel();
 
-		const size_t textureSize = static_cast<size_t>(m_target->getWidth())
-			* m_target->getHeight();
+		// Set every sample to black. The samples of a pixel are next to each other in its row
+		if (m_isHdrFrame)
+			m_hdrSampleBuffer.reset(static_cast<uint32_t>(m_frameWidth * getSamplesPerPixel()), m_frameHeight,
+				{ 0.f, 0.f, 0.f, 1.f });
+		else
+			m_sampleBuffer.assign(sampleBufferSize, Color::black);
 
-		m_zBuffer.clear();
-		m_zBuffer.resize(textureSize, INFINITY);
+		m_zBuffer.reset(static_cast<uint32_t>(m_frameWidth * getSamplesPerPixel()), m_frameHeight, INFINITY);
 
 		const auto& lights = p_scene.getLights();
 		m_lights = &lights;
 
+		if (m_isHdrFrame)
+			batchLights(lights);
+
 		m_camera = &p_camera;
 
-		const auto entities = p_scene.getEntities();
-		std::vector<const Entity*> transparentEntities;
+		// Only the entities that can end up on screen are drawn
+		const Frustum frustum = p_camera.getFrustum();
+
+		std::vector<size_t> visibleEntities;
+		p_scene.cullEntities(frustum, visibleEntities);
+
+		// Wireframe occluders don't hide anything
+		if (m_isOcclusionCullingEnabled && m_drawMode == EDrawMode::E_FILL)
+			cullOccludedEntities(p_scene, frustum, visibleEntities);
+
+		// Keep the scene's order so transparent entities always blend the same way
+		std::sort(visibleEntities.begin(), visibleEntities.end());
+
+		const Mat4 viewProjection = p_camera.getProjectionMatrix() * p_camera.getViewMatrix();
+
+		for (size_t i = 0; i < 16; i++)
+			m_viewProjection[i] = viewProjection[i];
+
+		m_viewPosition = p_camera.getPosition();
+		m_viewDirection = p_camera.getForward();
+
+		// Converts a view space length at a depth of 1 to pixels
+		m_projectionScale = p_camera.getProjectionMatrix()[5] * static_cast<float>(m_target->getHeight()) * .5f;
+
+		// The levels are indexed by entity so they carry over to the next frame until the scene is replaced.
+		// Entities added since the last frame have no level to stick to
+		m_entityLods.resize(p_scene.getEntities().size(), UNKNOWN_LOD);
+
+		batchEntities(p_scene.getEntities(), visibleEntities);
+
+		// Draw the opaque entities first then the transparent ones in the scene's order
+		for (size_t i = 0; i < m_opaqueBatchCount; i++)
+			drawInstances(m_opaqueBatches[i]);
+
+		for (size_t i = 0; i < m_transparentBatchCount; i++)
+			drawInstances(m_transparentBatches[i]);
+
+		resolve(p_target);
+
+		if (m_antiAliasing == EAntiAliasing::E_FXAA)
+			PostProcess::applyFxaa(p_target, ThreadPool::getDefault());
+
+		m_target = nullptr;
+		m_camera = nullptr;
+		m_lights = nullptr;
+	}
+
+	bool Rasterizer::isOcclusionCullingEnabled() const
+	{
+		return m_isOcclusionCullingEnabled;
+	}
+
+	void Rasterizer::setOcclusionCulling(const bool p_isEnabled)
+	{
+		m_isOcclusionCullingEnabled = p_isEnabled;
+	}
 
-		for (const auto& entity : entities)
+	void Rasterizer::resetLodState()
+	{
+		m_entityLods.clear();
+	}
+
+	bool Rasterizer::isHdrEnabled() const
+	{
+		return m_isHdrEnabled;
+	}
+
+	void Rasterizer::setHdr(const bool p_isEnabled)
+	{
+		m_isHdrEnabled = p_isEnabled;
+	}
+
+	float Rasterizer::getExposure() const
+	{
+		return m_exposure;
+	}
+
+	void Rasterizer::setExposure(const float p_exposure)
+	{
+		if (!(p_exposure > 0.f))
+			throw std::invalid_argument("The exposure must be positive. Received: " + std::to_string(p_exposure));
+
+		m_exposure = p_exposure;
+	}
+
+	void Rasterizer::cullOccludedEntities(const Scene& p_scene, const Frustum& p_frustum,
+		std::vector<size_t>& p_entityIndices)
+	{
+		const auto& entities = p_scene.getEntities();
+
+		std::vector<uint8_t> isOccluder(entities.size(), 0);
+		std::vector<size_t> occluders;
+
+		for (const size_t entityIndex : p_entityIndices)
 		{
-			// Draw the opaque entities and defer the transparent ones' rendering
-			if (entity.isOpaque())
-				drawEntity(entity);
+			const Entity& entity = entities[entityIndex];
+
+			if (entity.getMesh()->isOccluder() && entity.isOpaque())
+			{
+				isOccluder[entityIndex] = 1;
+				occluders.push_back(entityIndex);
+			}
+		}
+
+		if (occluders.empty())
+			return;
+
+		m_occlusionBuffer.clear(m_camera->getProjectionMatrix() * m_camera->getViewMatrix());
+
+		for (const size_t entityIndex : occluders)
+			m_occlusionBuffer.rasterizeOccluder(*entities[entityIndex].getMesh(), entities[entityIndex].getTransform());
+
+		// The occluders are always kept since they would hide themselves
+		p_entityIndices = std::move(occluders);
+
+		// Whole branches of the hierarchy get skipped when their bounds are hidden
+		p_scene.getBoundingVolumeHierarchy().traverse(
+			[&](const AABB& p_bounds)
+			{
+				return p_frustum.intersects(p_bounds) && m_occlusionBuffer.isVisible(p_bounds);
+			},
+			[&](const size_t p_entityIndex)
+			{
+				if (!isOccluder[p_entityIndex])
+					p_entityIndices.push_back(p_entityIndex);
+			});
+	}
+
+	size_t Rasterizer::getSamplesPerPixel() const
+	{
+		return static_cast<size_t>(m_sampleCount) * m_sampleCount;
+	}
+
+	void Rasterizer::updateSampleOffsets()
+	{
+		const size_t samplesPerPixel = getSamplesPerPixel();
+
+		if (m_sampleOffsets.size() == samplesPerPixel)
+			return;
+
+		m_sampleOffsets.clear();
+		m_sampleOffsets.reserve(samplesPerPixel);
+
+		const float step = 1.f / static_cast<float>(m_sampleCount);
+
+		for (uint8_t y = 0; y < m_sampleCount; y++)
+			for (uint8_t x = 0; x < m_sampleCount; x++)
+				m_sampleOffsets.emplace_back((static_cast<float>(x) + .5f) * step,
+					(static_cast<float>(y) + .5f) * step);
+
+		// Tent weights for the samples of the 3x3 pixels around the resolved one, rounded to [0, 255]
+		// so a weighted channel still fits in a 16 bit lane. The rounding makes the tent slightly
+		// approximate when the sample count isn't a power of two
+		m_tentWeights.assign(9 * samplesPerPixel, 0);
+		m_tentWeightSum = 0;
+
+		for (int neighbourY = -1; neighbourY <= 1; neighbourY++)
+		{
+			for (int neighbourX = -1; neighbourX <= 1; neighbourX++)
+			{
+				const size_t neighbour = static_cast<size_t>((neighbourY + 1) * 3 + neighbourX + 1);
+
+				for (size_t i = 0; i < samplesPerPixel; i++)
+				{
+					const float dx = static_cast<float>(neighbourX) + m_sampleOffsets[i].m_x - .5f;
+					const float dy = static_cast<float>(neighbourY) + m_sampleOffsets[i].m_y - .5f;
+					const float weight = LibMath::max(0.f, 1.f - LibMath::abs(dx))
+						* LibMath::max(0.f, 1.f - LibMath::abs(dy));
+
+					const uint16_t intWeight = static_cast<uint16_t>(LibMath::round(weight * UINT8_MAX));
+
+					m_tentWeights[neighbour * samplesPerPixel + i] = intWeight;
+					m_tentWeightSum += intWeight;
+				}
+			}
+		}
+	}
+
+	void Rasterizer::writeSamples(const size_t p_pixelIndex, const uint64_t p_coverageMask,
+		const Color& p_color, const float* p_depths)
+	{
+		const size_t samplesPerPixel = getSamplesPerPixel();
+		const size_t firstSample = p_pixelIndex * samplesPerPixel;
+		const bool isOpaque = p_color.m_a == UINT8_MAX;
+		float* depths = m_zBuffer.getData() + firstSample;
+
+		for (size_t i = 0; i < samplesPerPixel; i++)
+		{
+			if ((p_coverageMask & (1ull << i)) == 0)
+				continue;
+
+			Color& sampleColor = m_sampleBuffer[firstSample + i];
+
+			if (isOpaque)
+			{
+				sampleColor = p_color;
+				depths[i] = p_depths[i];
+			}
 			else
-				transparentEntities.push_back(&entity);
+			{
+				sampleColor = Color(p_color).blend(sampleColor);
+			}
+		}
+	}
+
+	void Rasterizer::writeHdrSamples(const size_t p_pixelIndex, const uint64_t p_coverageMask,
+		const HdrColor& p_color, const float* p_depths)
+	{
+		const size_t samplesPerPixel = getSamplesPerPixel();
+		const size_t firstSample = p_pixelIndex * samplesPerPixel;
+		const bool isOpaque = p_color.m_a == 1.f;
+		HdrColor* samples = m_hdrSampleBuffer.getData() + firstSample;
+		float* depths = m_zBuffer.getData() + firstSample;
+
+		const __m128 color = _mm_loadu_ps(&p_color.m_r);
+		const __m128 sourceAlpha = _mm_set1_ps(p_color.m_a);
+		const __m128 premultiplied = _mm_mul_ps(color, sourceAlpha);
+
+		for (size_t i = 0; i < samplesPerPixel; i++)
+		{
+			if ((p_coverageMask & (1ull << i)) == 0)
+				continue;
+
+			if (isOpaque)
+			{
+				samples[i] = p_color;
+				depths[i] = p_depths[i];
+				continue;
+			}
+
+			// Same blending as Color::blend, the result being opaque
+			const __m128 destination = _mm_loadu_ps(&samples[i].m_r);
+			const __m128 destinationAlpha = _mm_mul_ps(_mm_shuffle_ps(destination, destination, _MM_SHUFFLE(3, 3, 3, 3)),
+				_mm_sub_ps(_mm_set1_ps(1.f), sourceAlpha));
 
-			//drawNormals(entity);
+			_mm_storeu_ps(&samples[i].m_r, _mm_add_ps(premultiplied, _mm_mul_ps(destination, destinationAlpha)));
+			samples[i].m_a = 1.f;
 		}
+	}
+
+	size_t Rasterizer::LightBatch::getLightCount() const
+	{
+		return m_ambients.size();
+	}
+
+	void Rasterizer::batchLights(const std::vector<Light>& p_lights)
+	{
+		// Black lights at the origin pad the batch so the lights are always shaded four at a time
+		const size_t lightCount = (p_lights.size() + 3) / 4 * 4;
+
+		for (auto& element : m_lightBatch.m_positions)
+			element.assign(lightCount, 0.f);
+
+		for (auto& element : m_lightBatch.m_diffuseIntensities)
+			element.assign(lightCount, 0.f);
 
-		for (const auto& entityPtr : transparentEntities)
-			drawEntity(*entityPtr);
+		for (auto& element : m_lightBatch.m_specularIntensities)
+			element.assign(lightCount, 0.f);
 
-		
-		if (m_target == &p_target)
+		m_lightBatch.m_ambients.assign(lightCount, 0.f);
+
+		for (size_t i = 0; i < p_lights.size(); i++)
 		{
-			m_target = nullptr;
+			const Vec3& position = p_lights[i].getPosition();
+			const Vec3 components = p_lights[i].getComponents();
+			const Vec3& intensity = p_lights[i].getIntensity();
+			const float channels[3] = { intensity.m_x, intensity.m_y, intensity.m_z };
+
+			m_lightBatch.m_positions[0][i] = position.m_x;
+			m_lightBatch.m_positions[1][i] = position.m_y;
+			m_lightBatch.m_positions[2][i] = position.m_z;
+			m_lightBatch.m_ambients[i] = components.m_x;
+
+			for (size_t channel = 0; channel < 3; channel++)
+			{
+				m_lightBatch.m_diffuseIntensities[channel][i] = components.m_y * channels[channel];
+				m_lightBatch.m_specularIntensities[channel][i] = components.m_z * channels[channel];
+			}
+		}
+	}
+
+	void Rasterizer::resolve(Texture& p_target) const
+	{
+		ThreadPool::getDefault().parallelFor(p_target.getHeight(),
+			[this, &p_target](const size_t p_begin, const size_t p_end)
+			{
+				resolveRows(p_target.getPixels() + p_begin * p_target.getWidth(), p_begin, p_end);
+			}, 8);
+	}
+
+	void Rasterizer::resolveRows(Color* p_rows, const size_t p_firstRow, const size_t p_lastRow) const
+	{
+		if (m_isHdrFrame)
+			resolveHdrRows(p_rows, p_firstRow, p_lastRow);
+		else if (m_resolveFilter == EResolveFilter::E_TENT)
+			resolveTentRows(p_rows, p_firstRow, p_lastRow);
+		else
+			resolveBoxRows(p_rows, p_firstRow, p_lastRow);
+	}
+
+	template <typename TFormat>
+	void Rasterizer::resolve(PixelBuffer<TFormat>& p_target) const
+	{
+		static_assert(!TFormat::IS_DEPTH, "Colors are resolved in color formats");
+
+		p_target.reset(m_frameWidth, m_frameHeight, typename TFormat::Storage {});
+
+		ThreadPool::getDefault().parallelFor(m_frameHeight,
+			[this, &p_target](const size_t p_begin, const size_t p_end)
+			{
+				// Each row goes through the usual kernels then is converted while still in cache
+				std::vector<Color> row(m_frameWidth);
+
+				for (size_t y = p_begin; y < p_end; y++)
+				{
+					resolveRows(row.data(), y, y + 1);
+
+					typename TFormat::Storage* pixels = p_target.getData() + y * m_frameWidth;
+
+					for (size_t x = 0; x < row.size(); x++)
+						pixels[x] = TFormat::fromColor(row[x]);
+				}
+			}, 8);
+	}
+
+	template <typename TFormat>
+	void Rasterizer::resolveDepth(PixelBuffer<TFormat>& p_target) const
+	{
+		static_assert(TFormat::IS_DEPTH, "Depths are resolved in depth formats");
+
+		p_target.reset(m_frameWidth, m_frameHeight, typename TFormat::Storage {});
+
+		const size_t samplesPerPixel = getSamplesPerPixel();
+		const float* depths = m_zBuffer.getData();
+		typename TFormat::Storage* pixels = p_target.getData();
+
+		for (size_t pixel = 0; pixel < static_cast<size_t>(m_frameWidth) * m_frameHeight; pixel++)
+		{
+			float depth = INFINITY;
+
+			for (size_t i = 0; i < samplesPerPixel; i++)
+				depth = LibMath::min(depth, depths[pixel * samplesPerPixel + i]);
+
+			pixels[pixel] = TFormat::fromDepth(depth);
+		}
+	}
+
+	template void Rasterizer::resolve(PixelBuffer<FormatR8>&) const;
+	template void Rasterizer::resolve(PixelBuffer<FormatRG8>&) const;
+	template void Rasterizer::resolve(PixelBuffer<FormatRGBA8>&) const;
+	template void Rasterizer::resolve(PixelBuffer<FormatRGB565>&) const;
+	template void Rasterizer::resolve(PixelBuffer<FormatRGBA16F>&) const;
+	template void Rasterizer::resolve(PixelBuffer<FormatRGBA32F>&) const;
+	template void Rasterizer::resolve(PixelBuffer<FormatR32F>&) const;
+	template void Rasterizer::resolveDepth(PixelBuffer<FormatD16>&) const;
+	template void Rasterizer::resolveDepth(PixelBuffer<FormatD32F>&) const;
+
+	void Rasterizer::resolveBoxRows(Color* p_rows, const size_t p_firstRow, const size_t p_lastRow) const
+	{
+		const size_t width = m_frameWidth;
+		const size_t samplesPerPixel = getSamplesPerPixel();
+		const Color* samples = m_sampleBuffer.data();
+
+		if (samplesPerPixel == 1)
+		{
+			std::memcpy(p_rows, samples + p_firstRow * width,
+				(p_lastRow - p_firstRow) * width * sizeof(Color));
 			return;
 		}
 
-		const LibMath::Vector2 deltaSize(	static_cast<float>(p_target.getWidth()),
-									static_cast<float>(p_target.getHeight()));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 invSampleCount = _mm_set1_ps(1.f / static_cast<float>(samplesPerPixel));
+		const __m128 half = _mm_set1_ps(.5f);
+
+		for (size_t y = p_firstRow; y < p_lastRow; y++)
+		{
+			const Color* rowSamples = samples + y * width * samplesPerPixel;
+			Color* row = p_rows + (y - p_firstRow) * width;
+
+			for (size_t x = 0; x < width; x++)
+			{
+				const Color* pixelSamples = rowSamples + x * samplesPerPixel;
+
+				// 16 bit sums of 2 samples per register half (at most 32 * 255 with 8x8 samples)
+				__m128i sum = zero;
+				size_t i = 0;
+
+				for (; i + 4 <= samplesPerPixel; i += 4)
+				{
+					const __m128i fourSamples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixelSamples + i));
+					sum = _mm_add_epi16(sum, _mm_unpacklo_epi8(fourSamples, zero));
+					sum = _mm_add_epi16(sum, _mm_unpackhi_epi8(fourSamples, zero));
+				}
+
+				for (; i < samplesPerPixel; i++)
+				{
+					uint32_t packedSample;
+					std::memcpy(&packedSample, pixelSamples + i, sizeof(Color));
+					sum = _mm_add_epi16(sum, _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(packedSample)), zero));
+				}
+
+				// Fold the two halves then divide with rounding. The reciprocal isn't exact when the sample
+				// count isn't a power of two, so such averages may be one off from an exact division
+				sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+
+				const __m128 average = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(sum, zero)),
+					invSampleCount), half);
+
+				const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(_mm_cvttps_epi32(average), zero), zero);
+				const uint32_t color = static_cast<uint32_t>(_mm_cvtsi128_si32(packed));
+
+				std::memcpy(row + x, &color, sizeof(Color));
+			}
+		}
+	}
+
+	void Rasterizer::resolveTentRows(Color* p_rows, const size_t p_firstRow, const size_t p_lastRow) const
+	{
+		const int width = static_cast<int>(m_frameWidth);
+		const int height = static_cast<int>(m_frameHeight);
+		const size_t samplesPerPixel = getSamplesPerPixel();
+		const Color* samples = m_sampleBuffer.data();
+
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 invWeightSum = _mm_set1_ps(1.f / static_cast<float>(m_tentWeightSum));
+		const __m128 half = _mm_set1_ps(.5f);
+
+		// Skip the neighbours whose samples are all outside of the tent
+		bool isNeighbourUsed[9];
+
+		for (size_t neighbour = 0; neighbour < 9; neighbour++)
+		{
+			isNeighbourUsed[neighbour] = false;
+
+			for (size_t i = 0; i < samplesPerPixel; i++)
+				isNeighbourUsed[neighbour] |= m_tentWeights[neighbour * samplesPerPixel + i] != 0;
+		}
+
+		for (size_t row = p_firstRow; row < p_lastRow; row++)
+		{
+			const int y = static_cast<int>(row);
+
+			for (int x = 0; x < width; x++)
+			{
+				__m128i sum = zero;
+
+				for (int neighbourY = -1; neighbourY <= 1; neighbourY++)
+				{
+					// Replicate the border samples outside of the target
+					const int sampleY = LibMath::min(LibMath::max(y + neighbourY, 0), height - 1);
+
+					for (int neighbourX = -1; neighbourX <= 1; neighbourX++)
+					{
+						const size_t neighbour = static_cast<size_t>((neighbourY + 1) * 3 + neighbourX + 1);
+
+						if (!isNeighbourUsed[neighbour])
+							continue;
+
+						const int sampleX = LibMath::min(LibMath::max(x + neighbourX, 0), width - 1);
+						const Color* pixelSamples = samples
+							+ (static_cast<size_t>(sampleY) * width + sampleX) * samplesPerPixel;
+						const uint16_t* weights = m_tentWeights.data() + neighbour * samplesPerPixel;
+
+						for (size_t i = 0; i < samplesPerPixel; i++)
+						{
+							if (weights[i] == 0)
+								continue;
+
+							uint32_t packedSample;
+							std::memcpy(&packedSample, pixelSamples + i, sizeof(Color));
+
+							// 8 bit channel * 8 bit weight fits in 16 bits, accumulate in 32 bits
+							const __m128i channels = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(packedSample)), zero);
+							const __m128i weighted = _mm_mullo_epi16(channels, _mm_set1_epi16(static_cast<short>(weights[i])));
+
+							sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(weighted, zero));
+						}
+					}
+				}
+
+				const __m128 average = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum), invWeightSum), half);
+
+				const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(_mm_cvttps_epi32(average), zero), zero);
+				const uint32_t color = static_cast<uint32_t>(_mm_cvtsi128_si32(packed));
+
+				std::memcpy(p_rows + (row - p_firstRow) * width + x, &color, sizeof(Color));
+			}
+		}
+	}
+
+	void Rasterizer::resolveHdrRows(Color* p_rows, const size_t p_firstRow, const size_t p_lastRow) const
+	{
+		const int width = static_cast<int>(m_frameWidth);
+		const int height = static_cast<int>(m_frameHeight);
+		const size_t samplesPerPixel = getSamplesPerPixel();
+		const HdrColor* samples = m_hdrSampleBuffer.getData();
+		const bool isTent = m_resolveFilter == EResolveFilter::E_TENT;
 
-		const float floatSampleCount = m_sampleCount;
+		const __m128 invWeightSum = _mm_set1_ps(isTent ? 1.f / static_cast<float>(m_tentWeightSum)
+			: 1.f / static_cast<float>(samplesPerPixel));
+		const __m128 exposure = _mm_set1_ps(m_exposure);
 
-		for (uint32_t x = 0; x < p_target.getWidth(); x++) //draw form msaa to p_texture
+		for (size_t row = p_firstRow; row < p_lastRow; row++)
 		{
-			for (uint32_t y = 0; y < p_target.getHeight(); y++)
+			const int y = static_cast<int>(row);
+
+			for (int x = 0; x < width; x++)
 			{
-				const float msaaX = floatSampleCount * static_cast<float>(x) + floatSampleCount * .5f;
-				const float msaaY = floatSampleCount * static_cast<float>(y) + floatSampleCount * .5f;
+				__m128 sum = _mm_setzero_ps();
 
-				p_target.setPixelColor(x, y,
-					m_target->getPixelColorBlerp(msaaX, msaaY, deltaSize));
+				if (isTent)
+				{
+					// Same weights and border replication as the 8 bit tent resolve
+					for (int neighbourY = -1; neighbourY <= 1; neighbourY++)
+					{
+						const int sampleY = LibMath::min(LibMath::max(y + neighbourY, 0), height - 1);
+
+						for (int neighbourX = -1; neighbourX <= 1; neighbourX++)
+						{
+							const size_t neighbour = static_cast<size_t>((neighbourY + 1) * 3 + neighbourX + 1);
+							const int sampleX = LibMath::min(LibMath::max(x + neighbourX, 0), width - 1);
+							const HdrColor* pixelSamples = samples
+								+ (static_cast<size_t>(sampleY) * width + sampleX) * samplesPerPixel;
+							const uint16_t* weights = m_tentWeights.data() + neighbour * samplesPerPixel;
+
+							for (size_t i = 0; i < samplesPerPixel; i++)
+							{
+								if (weights[i] != 0)
+									sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&pixelSamples[i].m_r),
+										_mm_set1_ps(static_cast<float>(weights[i]))));
+							}
+						}
+					}
+				}
+				else
+				{
+					const HdrColor* pixelSamples = samples + (static_cast<size_t>(y) * width + x) * samplesPerPixel;
+
+					for (size_t i = 0; i < samplesPerPixel; i++)
+						sum = _mm_add_ps(sum, _mm_loadu_ps(&pixelSamples[i].m_r));
+				}
+
+				p_rows[(row - p_firstRow) * width + x] = encodeHdr(_mm_mul_ps(sum, invWeightSum), exposure);
 			}
 		}
+	}
 
-		m_target = nullptr;
-		m_camera = nullptr;
-		m_lights = nullptr;
-		m_zBuffer.clear();
+	Rasterizer::EResolveFilter Rasterizer::getResolveFilter() const
+	{
+		return m_resolveFilter;
+	}
+
+	void Rasterizer::setResolveFilter(const EResolveFilter p_filter)
+	{
+		m_resolveFilter = p_filter;
+	}
+
+	size_t Rasterizer::InstanceBatch::getInstanceCount() const
+	{
+		return m_transparencies.size();
+	}
+
+	void Rasterizer::InstanceBatch::addInstance(const Entity& p_entity)
+	{
+		const Mat4 transform = p_entity.getTransform();
+		const Mat4 rotation = p_entity.getRotation();
+
+		for (size_t i = 0; i < 12; i++)
+			m_transforms[i].push_back(transform[i]);
+
+		for (size_t row = 0; row < 3; row++)
+		{
+			for (size_t col = 0; col < 3; col++)
+				m_rotations[row * 3 + col].push_back(rotation[row * 4 + col]);
+		}
+
+		m_transparencies.push_back(p_entity.getTransparency());
+	}
+
+	void Rasterizer::InstanceBatch::clear()
+	{
+		for (auto& element : m_transforms)
+			element.clear();
+
+		for (auto& element : m_rotations)
+			element.clear();
+
+		m_transparencies.clear();
+	}
+
+	void Rasterizer::batchEntities(const std::vector<Entity>& p_entities, const std::vector<size_t>& p_entityIndices)
+	{
+		m_opaqueBatchCount = 0;
+		m_transparentBatchCount = 0;
+
+		std::unordered_map<const Mesh*, size_t> opaqueBatchIndices;
+
+		for (const size_t entityIndex : p_entityIndices)
+		{
+			const Entity& entity = p_entities[entityIndex];
+
+			if (entity.getMesh() == nullptr)
+				continue;
+
+			const Mesh* mesh = &entity.getMesh()->getLod(selectLod(entity, entityIndex));
+
+			if (entity.isOpaque())
+			{
+				const auto it = opaqueBatchIndices.find(mesh);
+
+				if (it != opaqueBatchIndices.end())
+				{
+					m_opaqueBatches[it->second].addInstance(entity);
+					continue;
+				}
+
+				opaqueBatchIndices[mesh] = m_opaqueBatchCount;
+				acquireBatch(m_opaqueBatches, m_opaqueBatchCount, mesh).addInstance(entity);
+				continue;
+			}
+
+			if (m_transparentBatchCount != 0 && m_transparentBatches[m_transparentBatchCount - 1].m_mesh == mesh)
+			{
+				m_transparentBatches[m_transparentBatchCount - 1].addInstance(entity);
+				continue;
+			}
+
+			acquireBatch(m_transparentBatches, m_transparentBatchCount, mesh).addInstance(entity);
+		}
 	}
 
-	void Rasterizer::drawEntity(const Entity& p_entity)
+	size_t Rasterizer::selectLod(const Entity& p_entity, const size_t p_entityIndex)
 	{
-		if (m_camera == nullptr || m_target == nullptr
-			|| p_entity.getMesh() == nullptr)
+		const Mesh& mesh = *p_entity.getMesh();
+		const size_t lodCount = mesh.getLodCount();
+
+		if (lodCount == 1)
+			return 0;
+
+		const BoundingSphere bounds = p_entity.getBoundingSphere();
+		const float* vp = m_viewProjection;
+
+		// Clip space w is the distance along the view direction
+		const float depth = vp[12] * bounds.m_center.m_x + vp[13] * bounds.m_center.m_y
+			+ vp[14] * bounds.m_center.m_z + vp[15];
+
+		// The camera is inside the sphere - the entity covers the whole screen
+		const float screenSize = depth > bounds.m_radius ?
+			2.f * bounds.m_radius * m_projectionScale / depth : INFINITY;
+
+		// The finest level the screen size is large enough for
+		size_t level = 0;
+
+		while (level + 1 < lodCount && screenSize < mesh.getLodScreenSize(level))
+			level++;
+
+		const size_t previousLevel = m_entityLods[p_entityIndex];
+
+		if (previousLevel < lodCount && level != previousLevel)
+		{
+			// Only leave the previous level once the size is clearly out of its range
+			const bool isClearlySmaller = level > previousLevel
+				&& screenSize < mesh.getLodScreenSize(previousLevel) * (1.f - LOD_HYSTERESIS);
+
+			const bool isClearlyLarger = level < previousLevel
+				&& screenSize > mesh.getLodScreenSize(previousLevel - 1) * (1.f + LOD_HYSTERESIS);
+
+			if (!isClearlySmaller && !isClearlyLarger)
+				level = previousLevel;
+		}
+
+		m_entityLods[p_entityIndex] = static_cast<uint8_t>(level);
+
+		return level;
+	}
+
+	Rasterizer::InstanceBatch& Rasterizer::acquireBatch(std::vector<InstanceBatch>& p_batches, size_t& p_batchCount,
+		const Mesh* p_mesh)
+	{
+		if (p_batchCount == p_batches.size())
+			p_batches.emplace_back();
+
+		InstanceBatch& batch = p_batches[p_batchCount++];
+		batch.clear();
+		batch.m_mesh = p_mesh;
+
+		return batch;
+	}
+
+	void Rasterizer::drawInstances(const InstanceBatch& p_batch)
+	{
+		if (m_camera == nullptr || m_target == nullptr || p_batch.m_mesh == nullptr)
 			return;
 
-		auto vertices = p_entity.getMesh()->getVertices();
-		auto normals = p_entity.getMesh()->getNormals();
-		const auto indices = p_entity.getMesh()->getIndices();
+		// Fetched once for every instance
+		const Mesh& mesh = *p_batch.m_mesh;
+		const auto& normals = mesh.getNormals();
+		const auto& indices = mesh.getIndices();
+		const Texture* texture = mesh.getTexture();
+		const size_t vertexCount = mesh.getVertexCount();
 
-		std::vector<Vec3> pixelPoints;
-		pixelPoints.reserve(vertices.size());
+		m_instanceVertices.resize(vertexCount);
+		m_instancePixels.resize(vertexCount);
+		m_instanceNormals.resize(normals.size());
 
-		// Model matrix not required since it's directly applied to vertices
-		const Mat4 mvpMatrix = m_camera->getProjectionMatrix()
-			* m_camera->getViewMatrix();
+		for (size_t instance = 0; instance < p_batch.getInstanceCount(); instance++)
+		{
+			float m[12];
+			float r[9];
 
-		const Vec3 viewPos = m_camera->getPosition();
+			for (size_t i = 0; i < 12; i++)
+				m[i] = p_batch.m_transforms[i][instance];
 
-		for (auto& v : vertices)
+			for (size_t i = 0; i < 9; i++)
+				r[i] = p_batch.m_rotations[i][instance];
+
+			const float transparency = p_batch.m_transparencies[instance];
+
+			// Packed vertices are decoded on the fly rather than into a full precision copy
+			if (mesh.hasCompressedVertices())
+			{
+				transformInstanceVertices(mesh.getPackedVertices().data(), vertexCount, mesh.getVertexQuantization(),
+					m, r, transparency);
+			}
+			else if (mesh.getVertexLayout() == EVertexLayout::E_SEPARATE)
+			{
+				transformInstanceStreams(mesh.getVertexStreams(), m, r, transparency);
+			}
+			else
+			{
+				transformInstanceVertices(mesh.getVertices().data(), vertexCount, mesh.getVertexQuantization(),
+					m, r, transparency);
+			}
+
+			for (size_t i = 0; i < normals.size(); i++)
+			{
+				const Vec3& normal = normals[i];
+				m_instanceNormals[i] =
+				{
+					r[0] * normal.m_x + r[1] * normal.m_y + r[2] * normal.m_z,
+					r[3] * normal.m_x + r[4] * normal.m_y + r[5] * normal.m_z,
+					r[6] * normal.m_x + r[7] * normal.m_y + r[8] * normal.m_z
+				};
+			}
+
+			indices.visit([&](const auto* p_indices)
+			{
+				drawInstanceTriangles(p_indices, indices.size(), texture);
+			});
+		}
+	}
+
+	void Rasterizer::transformInstanceStreams(const VertexStreams& p_streams, const float p_transform[12],
+		const float p_rotation[9], const float p_transparency)
+	{
+		const Vector3Streams positions = p_streams.getPositions();
+		const Vector3Streams normals = p_streams.getNormals();
+		const StreamView<Color> colors = p_streams.getColors();
+		const TexCoordStreams texCoords = p_streams.getTexCoords();
+		const size_t vertexCount = p_streams.size();
+
+		__m128 m[12];
+		__m128 r[9];
+		__m128 vp[16];
+
+		for (size_t i = 0; i < 12; i++)
+			m[i] = _mm_set1_ps(p_transform[i]);
+
+		for (size_t i = 0; i < 9; i++)
+			r[i] = _mm_set1_ps(p_rotation[i]);
+
+		for (size_t i = 0; i < 16; i++)
+			vp[i] = _mm_set1_ps(m_viewProjection[i]);
+
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 halfWidth = _mm_set1_ps(2.f / static_cast<float>(m_target->getWidth()));
+		const __m128 halfHeight = _mm_set1_ps(2.f / static_cast<float>(m_target->getHeight()));
+
+		// World position, pixel coordinates and normal of each lane
+		alignas(16) float lanes[9][VertexStreams::SIMD_WIDTH];
+
+		// The streams are padded so the last block can be loaded whole
+		for (size_t first = 0; first < vertexCount; first += VertexStreams::SIMD_WIDTH)
 		{
-			// Update vertex positions
-			Vec3& pos = v.m_position;
-			Vec4 vec4 = { pos.m_x, pos.m_y, pos.m_z, 1.f };
-			vec4 = p_entity.getTransform() * vec4;
-			pos = { vec4.m_x, vec4.m_y, vec4.m_z };
+			const __m128 localX = _mm_loadu_ps(positions.m_x.data() + first);
+			const __m128 localY = _mm_loadu_ps(positions.m_y.data() + first);
+			const __m128 localZ = _mm_loadu_ps(positions.m_z.data() + first);
+
+			// Model space to world space
+			const __m128 x = transformPoints(m, localX, localY, localZ);
+			const __m128 y = transformPoints(m + 4, localX, localY, localZ);
+			const __m128 z = transformPoints(m + 8, localX, localY, localZ);
+
+			// World space to pixel coordinates (see worldToPixel)
+			const __m128 clipX = transformPoints(vp, x, y, z);
+			const __m128 clipY = transformPoints(vp + 4, x, y, z);
+			const __m128 clipZ = transformPoints(vp + 8, x, y, z);
+			const __m128 clipW = transformPoints(vp + 12, x, y, z);
+
+			_mm_store_ps(lanes[0], x);
+			_mm_store_ps(lanes[1], y);
+			_mm_store_ps(lanes[2], z);
+			_mm_store_ps(lanes[3], _mm_div_ps(_mm_add_ps(_mm_div_ps(clipX, clipW), one), halfWidth));
+			_mm_store_ps(lanes[4], _mm_div_ps(_mm_sub_ps(one, _mm_div_ps(clipY, clipW)), halfHeight));
+			_mm_store_ps(lanes[5], _mm_div_ps(clipZ, clipW));
+
+			const __m128 normalX = _mm_loadu_ps(normals.m_x.data() + first);
+			const __m128 normalY = _mm_loadu_ps(normals.m_y.data() + first);
+			const __m128 normalZ = _mm_loadu_ps(normals.m_z.data() + first);
+
+			_mm_store_ps(lanes[6], transformDirections(r, normalX, normalY, normalZ));
+			_mm_store_ps(lanes[7], transformDirections(r + 3, normalX, normalY, normalZ));
+			_mm_store_ps(lanes[8], transformDirections(r + 6, normalX, normalY, normalZ));
+
+			// The rasterization stage works on whole vertices
+			const size_t laneCount = std::min(VertexStreams::SIMD_WIDTH, vertexCount - first);
+
+			for (size_t lane = 0; lane < laneCount; lane++)
+			{
+				const size_t i = first + lane;
+				Vertex& vertex = m_instanceVertices[i];
 
-			pixelPoints.push_back(worldToPixel(pos, *m_target, mvpMatrix));
+				vertex.m_position = { lanes[0][lane], lanes[1][lane], lanes[2][lane] };
+				vertex.m_normal = { lanes[6][lane], lanes[7][lane], lanes[8][lane] };
+				vertex.m_color = colors[i];
+				vertex.m_u = texCoords.m_u[i];
+				vertex.m_v = texCoords.m_v[i];
 
-			// Update vertex normals
-			auto& nor = v.m_normal;
-			vec4 = { nor.m_x, nor.m_y, nor.m_z, 0.f };
-			vec4 = p_entity.getRotation() * vec4;
-			nor = { vec4.m_x, vec4.m_y, vec4.m_z };
+				const float floatAlpha = colors[i].m_a;
+				vertex.m_color.m_a = static_cast<uint8_t>(floatAlpha * p_transparency);
 
-			// Update vertex alpha
-			const float floatAlpha = v.m_color.m_a;
-			v.m_color.m_a = static_cast<uint8_t>(floatAlpha * p_entity.getTransparency());
+				m_instancePixels[i] = { lanes[3][lane], lanes[4][lane], lanes[5][lane] };
+			}
 		}
+	}
+
+	template <typename TVertex>
+	void Rasterizer::transformInstanceVertices(const TVertex* p_vertices, const size_t p_vertexCount,
+		const VertexQuantization& p_quantization, const float p_transform[12], const float p_rotation[9],
+		const float p_transparency)
+	{
+		const float halfWidth = 2.f / static_cast<float>(m_target->getWidth());
+		const float halfHeight = 2.f / static_cast<float>(m_target->getHeight());
+		const float* vp = m_viewProjection;
+		const float* m = p_transform;
+		const float* r = p_rotation;
 
-		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		for (size_t i = 0; i < p_vertexCount; i++)
 		{
-			auto& normal = normals[i / 3];
-			LibMath::Vector4 normal4 = LibMath::Vector4(normal.m_x, normal.m_y, normal.m_z, 0.f);
-			normal4 = p_entity.getRotation() * normal4;
-			normal = { normal4.m_x, normal4.m_y, normal4.m_z };
+			const Vertex& source = decodeVertex(p_vertices[i], p_quantization);
+			Vertex& vertex = m_instanceVertices[i];
+			vertex = source;
+
+			// Model space to world space
+			const Vec3& localPos = source.m_position;
+			const Vec3 pos
+			{
+				m[0] * localPos.m_x + m[1] * localPos.m_y + m[2] * localPos.m_z + m[3],
+				m[4] * localPos.m_x + m[5] * localPos.m_y + m[6] * localPos.m_z + m[7],
+				m[8] * localPos.m_x + m[9] * localPos.m_y + m[10] * localPos.m_z + m[11]
+			};
+
+			vertex.m_position = pos;
 
+			// World space to pixel coordinates (see worldToPixel)
+			const float clipX = vp[0] * pos.m_x + vp[1] * pos.m_y + vp[2] * pos.m_z + vp[3];
+			const float clipY = vp[4] * pos.m_x + vp[5] * pos.m_y + vp[6] * pos.m_z + vp[7];
+			const float clipZ = vp[8] * pos.m_x + vp[9] * pos.m_y + vp[10] * pos.m_z + vp[11];
+			const float clipW = vp[12] * pos.m_x + vp[13] * pos.m_y + vp[14] * pos.m_z + vp[15];
+
+			m_instancePixels[i] =
+			{
+				(clipX / clipW + 1.f) / halfWidth,
+				(1.f - clipY / clipW) / halfHeight,
+				clipZ / clipW
+			};
+
+			const Vec3& normal = source.m_normal;
+			vertex.m_normal =
+			{
+				r[0] * normal.m_x + r[1] * normal.m_y + r[2] * normal.m_z,
+				r[3] * normal.m_x + r[4] * normal.m_y + r[5] * normal.m_z,
+				r[6] * normal.m_x + r[7] * normal.m_y + r[8] * normal.m_z
+			};
+
+			const float floatAlpha = source.m_color.m_a;
+			vertex.m_color.m_a = static_cast<uint8_t>(floatAlpha * p_transparency);
+		}
+	}
+
+	template <typename TIndex>
+	void Rasterizer::drawInstanceTriangles(const TIndex* p_indices, const size_t p_indexCount, const Texture* p_texture)
+	{
+		for (size_t i = 0; i + 2 < p_indexCount; i += 3)
+		{
 			const Vertex triangle[3]
 			{
-				vertices[indices[i]],
-				vertices[indices[i + 1]],
-				vertices[indices[i + 2]]
+				m_instanceVertices[p_indices[i]],
+				m_instanceVertices[p_indices[i + 1]],
+				m_instanceVertices[p_indices[i + 2]]
 			};
 
 			const Vec3 pixelTriangle[3]
 			{
-				pixelPoints[indices[i]],
-				pixelPoints[indices[i + 1]],
-				pixelPoints[indices[i + 2]]
+				m_instancePixels[p_indices[i]],
+				m_instancePixels[p_indices[i + 1]],
+				m_instancePixels[p_indices[i + 2]]
 			};
 
-			Vec3 centerPt = (triangle[0].m_position + triangle[1].m_position + triangle[2].m_position) / 3;
+			const Vec3 centerPt = (triangle[0].m_position + triangle[1].m_position + triangle[2].m_position) / 3;
 
-			if (shouldDrawFace(centerPt, normal, viewPos)
-				&& checkFacingDirection(centerPt, viewPos, m_camera->getForward()))
-				m_drawTriangle(triangle, pixelTriangle, p_entity.getMesh()->getTexture(), *this);
+			if (shouldDrawFace(centerPt, m_instanceNormals[i / 3], m_viewPosition)
+				&& checkFacingDirection(centerPt, m_viewPosition, m_viewDirection))
+				m_drawTriangle(triangle, pixelTriangle, p_texture, *this);
 		}
 	}
 
@@ -173,7 +1178,7 @@ namespace My
 		if (p_entity.getMesh() == nullptr)
 			return;
 
-		auto vertices = p_entity.getMesh()->getVertices();
+		auto vertices = p_entity.getMesh()->decodeVertices();
 		const auto indices = p_entity.getMesh()->getIndices();
 
 		// Model matrix not required since it's directly applied to vertices
@@ -261,77 +1266,84 @@ namespace My
 		const LibMath::Vector2 vs2(p_pixelTriangle[2].m_x - p_pixelTriangle[0].m_x,
 			p_pixelTriangle[2].m_y - p_pixelTriangle[0].m_y);
 
-		for (int x = minX; x <= maxX; x++)
-		{
-			for (int y = minY; y <= maxY; y++)
-			{
-				LibMath::Vector2 q(static_cast<float>(x) - p_pixelTriangle[0].m_x,
-					static_cast<float>(y) - p_pixelTriangle[0].m_y);
-
-				const float t = q.cross(vs2) / vs1.cross(vs2);
-				const float w = vs1.cross(q) / vs1.cross(vs2);
-				const float s = 1 - t - w;
+		const float area = vs1.cross(vs2);
 
-				if (!fillCanDrawPixel(LibMath::Vector3(s, t, w)))
-					continue;
+		if (LibMath::floatEquals(area, 0.f))
+			return;
 
-				const size_t bufferIndex = static_cast<size_t>(y) * p_self.m_target->getWidth() + x;
+		const float textureLod = p_texture == nullptr ? 0.f
+			: computeTextureLod(p_vertices, vs1, vs2, area, *p_texture);
 
-				const float pixelZ = p_pixelTriangle[0].m_z * s
-					+ p_pixelTriangle[1].m_z * t
-					+ p_pixelTriangle[2].m_z * w;
+		// Lets the residency manager know which mip levels are in use
+		if (p_texture != nullptr)
+			p_texture->recordSampledLod(textureLod);
 
-				if (LibMath::abs(pixelZ) > 1 || pixelZ >= p_self.m_zBuffer[bufferIndex])
-					continue;
+		const size_t samplesPerPixel = p_self.getSamplesPerPixel();
+		const LibMath::Vector2* sampleOffsets = p_self.m_sampleOffsets.data();
 
-				Color pixelColor = p_vertices[0].m_color * s
-					+ p_vertices[1].m_color * t
-					+ p_vertices[2].m_color * w;
+		float sampleDepths[MAX_SAMPLE_COUNT * MAX_SAMPLE_COUNT];
 
-				// Round up alpha to account for precision loss
-				pixelColor.m_a = pixelColor.m_a >= UINT8_MAX - 2 ? UINT8_MAX : pixelColor.m_a;
+		for (int y = minY; y <= maxY; y++)
+		{
+			for (int x = minX; x <= maxX; x++)
+			{
+				const size_t pixelIndex = static_cast<size_t>(y) * p_self.m_target->getWidth() + x;
+				const float* zBuffer = p_self.m_zBuffer.getData() + pixelIndex * samplesPerPixel;
 
-				if (pixelColor.m_a != UINT8_MAX)
-					pixelColor.blend(p_self.m_target->getPixelColor(x, y));
-				else
-					p_self.m_zBuffer[bufferIndex] = pixelZ;
+				// Coverage and depth are evaluated for every sample of the pixel...
+				uint64_t coverageMask = 0;
+				LibMath::Vector3 shadingStw;
 
-				if (p_texture != nullptr)
+				for (size_t i = 0; i < samplesPerPixel; i++)
 				{
-					const float u = p_vertices[0].m_u * s + p_vertices[1].m_u * t + p_vertices[2].m_u * w;
-					const float v = p_vertices[0].m_v * s + p_vertices[1].m_v * t + p_vertices[2].m_v * w;
+					const LibMath::Vector2 q(static_cast<float>(x) + sampleOffsets[i].m_x - p_pixelTriangle[0].m_x,
+						static_cast<float>(y) + sampleOffsets[i].m_y - p_pixelTriangle[0].m_y);
 
-					const float textureX = (u - LibMath::floor(u))
-						* static_cast<float>(p_texture->getWidth());
+					const float t = q.cross(vs2) / area;
+					const float w = vs1.cross(q) / area;
+					const float s = 1 - t - w;
 
-					const float textureY = (v - LibMath::floor(v))
-						* static_cast<float>(p_texture->getHeight());
+					if (!fillCanDrawPixel(LibMath::Vector3(s, t, w)))
+						continue;
 
-					pixelColor *= p_texture->getPixelColor(static_cast<uint32_t>(LibMath::round(textureX)),
-						static_cast<uint32_t>(LibMath::round(textureY)));
-				}
+					sampleDepths[i] = p_pixelTriangle[0].m_z * s
+						+ p_pixelTriangle[1].m_z * t
+						+ p_pixelTriangle[2].m_z * w;
 
-				if (p_self.m_lights != nullptr && !p_self.m_lights->empty())
-				{
-					const LibMath::Vector3 vertPos = p_vertices[0].m_position * s
-						+ p_vertices[1].m_position * t
-						+ p_vertices[2].m_position * w;
+					if (LibMath::abs(sampleDepths[i]) > 1 || sampleDepths[i] >= zBuffer[i])
+						continue;
+
+					// Shade at the first covered sample if the pixel's center isn't covered
+					if (coverageMask == 0)
+						shadingStw = LibMath::Vector3(s, t, w);
+
+					coverageMask |= 1ull << i;
+				}
 
-					LibMath::Vector3 normal = p_vertices[0].m_normal * s
-						+ p_vertices[1].m_normal * t
-						+ p_vertices[2].m_normal * w;
+				if (coverageMask == 0)
+					continue;
 
-					normal.normalize();
+				// ...but the pixel is shaded only once, at its center when it's inside the triangle
+				const LibMath::Vector2 center(static_cast<float>(x) + .5f - p_pixelTriangle[0].m_x,
+					static_cast<float>(y) + .5f - p_pixelTriangle[0].m_y);
 
-					Color litColor = Color::black;
+				const float centerT = center.cross(vs2) / area;
+				const float centerW = vs1.cross(center) / area;
+				const LibMath::Vector3 centerStw(1 - centerT - centerW, centerT, centerW);
 
-					for (const auto& light : *p_self.m_lights)
-						litColor += light.calculateLightingBlinnPhong(vertPos, pixelColor, normal, p_self.m_camera->getPosition());
+				if (fillCanDrawPixel(centerStw))
+					shadingStw = centerStw;
 
-					pixelColor = litColor;
+				if (p_self.m_isHdrFrame)
+				{
+					p_self.writeHdrSamples(pixelIndex, coverageMask,
+						shadeHdrPixel(p_vertices, shadingStw, p_texture, textureLod, p_self), sampleDepths);
+					continue;
 				}
 
-				p_self.m_target->setPixelColor(x, y, pixelColor);
+				const Color pixelColor = shadePixel(p_vertices, shadingStw, p_texture, textureLod, p_self);
+
+				p_self.writeSamples(pixelIndex, coverageMask, pixelColor, sampleDepths);
 			}
 		}
 	}
@@ -365,18 +1377,27 @@ namespace My
 		const LibMath::Vector2 vs2(p_pixelTriangle[2].m_x - p_pixelTriangle[0].m_x,
 			p_pixelTriangle[2].m_y - p_pixelTriangle[0].m_y);
 
-		// Delta Triangle size * delta UV's
-		const float deltaU =	LibMath::max(LibMath::max(p_vertices[0].m_u, p_vertices[1].m_u), p_vertices[2].m_u) -
-						LibMath::min(LibMath::min(p_vertices[0].m_u, p_vertices[1].m_u), p_vertices[2].m_u);
-		const float deltaV =	LibMath::max(LibMath::max(p_vertices[0].m_v, p_vertices[1].m_v), p_vertices[2].m_v) -
-						LibMath::min(LibMath::min(p_vertices[0].m_v, p_vertices[1].m_v), p_vertices[2].m_v);
+		const LibMath::Vector2 pixelPoints[3]
+		{
+			{ p_pixelTriangle[0].m_x, p_pixelTriangle[0].m_y },
+			{ p_pixelTriangle[1].m_x, p_pixelTriangle[1].m_y },
+			{ p_pixelTriangle[2].m_x, p_pixelTriangle[2].m_y }
+		};
+
+		const float textureLod = p_texture == nullptr ? 0.f
+			: computeTextureLod(p_vertices, vs1, vs2, vs1.cross(vs2), *p_texture);
+
+		// Lets the residency manager know which mip levels are in use
+		if (p_texture != nullptr)
+			p_texture->recordSampledLod(textureLod);
 
-		const LibMath::Vector2 deltaTriangleBounds = LibMath::Vector2(	static_cast<float>(maxX - minX) * deltaU,
-																		static_cast<float>(maxY - minY) * deltaV);
+		const size_t samplesPerPixel = p_self.getSamplesPerPixel();
 
-		for (int x = minX; x <= maxX; x++)
+		float sampleDepths[MAX_SAMPLE_COUNT * MAX_SAMPLE_COUNT];
+
+		for (int y = minY; y <= maxY; y++)
 		{
-			for (int y = minY; y <= maxY; y++)
+			for (int x = minX; x <= maxX; x++)
 			{
 				LibMath::Vector2 q(static_cast<float>(x) - p_pixelTriangle[0].m_x,
 					static_cast<float>(y) - p_pixelTriangle[0].m_y);
@@ -389,72 +1410,198 @@ namespace My
 					+ p_pixelTriangle[1] * t
 					+ p_pixelTriangle[2] * w;
 
-				const LibMath::Vector2 pixelPoints[3]
-				{
-					{ p_pixelTriangle[0].m_x, p_pixelTriangle[0].m_y },
-					{ p_pixelTriangle[1].m_x, p_pixelTriangle[1].m_y },
-					{ p_pixelTriangle[2].m_x, p_pixelTriangle[2].m_y }
-				};
-
 				if (!wireFrameCanDrawPixel({ pos.m_x, pos.m_y }, pixelPoints, LibMath::Vector3(s, t, w)))
 					continue;
 
-				const size_t bufferIndex = static_cast<size_t>(y) * p_self.m_target->getWidth() + x;
-
-				if (LibMath::abs(pos.m_z) > 1 || pos.m_z >= p_self.m_zBuffer[bufferIndex])
+				if (LibMath::abs(pos.m_z) > 1)
 					continue;
 
-				Color pixelColor = p_vertices[0].m_color * s
-					+ p_vertices[1].m_color * t
-					+ p_vertices[2].m_color * w;
-
-				// Round up alpha to account for precision loss
-				pixelColor.m_a = pixelColor.m_a >= UINT8_MAX - 2 ? UINT8_MAX : pixelColor.m_a;
+				// Lines cover the whole pixel so only the depth test is done per sample
+				const size_t pixelIndex = static_cast<size_t>(y) * p_self.m_target->getWidth() + x;
+				const float* zBuffer = p_self.m_zBuffer.getData() + pixelIndex * samplesPerPixel;
 
-				if (pixelColor.m_a != UINT8_MAX)
-					pixelColor.blend(p_self.m_target->getPixelColor(x, y));
-				else
-					p_self.m_zBuffer[bufferIndex] = pos.m_z;
+				uint64_t coverageMask = 0;
 
-				if (p_texture != nullptr)
+				for (size_t i = 0; i < samplesPerPixel; i++)
 				{
-					const float u = p_vertices[0].m_u * s + p_vertices[1].m_u * t + p_vertices[2].m_u * w;
-					const float v = p_vertices[0].m_v * s + p_vertices[1].m_v * t + p_vertices[2].m_v * w;
+					sampleDepths[i] = pos.m_z;
 
-					const float textureX = (u - LibMath::floor(u))
-						* static_cast<float>(p_texture->getWidth());
+					if (pos.m_z < zBuffer[i])
+						coverageMask |= 1ull << i;
+				}
 
-					const float textureY = (v - LibMath::floor(v))
-						* static_cast<float>(p_texture->getHeight());
+				if (coverageMask == 0)
+					continue;
 
-					/*pixelColor *= p_texture->getPixelColor(static_cast<uint32_t>(LibMath::round(textureX)),
-						static_cast<uint32_t>(LibMath::round(textureY)));*/
-					pixelColor *= p_texture->getPixelColorBlerp(textureX, textureY, deltaTriangleBounds);
+				if (p_self.m_isHdrFrame)
+				{
+					p_self.writeHdrSamples(pixelIndex, coverageMask,
+						shadeHdrPixel(p_vertices, LibMath::Vector3(s, t, w), p_texture, textureLod, p_self), sampleDepths);
+					continue;
 				}
 
-				if (p_self.m_lights != nullptr && !p_self.m_lights->empty())
-				{
-					const LibMath::Vector3 vertPos = p_vertices[0].m_position * s
-						+ p_vertices[1].m_position * t
-						+ p_vertices[2].m_position * w;
+				const Color pixelColor = shadePixel(p_vertices, LibMath::Vector3(s, t, w), p_texture, textureLod, p_self);
 
-					LibMath::Vector3 normal = p_vertices[0].m_normal * s
-						+ p_vertices[1].m_normal * t
-						+ p_vertices[2].m_normal * w;
+				p_self.writeSamples(pixelIndex, coverageMask, pixelColor, sampleDepths);
+			}
+		}
+	}
 
-					normal.normalize();
+	Color Rasterizer::shadePixel(const Vertex p_vertices[3], const LibMath::Vector3& p_stw,
+		const Texture* p_texture, const float p_textureLod, const Rasterizer& p_self)
+	{
+		const float s = p_stw.m_x;
+		const float t = p_stw.m_y;
+		const float w = p_stw.m_z;
 
-					Color litColor = Color::black;
+		Color pixelColor = p_vertices[0].m_color * s
+			+ p_vertices[1].m_color * t
+			+ p_vertices[2].m_color * w;
 
-					for (const auto& light : *p_self.m_lights)
-						litColor += light.calculateLightingBlinnPhong(vertPos, pixelColor, normal, p_self.m_camera->getPosition());
+		// Round up alpha to account for precision loss
+		pixelColor.m_a = pixelColor.m_a >= UINT8_MAX - 2 ? UINT8_MAX : pixelColor.m_a;
 
-					pixelColor = litColor;
-				}
+		if (p_texture != nullptr)
+		{
+			const float u = p_vertices[0].m_u * s + p_vertices[1].m_u * t + p_vertices[2].m_u * w;
+			const float v = p_vertices[0].m_v * s + p_vertices[1].m_v * t + p_vertices[2].m_v * w;
+
+			pixelColor *= p_texture->sampleTrilinear(u, v, p_textureLod);
+		}
+
+		if (p_self.m_lights != nullptr && !p_self.m_lights->empty())
+		{
+			const LibMath::Vector3 vertPos = p_vertices[0].m_position * s
+				+ p_vertices[1].m_position * t
+				+ p_vertices[2].m_position * w;
+
+			LibMath::Vector3 normal = p_vertices[0].m_normal * s
+				+ p_vertices[1].m_normal * t
+				+ p_vertices[2].m_normal * w;
+
+			normal.normalize();
+
+			Color litColor = Color::black;
+
+			for (const auto& light : *p_self.m_lights)
+				litColor += light.calculateLightingBlinnPhong(vertPos, pixelColor, normal, p_self.m_camera->getPosition());
+
+			// The lights' contributions are summed up so keep the source alpha for blending
+			litColor.m_a = pixelColor.m_a;
+			pixelColor = litColor;
+		}
+
+		return pixelColor;
+	}
+
+	Rasterizer::HdrColor Rasterizer::shadeHdrPixel(const Vertex p_vertices[3], const LibMath::Vector3& p_stw,
+		const Texture* p_texture, const float p_textureLod, const Rasterizer& p_self)
+	{
+		const float s = p_stw.m_x;
+		const float t = p_stw.m_y;
+		const float w = p_stw.m_z;
+
+		__m128 color = _mm_add_ps(_mm_add_ps(_mm_mul_ps(decodeSrgb(p_vertices[0].m_color), _mm_set1_ps(s)),
+			_mm_mul_ps(decodeSrgb(p_vertices[1].m_color), _mm_set1_ps(t))),
+			_mm_mul_ps(decodeSrgb(p_vertices[2].m_color), _mm_set1_ps(w)));
+
+		// Round up alpha to account for precision loss, only comparing the alpha lane
+		const __m128 isAlmostOpaque = _mm_cmpge_ps(color,
+			_mm_setr_ps(INFINITY, INFINITY, INFINITY, static_cast<float>(UINT8_MAX - 2) / 255.f));
+		color = _mm_or_ps(_mm_andnot_ps(isAlmostOpaque, color), _mm_and_ps(isAlmostOpaque, _mm_set1_ps(1.f)));
+
+		if (p_texture != nullptr)
+		{
+			const float u = p_vertices[0].m_u * s + p_vertices[1].m_u * t + p_vertices[2].m_u * w;
+			const float v = p_vertices[0].m_v * s + p_vertices[1].m_v * t + p_vertices[2].m_v * w;
+
+			color = _mm_mul_ps(color, decodeSrgb(p_texture->sampleTrilinear(u, v, p_textureLod)));
+		}
+
+		if (p_self.m_lights != nullptr && !p_self.m_lights->empty())
+		{
+			const LightBatch& lights = p_self.m_lightBatch;
+
+			const LibMath::Vector3 vertPos = p_vertices[0].m_position * s
+				+ p_vertices[1].m_position * t
+				+ p_vertices[2].m_position * w;
+
+			LibMath::Vector3 normal = p_vertices[0].m_normal * s
+				+ p_vertices[1].m_normal * t
+				+ p_vertices[2].m_normal * w;
+
+			normal.normalize();
+
+			const LibMath::Vector3 viewDir = (p_self.m_camera->getPosition() - vertPos).normalized();
+
+			const __m128 positionX = _mm_set1_ps(vertPos.m_x);
+			const __m128 positionY = _mm_set1_ps(vertPos.m_y);
+			const __m128 positionZ = _mm_set1_ps(vertPos.m_z);
+			const __m128 normalX = _mm_set1_ps(normal.m_x);
+			const __m128 normalY = _mm_set1_ps(normal.m_y);
+			const __m128 normalZ = _mm_set1_ps(normal.m_z);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 epsilon = _mm_set1_ps(FLT_MIN);
+
+			// Sum of the factors each channel of the surface color is multiplied by, for each of the four lanes' lights
+			__m128 factors[4] = { zero, zero, zero, zero };
+
+			for (size_t i = 0; i < lights.getLightCount(); i += 4)
+			{
+				__m128 lightDirX = _mm_sub_ps(_mm_loadu_ps(lights.m_positions[0].data() + i), positionX);
+				__m128 lightDirY = _mm_sub_ps(_mm_loadu_ps(lights.m_positions[1].data() + i), positionY);
+				__m128 lightDirZ = _mm_sub_ps(_mm_loadu_ps(lights.m_positions[2].data() + i), positionZ);
+
+				// Same terms as Light::calculateLightingBlinnPhong
+				const __m128 squaredDist = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lightDirX, lightDirX),
+					_mm_mul_ps(lightDirY, lightDirY)), _mm_mul_ps(lightDirZ, lightDirZ)), epsilon);
+				const __m128 invDist = _mm_div_ps(one, _mm_sqrt_ps(squaredDist));
+
+				lightDirX = _mm_mul_ps(lightDirX, invDist);
+				lightDirY = _mm_mul_ps(lightDirY, invDist);
+				lightDirZ = _mm_mul_ps(lightDirZ, invDist);
+
+				const __m128 lambertian = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lightDirX, normalX),
+					_mm_mul_ps(lightDirY, normalY)), _mm_mul_ps(lightDirZ, normalZ)), zero);
+
+				const __m128 halfX = _mm_add_ps(lightDirX, _mm_set1_ps(viewDir.m_x));
+				const __m128 halfY = _mm_add_ps(lightDirY, _mm_set1_ps(viewDir.m_y));
+				const __m128 halfZ = _mm_add_ps(lightDirZ, _mm_set1_ps(viewDir.m_z));
+				const __m128 halfLength = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(halfX, halfX),
+					_mm_mul_ps(halfY, halfY)), _mm_mul_ps(halfZ, halfZ)), epsilon));
 
-				p_self.m_target->setPixelColor(x, y, pixelColor);
+				const __m128 specularAngle = _mm_max_ps(_mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(halfX, normalX),
+					_mm_mul_ps(halfY, normalY)), _mm_mul_ps(halfZ, normalZ)), halfLength), zero);
+
+				// The lights behind the surface have no highlight
+				const __m128 specular = _mm_and_ps(powInt(specularAngle, Light::DEFAULT_SHININESS),
+					_mm_cmpgt_ps(lambertian, zero));
+
+				const __m128 invSquaredDist = _mm_div_ps(one, squaredDist);
+				const __m128 diffuse = _mm_mul_ps(lambertian, invSquaredDist);
+				const __m128 highlight = _mm_mul_ps(specular, invSquaredDist);
+				const __m128 ambient = _mm_loadu_ps(lights.m_ambients.data() + i);
+
+				for (size_t channel = 0; channel < 3; channel++)
+				{
+					factors[channel] = _mm_add_ps(factors[channel], _mm_add_ps(ambient, _mm_add_ps(
+						_mm_mul_ps(diffuse, _mm_loadu_ps(lights.m_diffuseIntensities[channel].data() + i)),
+						_mm_mul_ps(highlight, _mm_loadu_ps(lights.m_specularIntensities[channel].data() + i)))));
+				}
 			}
+
+			// Sum up the lanes into one factor per channel, keeping the source alpha for blending
+			_MM_TRANSPOSE4_PS(factors[0], factors[1], factors[2], factors[3]);
+
+			const __m128 factor = _mm_add_ps(_mm_add_ps(factors[0], factors[1]), _mm_add_ps(factors[2], factors[3]));
+			color = _mm_mul_ps(color, _mm_add_ps(factor, _mm_setr_ps(0.f, 0.f, 0.f, 1.f)));
 		}
+
+		HdrColor pixelColor;
+		_mm_storeu_ps(&pixelColor.m_r, color);
+
+		return pixelColor;
 	}
 
 	void Rasterizer::toggleWireFrameMode()
@@ -476,6 +1623,16 @@ namespace My
 		}
 	}
 
+	Rasterizer::EAntiAliasing Rasterizer::getAntiAliasing() const
+	{
+		return m_antiAliasing;
+	}
+
+	void Rasterizer::setAntiAliasing(const EAntiAliasing p_antiAliasing)
+	{
+		m_antiAliasing = p_antiAliasing;
+	}
+
 	LibMath::Vector3 Rasterizer::worldToPixel(const Vec3& p_pos, const Texture& p_target,
 		const Mat4& p_mvpMatrix)
 	{
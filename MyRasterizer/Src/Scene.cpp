@@ -1,14 +1,40 @@
 #include "Scene.h"
 #include "Mesh.h"
 #include "Entity.h"
+#include "Frustum.h"
 #include "Light.h"
 
-My::Scene::~Scene()
+My::Scene::Scene(const Scene& p_other) :
+	m_meshes(p_other.m_meshes), m_entities(p_other.m_entities), m_lights(p_other.m_lights),
+	m_hierarchy(p_other.m_hierarchy), m_movedEntities(p_other.m_movedEntities),
+	m_hasEntityMoved(p_other.m_hasEntityMoved)
 {
-	m_entities.clear();
+	bindEntities();
+}
+
+My::Scene::Scene(Scene&& p_other) noexcept :
+	m_meshes(std::move(p_other.m_meshes)), m_entities(std::move(p_other.m_entities)),
+	m_lights(std::move(p_other.m_lights)), m_hierarchy(std::move(p_other.m_hierarchy)),
+	m_movedEntities(std::move(p_other.m_movedEntities)), m_hasEntityMoved(std::move(p_other.m_hasEntityMoved))
+{
+	bindEntities();
+}
 
-	for (const auto& pair : m_meshes)
-		delete pair.second;
+My::Scene& My::Scene::operator=(const Scene& p_other)
+{
+	if (&p_other == this)
+		return *this;
+
+	m_entities = p_other.m_entities;
+	m_lights = p_other.m_lights;
+	m_meshes = p_other.m_meshes;
+	m_hierarchy = p_other.m_hierarchy;
+	m_movedEntities = p_other.m_movedEntities;
+	m_hasEntityMoved = p_other.m_hasEntityMoved;
+
+	bindEntities();
+
+	return *this;
 }
 
 My::Scene& My::Scene::operator=(Scene&& p_other) noexcept
@@ -19,18 +45,25 @@ My::Scene& My::Scene::operator=(Scene&& p_other) noexcept
 	m_entities = std::move(p_other.m_entities);
 	m_lights = std::move(p_other.m_lights);
 	m_meshes = std::move(p_other.m_meshes);
+	m_hierarchy = std::move(p_other.m_hierarchy);
+	m_movedEntities = std::move(p_other.m_movedEntities);
+	m_hasEntityMoved = std::move(p_other.m_hasEntityMoved);
+
+	bindEntities();
 
 	return *this;
 }
 
 const My::Mesh* My::Scene::addMesh(const std::string& p_name, Mesh& p_mesh)
 {
-	if (m_meshes.find(p_name) != m_meshes.end())
-		delete m_meshes[p_name];
+	return addMesh(p_name, std::shared_ptr<const Mesh>(&p_mesh));
+}
 
-	m_meshes[p_name] = &p_mesh;
+const My::Mesh* My::Scene::addMesh(const std::string& p_name, std::shared_ptr<const Mesh> p_mesh)
+{
+	m_meshes[p_name] = std::move(p_mesh);
 
-	return m_meshes[p_name];
+	return m_meshes[p_name].get();
 }
 
 const My::Mesh* My::Scene::getMesh(const std::string& p_name)
@@ -38,12 +71,29 @@ const My::Mesh* My::Scene::getMesh(const std::string& p_name)
 	if (m_meshes.find(p_name) == m_meshes.end())
 		return nullptr;
 
-	return m_meshes[p_name];
+	return m_meshes[p_name].get();
+}
+
+const std::map<std::string, std::shared_ptr<const My::Mesh>>& My::Scene::getMeshes() const
+{
+	return m_meshes;
 }
 
 void My::Scene::addEntity(const Entity& p_entity)
 {
+	const Entity* previousEntities = m_entities.data();
+
 	m_entities.push_back(p_entity);
+
+	// The other entities only need to be bound again if they were reallocated
+	if (m_entities.data() != previousEntities)
+	{
+		bindEntities();
+		return;
+	}
+
+	m_entities.back().m_scene = this;
+	m_entities.back().m_sceneIndex = m_entities.size() - 1;
 }
 
 void My::Scene::addLight(const Light& p_light)
@@ -51,12 +101,7 @@ void My::Scene::addLight(const Light& p_light)
 	m_lights.push_back(p_light);
 }
 
-std::vector<My::Entity> My::Scene::getEntities() const
-{
-	return m_entities;
-}
-
-std::vector<My::Entity>& My::Scene::getEntities()
+const std::vector<My::Entity>& My::Scene::getEntities() const
 {
 	return m_entities;
 }
@@ -73,3 +118,71 @@ std::vector<My::Light> My::Scene::getLights() const
 {
 	return m_lights;
 }
+
+void My::Scene::cullEntities(const Frustum& p_frustum, std::vector<size_t>& p_entityIndices) const
+{
+	getBoundingVolumeHierarchy().queryFrustum(p_frustum, p_entityIndices);
+}
+
+My::Entity* My::Scene::pickEntity(const LibMath::Vector3& p_origin, const LibMath::Vector3& p_direction)
+{
+	size_t entityIndex;
+	float distance;
+
+	if (!getBoundingVolumeHierarchy().raycast(p_origin, p_direction, entityIndex, distance))
+		return nullptr;
+
+	return &m_entities[entityIndex];
+}
+
+const My::BoundingVolumeHierarchy& My::Scene::getBoundingVolumeHierarchy() const
+{
+	// Entities added since the last query also end up here
+	if (m_hierarchy.getItemCount() != m_entities.size())
+	{
+		std::vector<AABB> entityBounds;
+		entityBounds.reserve(m_entities.size());
+
+		for (const auto& entity : m_entities)
+			entityBounds.push_back(entity.getBoundingBox());
+
+		m_hierarchy.build(entityBounds);
+		m_movedEntities.clear();
+		m_hasEntityMoved.assign(m_entities.size(), 0);
+
+		return m_hierarchy;
+	}
+
+	if (!m_movedEntities.empty())
+	{
+		for (const size_t index : m_movedEntities)
+		{
+			m_hierarchy.updateItem(index, m_entities[index].getBoundingBox());
+			m_hasEntityMoved[index] = 0;
+		}
+
+		m_movedEntities.clear();
+		m_hierarchy.refit();
+	}
+
+	return m_hierarchy;
+}
+
+void My::Scene::onEntityTransformChanged(const size_t p_index)
+{
+	// Entities which aren't in the hierarchy yet will be added on the next rebuild
+	if (p_index >= m_hasEntityMoved.size() || m_hasEntityMoved[p_index])
+		return;
+
+	m_hasEntityMoved[p_index] = 1;
+	m_movedEntities.push_back(p_index);
+}
+
+void My::Scene::bindEntities()
+{
+	for (size_t i = 0; i < m_entities.size(); i++)
+	{
+		m_entities[i].m_scene = this;
+		m_entities[i].m_sceneIndex = i;
+	}
+}
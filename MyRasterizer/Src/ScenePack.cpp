@@ -0,0 +1,453 @@
+#include "ScenePack.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+#include "Entity.h"
+#include "Mesh.h"
+
+namespace My
+{
+	namespace
+	{
+		constexpr char MAGIC[4] = { 'M', 'Y', 'S', 'P' };
+
+		// Alignment of every table and buffer of the pack
+		constexpr size_t ALIGNMENT = 16;
+
+		// Parent index of the meshes which aren't a level of detail
+		constexpr int32_t NO_PARENT = -1;
+
+		constexpr int32_t NO_TEXTURE = -1;
+
+		struct Header
+		{
+			char		m_magic[4];
+			uint32_t	m_version;
+			uint32_t	m_textureCount;
+			uint32_t	m_meshCount;
+			uint32_t	m_entityCount;
+			uint32_t	m_lightCount;
+			uint64_t	m_textureOffset;
+			uint64_t	m_meshOffset;
+			uint64_t	m_entityOffset;
+			uint64_t	m_lightOffset;
+		};
+
+		struct TextureRecord
+		{
+			uint32_t	m_width;
+			uint32_t	m_height;
+			uint64_t	m_pixelOffset;
+			uint64_t	m_mipOffset;
+			uint64_t	m_mipPixelCount;
+			uint32_t	m_layout;
+			uint32_t	m_compression;	// The pixel offset points to the blocks of every level when compressed
+		};
+
+		struct MeshRecord
+		{
+			uint64_t	m_nameOffset;
+			uint32_t	m_nameLength;
+			int32_t		m_parentIndex;
+			int32_t		m_textureIndex;
+			uint32_t	m_isOccluder;
+			uint64_t	m_vertexCount;
+			uint64_t	m_vertexOffset;
+			uint64_t	m_indexCount;
+			uint64_t	m_indexOffset;
+			uint64_t	m_normalOffset;
+			uint32_t	m_indexType;
+			float		m_boundingBox[6];
+			float		m_boundingSphere[4];
+		};
+
+		struct EntityRecord
+		{
+			uint32_t	m_meshIndex;
+			float		m_transparency;
+			float		m_transform[16];
+		};
+
+		struct LightRecord
+		{
+			float		m_position[3];
+			float		m_components[3];
+			float		m_intensity[3];
+		};
+
+		// The buffers are mapped as they are used by the meshes and the textures
+		static_assert(sizeof(LibMath::Vector3) == 12, "Unexpected vector layout");
+		static_assert(sizeof(Vertex) == 36, "Unexpected vertex layout");
+		static_assert(sizeof(Color) == 4, "Unexpected color layout");
+
+		/**
+		 * \brief Appends the given bytes to the pack, after padding it to the alignment
+		 * \return The offset of the appended bytes
+		 */
+		uint64_t append(std::vector<char>& p_pack, const void* p_data, const size_t p_size)
+		{
+			p_pack.resize((p_pack.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+
+			const uint64_t offset = p_pack.size();
+			p_pack.resize(p_pack.size() + p_size);
+
+			if (p_size != 0)
+				std::memcpy(p_pack.data() + offset, p_data, p_size);
+
+			return offset;
+		}
+
+		template <typename T>
+		uint64_t append(std::vector<char>& p_pack, const std::vector<T>& p_elements)
+		{
+			return append(p_pack, p_elements.data(), p_elements.size() * sizeof(T));
+		}
+
+		/**
+		 * \brief Gives the given elements of the pack, checking that they fit in it
+		 * \return A pointer to the first element
+		 */
+		template <typename T>
+		const T* getElements(const MappedFile& p_file, const uint64_t p_offset, const uint64_t p_count)
+		{
+			const uint64_t size = p_file.getSize();
+
+			if (p_offset % alignof(T) != 0 || p_offset > size || p_count > (size - p_offset) / sizeof(T))
+				throw std::runtime_error("Invalid scene pack: a buffer lies outside of the file");
+
+			return reinterpret_cast<const T*>(p_file.getData() + p_offset);
+		}
+
+		/**
+		 * \brief Creates a texture referring to the pixels or blocks of the given record
+		 */
+		std::unique_ptr<Texture> createTexture(MappedFile& p_file, const TextureRecord& p_record)
+		{
+			if (p_record.m_compression > static_cast<uint32_t>(ETextureCompression::E_BC3))
+				throw std::runtime_error("Invalid scene pack: unknown texture compression " + std::to_string(p_record.m_compression));
+
+			if (p_record.m_compression != static_cast<uint32_t>(ETextureCompression::E_NONE))
+			{
+				const uint8_t* blocks = reinterpret_cast<const uint8_t*>(p_file.getData() + p_record.m_pixelOffset);
+
+				auto texture = std::make_unique<Texture>(p_record.m_width, p_record.m_height,
+					static_cast<ETextureCompression>(p_record.m_compression), blocks);
+
+				getElements<uint8_t>(p_file, p_record.m_pixelOffset, texture->getBlockDataSize());
+				return texture;
+			}
+
+			if (p_record.m_layout > static_cast<uint32_t>(ETextureLayout::E_TILED))
+				throw std::runtime_error("Invalid scene pack: unknown texture layout " + std::to_string(p_record.m_layout));
+
+			// The mapping is copy-on-write so the textures can still be drawn on
+			Color* pixels = reinterpret_cast<Color*>(p_file.getWritableData() + p_record.m_pixelOffset);
+			const Color* mipPixels = p_record.m_mipPixelCount == 0 ? nullptr
+				: getElements<Color>(p_file, p_record.m_mipOffset, p_record.m_mipPixelCount);
+
+			auto texture = std::make_unique<Texture>(p_record.m_width, p_record.m_height, pixels, mipPixels,
+				static_cast<ETextureLayout>(p_record.m_layout));
+
+			getElements<Color>(p_file, p_record.m_pixelOffset, texture->getPixelBufferSize());
+
+			if (texture->getMipPixelCount() != p_record.m_mipPixelCount)
+				throw std::runtime_error("Invalid scene pack: a texture has an incomplete mip chain");
+
+			return texture;
+		}
+
+		/**
+		 * \brief Creates a mesh referring to the buffers of the given record
+		 */
+		Mesh* createMesh(const MappedFile& p_file, const MeshRecord& p_record, const Texture* p_texture)
+		{
+			const size_t triangleCount = p_record.m_indexCount / 3;
+
+			IndexBuffer indices;
+
+			if (p_record.m_indexType == static_cast<uint32_t>(EIndexType::E_UINT16))
+				indices = IndexBuffer(EIndexType::E_UINT16,
+					getElements<uint16_t>(p_file, p_record.m_indexOffset, p_record.m_indexCount), p_record.m_indexCount);
+			else if (p_record.m_indexType == static_cast<uint32_t>(EIndexType::E_UINT32))
+				indices = IndexBuffer(EIndexType::E_UINT32,
+					getElements<uint32_t>(p_file, p_record.m_indexOffset, p_record.m_indexCount), p_record.m_indexCount);
+			else
+				throw std::runtime_error("Invalid scene pack: unknown index type " + std::to_string(p_record.m_indexType));
+
+			const StreamView<Vertex> vertices(getElements<Vertex>(p_file, p_record.m_vertexOffset,
+				p_record.m_vertexCount), p_record.m_vertexCount);
+
+			const StreamView<LibMath::Vector3> normals(getElements<LibMath::Vector3>(p_file, p_record.m_normalOffset,
+				triangleCount), triangleCount);
+
+			const float* box = p_record.m_boundingBox;
+			const float* sphere = p_record.m_boundingSphere;
+
+			AABB boundingBox;
+			boundingBox.m_min = { box[0], box[1], box[2] };
+			boundingBox.m_max = { box[3], box[4], box[5] };
+
+			BoundingSphere boundingSphere;
+			boundingSphere.m_center = { sphere[0], sphere[1], sphere[2] };
+			boundingSphere.m_radius = sphere[3];
+
+			Mesh* mesh = new Mesh(vertices, indices, normals, boundingBox, boundingSphere, p_texture);
+			mesh->setOccluder(p_record.m_isOccluder != 0);
+
+			return mesh;
+		}
+	}
+
+	ScenePack::ScenePack(const std::string& p_path) :
+		m_file(p_path, true)
+	{
+		const Header& header = *getElements<Header>(m_file, 0, 1);
+
+		if (std::memcmp(header.m_magic, MAGIC, sizeof(MAGIC)) != 0)
+			throw std::runtime_error("Invalid scene pack: " + p_path);
+
+		if (header.m_version != VERSION)
+			throw std::runtime_error("Unsupported scene pack version " + std::to_string(header.m_version)
+				+ ". Expected version " + std::to_string(VERSION));
+
+		const TextureRecord* textureRecords = getElements<TextureRecord>(m_file, header.m_textureOffset, header.m_textureCount);
+		const MeshRecord* meshRecords = getElements<MeshRecord>(m_file, header.m_meshOffset, header.m_meshCount);
+		const EntityRecord* entityRecords = getElements<EntityRecord>(m_file, header.m_entityOffset, header.m_entityCount);
+		const LightRecord* lightRecords = getElements<LightRecord>(m_file, header.m_lightOffset, header.m_lightCount);
+
+		m_textures.reserve(header.m_textureCount);
+
+		for (uint32_t i = 0; i < header.m_textureCount; i++)
+			m_textures.push_back(createTexture(m_file, textureRecords[i]));
+
+		std::vector<Mesh*> meshes(header.m_meshCount, nullptr);
+
+		for (uint32_t i = 0; i < header.m_meshCount; i++)
+		{
+			const MeshRecord& record = meshRecords[i];
+
+			if (record.m_textureIndex != NO_TEXTURE
+				&& (record.m_textureIndex < 0 || static_cast<uint32_t>(record.m_textureIndex) >= header.m_textureCount))
+				throw std::runtime_error("Invalid scene pack: mesh " + std::to_string(i) + " uses an unknown texture");
+
+			const Texture* texture = record.m_textureIndex == NO_TEXTURE ? nullptr : m_textures[record.m_textureIndex].get();
+
+			if (record.m_parentIndex == NO_PARENT)
+			{
+				const char* name = getElements<char>(m_file, record.m_nameOffset, record.m_nameLength);
+
+				const std::string meshName(name, record.m_nameLength);
+
+				// Replacing a mesh would delete it while entities may still refer to it
+				if (m_scene.getMesh(meshName) != nullptr)
+					throw std::runtime_error("Invalid scene pack: mesh \"" + meshName + "\" is stored twice");
+
+				meshes[i] = createMesh(m_file, record, texture);
+				m_scene.addMesh(meshName, *meshes[i]);
+				continue;
+			}
+
+			// Levels of detail follow their mesh, which owns a copy of them
+			if (record.m_parentIndex < 0 || static_cast<uint32_t>(record.m_parentIndex) >= i
+				|| meshes[record.m_parentIndex] == nullptr)
+				throw std::runtime_error("Invalid scene pack: level of detail " + std::to_string(i) + " has no mesh");
+
+			const std::unique_ptr<Mesh> lod(createMesh(m_file, record, texture));
+			meshes[record.m_parentIndex]->addLod(*lod);
+		}
+
+		for (uint32_t i = 0; i < header.m_entityCount; i++)
+		{
+			const EntityRecord& record = entityRecords[i];
+
+			if (record.m_meshIndex >= header.m_meshCount || meshes[record.m_meshIndex] == nullptr)
+				throw std::runtime_error("Invalid scene pack: entity " + std::to_string(i) + " uses an unknown mesh");
+
+			LibMath::Matrix4 transform;
+
+			for (size_t j = 0; j < 16; j++)
+				transform[j] = record.m_transform[j];
+
+			m_scene.addEntity(Entity(*meshes[record.m_meshIndex], record.m_transparency, transform));
+		}
+
+		for (uint32_t i = 0; i < header.m_lightCount; i++)
+		{
+			const LightRecord& record = lightRecords[i];
+
+			m_scene.addLight(Light({ record.m_position[0], record.m_position[1], record.m_position[2] },
+				record.m_components[0], record.m_components[1], record.m_components[2],
+				{ record.m_intensity[0], record.m_intensity[1], record.m_intensity[2] }));
+		}
+	}
+
+	Scene& ScenePack::getScene()
+	{
+		return m_scene;
+	}
+
+	const Scene& ScenePack::getScene() const
+	{
+		return m_scene;
+	}
+
+	void ScenePack::save(const std::string& p_path, const Scene& p_scene)
+	{
+		std::vector<TextureRecord> textureRecords;
+		std::vector<MeshRecord> meshRecords;
+		std::vector<EntityRecord> entityRecords;
+		std::vector<LightRecord> lightRecords;
+
+		std::map<const Texture*, int32_t> textureIndices;
+		std::map<const Mesh*, uint32_t> meshIndices;
+
+		// The header is written last, once the offsets are known
+		std::vector<char> pack(sizeof(Header), 0);
+
+		for (const auto& namedMesh : p_scene.getMeshes())
+		{
+			const std::string& name = namedMesh.first;
+			const std::shared_ptr<const Mesh>& mesh = namedMesh.second;
+
+			const int32_t parentIndex = static_cast<int32_t>(meshRecords.size());
+			meshIndices[mesh.get()] = static_cast<uint32_t>(parentIndex);
+
+			for (size_t level = 0; level < mesh->getLodCount(); level++)
+			{
+				const Mesh& lod = mesh->getLod(level);
+				const Texture* texture = lod.getTexture();
+
+				// The records are zeroed with their padding, so that saving a scene twice gives the same pack
+				MeshRecord record;
+				std::memset(&record, 0, sizeof(record));
+				record.m_parentIndex = level == 0 ? NO_PARENT : parentIndex;
+				record.m_textureIndex = NO_TEXTURE;
+				record.m_isOccluder = lod.isOccluder() ? 1 : 0;
+
+				// Levels of detail always use their mesh's texture
+				if (level == 0 && texture != nullptr)
+				{
+					const auto insertion = textureIndices.emplace(texture, static_cast<int32_t>(textureRecords.size()));
+
+					if (insertion.second)
+					{
+						// Their pages are streamed from their own source
+						if (texture->getVirtualTexture() != nullptr)
+							throw std::invalid_argument("Unable to save a view of a virtual texture in a scene pack");
+
+						TextureRecord textureRecord;
+						std::memset(&textureRecord, 0, sizeof(textureRecord));
+						textureRecord.m_width = texture->getWidth();
+						textureRecord.m_height = texture->getHeight();
+						textureRecord.m_layout = static_cast<uint32_t>(texture->getLayout());
+						textureRecord.m_compression = static_cast<uint32_t>(texture->getCompression());
+						textureRecord.m_pixelOffset = texture->getCompression() == ETextureCompression::E_NONE
+							? append(pack, texture->getPixels(), texture->getPixelBufferSize() * sizeof(Color))
+							: append(pack, texture->getBlocks(), texture->getBlockDataSize());
+						textureRecord.m_mipPixelCount = texture->getMipPixelCount();
+						textureRecord.m_mipOffset = append(pack, texture->getMipPixels(),
+							texture->getMipPixelCount() * sizeof(Color));
+
+						textureRecords.push_back(textureRecord);
+					}
+
+					record.m_textureIndex = insertion.first->second;
+				}
+
+				if (level == 0)
+				{
+					record.m_nameOffset = append(pack, name.data(), name.size());
+					record.m_nameLength = static_cast<uint32_t>(name.size());
+				}
+
+				// Compressed and separate vertices are stored interleaved, as the pack's meshes are
+				const std::vector<Vertex> vertices = lod.decodeVertices();
+				record.m_vertexCount = vertices.size();
+				record.m_vertexOffset = append(pack, vertices);
+
+				const IndexBuffer& indices = lod.getIndices();
+				record.m_indexType = static_cast<uint32_t>(indices.getType());
+				record.m_indexCount = indices.size();
+				record.m_indexOffset = indices.visit([&](const auto* p_indices)
+				{
+					return append(pack, p_indices, indices.size() * sizeof(*p_indices));
+				});
+
+				const StreamView<LibMath::Vector3> normals = lod.getNormals();
+				record.m_normalOffset = append(pack, normals.data(), normals.size() * sizeof(LibMath::Vector3));
+
+				const AABB& boundingBox = lod.getBoundingBox();
+				const BoundingSphere& boundingSphere = lod.getBoundingSphere();
+
+				const float box[6] = { boundingBox.m_min.m_x, boundingBox.m_min.m_y, boundingBox.m_min.m_z,
+					boundingBox.m_max.m_x, boundingBox.m_max.m_y, boundingBox.m_max.m_z };
+				const float sphere[4] = { boundingSphere.m_center.m_x, boundingSphere.m_center.m_y,
+					boundingSphere.m_center.m_z, boundingSphere.m_radius };
+
+				std::memcpy(record.m_boundingBox, box, sizeof(box));
+				std::memcpy(record.m_boundingSphere, sphere, sizeof(sphere));
+
+				meshRecords.push_back(record);
+			}
+		}
+
+		for (const Entity& entity : p_scene.getEntities())
+		{
+			const auto it = meshIndices.find(entity.getMesh());
+
+			if (it == meshIndices.end())
+				throw std::invalid_argument("Unable to save an entity whose mesh isn't in the scene");
+
+			EntityRecord record;
+			std::memset(&record, 0, sizeof(record));
+			record.m_meshIndex = it->second;
+			record.m_transparency = entity.getTransparency();
+
+			const LibMath::Matrix4 transform = entity.getTransform();
+
+			for (size_t j = 0; j < 16; j++)
+				record.m_transform[j] = transform[j];
+
+			entityRecords.push_back(record);
+		}
+
+		for (const Light& light : p_scene.getLights())
+		{
+			const LibMath::Vector3& position = light.getPosition();
+			const LibMath::Vector3 components = light.getComponents();
+			const LibMath::Vector3& intensity = light.getIntensity();
+
+			LightRecord record;
+			std::memset(&record, 0, sizeof(record));
+
+			std::memcpy(record.m_position, &position, sizeof(record.m_position));
+			std::memcpy(record.m_components, &components, sizeof(record.m_components));
+			std::memcpy(record.m_intensity, &intensity, sizeof(record.m_intensity));
+
+			lightRecords.push_back(record);
+		}
+
+		Header header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.m_magic, MAGIC, sizeof(MAGIC));
+		header.m_version = VERSION;
+		header.m_textureCount = static_cast<uint32_t>(textureRecords.size());
+		header.m_meshCount = static_cast<uint32_t>(meshRecords.size());
+		header.m_entityCount = static_cast<uint32_t>(entityRecords.size());
+		header.m_lightCount = static_cast<uint32_t>(lightRecords.size());
+		header.m_textureOffset = append(pack, textureRecords);
+		header.m_meshOffset = append(pack, meshRecords);
+		header.m_entityOffset = append(pack, entityRecords);
+		header.m_lightOffset = append(pack, lightRecords);
+
+		std::memcpy(pack.data(), &header, sizeof(header));
+
+		std::ofstream file(p_path, std::ios::binary);
+
+		if (!file.write(pack.data(), static_cast<std::streamsize>(pack.size())))
+			throw std::runtime_error("Unable to write scene pack: " + p_path);
+	}
+}
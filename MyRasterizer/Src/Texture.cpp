@@ -1,11 +1,73 @@
-#include <iostream>
+#include <atomic>
+#include <climits>
+#include <cstring>
 #include <stdexcept>
 #include <string>
-#include "raylib.h"
 #include "Texture.h"
 
 #include "Arithmetic.h"
 #include "Color.h"
+#include "MappedFile.h"
+#include "VirtualTexture.h"
+
+// raylib embeds its own copy of stb_image, so keep this one's symbols private
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace
+{
+	// Bilinear and trilinear weights are in 1/256
+	constexpr uint32_t WEIGHT_ONE = 256;
+
+	My::Color lerpColor(const My::Color& p_a, const My::Color& p_b, const uint32_t p_weight)
+	{
+		const uint32_t weightA = WEIGHT_ONE - p_weight;
+
+		return {
+			static_cast<uint8_t>((p_a.m_r * weightA + p_b.m_r * p_weight + WEIGHT_ONE / 2) / WEIGHT_ONE),
+			static_cast<uint8_t>((p_a.m_g * weightA + p_b.m_g * p_weight + WEIGHT_ONE / 2) / WEIGHT_ONE),
+			static_cast<uint8_t>((p_a.m_b * weightA + p_b.m_b * p_weight + WEIGHT_ONE / 2) / WEIGHT_ONE),
+			static_cast<uint8_t>((p_a.m_a * weightA + p_b.m_a * p_weight + WEIGHT_ONE / 2) / WEIGHT_ONE)
+		};
+	}
+
+	/**
+	 * \brief Averages 2x2 texels into the texel of the next mip level, with rounding
+	 */
+	My::Color averageTexels(const My::Color& p_topLeft, const My::Color& p_topRight, const My::Color& p_bottomLeft,
+		const My::Color& p_bottomRight)
+	{
+		return {
+			static_cast<uint8_t>((p_topLeft.m_r + p_topRight.m_r + p_bottomLeft.m_r + p_bottomRight.m_r + 2) / 4),
+			static_cast<uint8_t>((p_topLeft.m_g + p_topRight.m_g + p_bottomLeft.m_g + p_bottomRight.m_g + 2) / 4),
+			static_cast<uint8_t>((p_topLeft.m_b + p_topRight.m_b + p_bottomLeft.m_b + p_bottomRight.m_b + 2) / 4),
+			static_cast<uint8_t>((p_topLeft.m_a + p_topRight.m_a + p_bottomLeft.m_a + p_bottomRight.m_a + 2) / 4)
+		};
+	}
+
+	uint32_t toWeight(const float p_fraction)
+	{
+		return static_cast<uint32_t>(p_fraction * static_cast<float>(WEIGHT_ONE) + .5f);
+	}
+
+	// Must be a power of 2
+	constexpr size_t BLOCK_CACHE_SIZE = 64;
+
+	struct DecodedBlock
+	{
+		const uint8_t*	m_block = nullptr;
+		uint64_t		m_blockDataId = 0;
+		My::Color		m_texels[My::BlockCompression::BLOCK_TEXEL_COUNT];
+	};
+
+	// Bilinear footprints and neighboring pixels mostly fetch the same few blocks, so each thread keeps
+	// the blocks it decoded last
+	thread_local DecodedBlock g_blockCache[BLOCK_CACHE_SIZE];
+
+	// Distinguishes block buffers reallocated at the address of a destroyed one
+	std::atomic<uint64_t> g_nextBlockDataId { 1 };
+}
 
 My::Texture::Texture(const uint32_t p_width, const uint32_t p_height)
 {
@@ -19,19 +81,27 @@ My::Texture::Texture(const uint32_t p_width, const uint32_t p_height)
 
 	for (size_t i = 0; i < numPixels; i++)
 		m_pixels[i] = Color::black;
+
+	bindMipLevels(nullptr);
 }
 
 My::Texture::Texture(const Texture& p_other)
 {
 	m_width = p_other.m_width;
 	m_height = p_other.m_height;
+	m_layout = p_other.m_layout;
+	m_virtualTexture = p_other.m_virtualTexture;
 
-	const size_t textureSize = static_cast<size_t>(m_width) * m_height;
+	const size_t textureSize = p_other.getPixelBufferSize();
 
 	m_pixels = textureSize == 0 ? nullptr : new Color[textureSize];
 
 	for (size_t i = 0; i < textureSize; i++)
 		m_pixels[i] = p_other.m_pixels[i];
+
+	m_mipChain.assign(p_other.getMipPixels(), p_other.getMipPixels() + p_other.getMipPixelCount());
+	bindMipLevels(m_mipChain.empty() ? nullptr : m_mipChain.data());
+	copyBlocks(p_other);
 }
 
 My::Texture::Texture(Texture&& p_other) noexcept
@@ -39,41 +109,63 @@ My::Texture::Texture(Texture&& p_other) noexcept
 	m_pixels = p_other.m_pixels;
 	m_width = p_other.m_width;
 	m_height = p_other.m_height;
+	m_isOwner = p_other.m_isOwner;
+	m_layout = p_other.m_layout;
+
+	m_compression = p_other.m_compression;
+	m_blocks = p_other.m_blocks;
+	m_blockDataId = p_other.m_blockDataId;
+	m_virtualTexture = p_other.m_virtualTexture;
+
+	// Moving the vectors keeps their buffers so the levels still point to the right pixels
+	m_mipChain = std::move(p_other.m_mipChain);
+	m_blockData = std::move(p_other.m_blockData);
+	m_mipLevels = std::move(p_other.m_mipLevels);
 
 	p_other.m_pixels = nullptr;
 	p_other.m_width = p_other.m_height = 0;
+	p_other.m_compression = ETextureCompression::E_NONE;
+	p_other.m_blocks = nullptr;
+	p_other.m_mipLevels.clear();
+	p_other.m_virtualTexture = nullptr;
 }
 
-My::Texture::Texture(const char* p_imagePath)
+My::Texture::Texture(const char* p_imagePath, const ETextureLayout p_layout) :
+	m_width(0), m_height(0), m_pixels(nullptr), m_layout(p_layout)
 {
-	const Image image = LoadImage(p_imagePath);
-
-	// TODO: Throw image load failed exception
-	if (image.data == nullptr)
-	{
-		std::cout << "Image failed to load";
-		throw;
-	}
-
-	m_width = static_cast<uint32_t>(image.width);
-	m_height = static_cast<uint32_t>(image.height);
+	const MappedFile file(p_imagePath);
 
-	::Color* pixels = LoadImageColors(image);
+	decodeImage(reinterpret_cast<const uint8_t*>(file.getData()), file.getSize(), p_imagePath, 0);
+}
 
-	const size_t textureSize = static_cast<size_t>(m_width) * m_height;
+My::Texture::Texture(const uint32_t p_width, const uint32_t p_height, Color* p_pixels, const Color* p_mipPixels,
+	const ETextureLayout p_layout) :
+	m_width(p_width), m_height(p_height), m_pixels(p_pixels), m_isOwner(false), m_layout(p_layout)
+{
+	bindMipLevels(p_mipPixels);
+}
 
-	m_pixels = textureSize == 0 ? nullptr : new Color[textureSize];
+My::Texture::Texture(const uint32_t p_width, const uint32_t p_height, const ETextureCompression p_compression,
+	const uint8_t* p_blocks) :
+	m_width(p_width), m_height(p_height), m_pixels(nullptr), m_isOwner(false), m_compression(p_compression)
+{
+	if (p_compression == ETextureCompression::E_NONE)
+		throw std::invalid_argument("Compressed textures need a block format");
 
-	for (size_t i = 0; i < textureSize; i++)
-		m_pixels[i] = { pixels[i].r, pixels[i].g, pixels[i].b, pixels[i].a };
+	bindBlockLevels(p_blocks);
+}
 
-	UnloadImageColors(pixels);
-	UnloadImage(image);
+My::Texture::Texture(const VirtualTexture& p_virtualTexture) :
+	m_width(p_virtualTexture.getWidth()), m_height(p_virtualTexture.getHeight()), m_pixels(nullptr), m_isOwner(false),
+	m_virtualTexture(&p_virtualTexture)
+{
+	bindMipLevels(nullptr);
 }
 
 My::Texture::~Texture()
 {
-	delete[] m_pixels;
+	if (m_isOwner)
+		delete[] m_pixels;
 }
 
 My::Texture& My::Texture::operator=(const Texture& p_other)
@@ -81,18 +173,26 @@ My::Texture& My::Texture::operator=(const Texture& p_other)
 	if (this == &p_other)
 		return *this;
 
-	delete[] m_pixels;
+	if (m_isOwner)
+		delete[] m_pixels;
 
 	m_width = p_other.m_width;
 	m_height = p_other.m_height;
+	m_isOwner = true;
+	m_layout = p_other.m_layout;
+	m_virtualTexture = p_other.m_virtualTexture;
 
-	const size_t textureSize = static_cast<size_t>(m_width) * m_height;
+	const size_t textureSize = p_other.getPixelBufferSize();
 
 	m_pixels = textureSize == 0 ? nullptr : new Color[textureSize];
 
 	for (size_t i = 0; i < textureSize; i++)
 		m_pixels[i] = p_other.m_pixels[i];
 
+	m_mipChain.assign(p_other.getMipPixels(), p_other.getMipPixels() + p_other.getMipPixelCount());
+	bindMipLevels(m_mipChain.empty() ? nullptr : m_mipChain.data());
+	copyBlocks(p_other);
+
 	return *this;
 }
 
@@ -101,18 +201,42 @@ My::Texture& My::Texture::operator=(Texture&& p_other) noexcept
 	if (this == &p_other)
 		return *this;
 
-	delete[] m_pixels;
+	if (m_isOwner)
+		delete[] m_pixels;
 
 	m_pixels = p_other.m_pixels;
 	m_width = p_other.m_width;
 	m_height = p_other.m_height;
+	m_isOwner = p_other.m_isOwner;
+	m_layout = p_other.m_layout;
+	m_compression = p_other.m_compression;
+	m_blocks = p_other.m_blocks;
+	m_blockDataId = p_other.m_blockDataId;
+	m_virtualTexture = p_other.m_virtualTexture;
+	m_mipChain = std::move(p_other.m_mipChain);
+	m_blockData = std::move(p_other.m_blockData);
+	m_mipLevels = std::move(p_other.m_mipLevels);
 
 	p_other.m_pixels = nullptr;
 	p_other.m_width = p_other.m_height = 0;
+	p_other.m_compression = ETextureCompression::E_NONE;
+	p_other.m_blocks = nullptr;
+	p_other.m_mipLevels.clear();
+	p_other.m_virtualTexture = nullptr;
 
 	return *this;
 }
 
+My::Texture My::Texture::decode(const void* p_data, const size_t p_size, const ETextureLayout p_layout,
+	const size_t p_firstLevel)
+{
+	Texture texture(0, 0);
+	texture.m_layout = p_layout;
+	texture.decodeImage(static_cast<const uint8_t*>(p_data), p_size, "memory", p_firstLevel);
+
+	return texture;
+}
+
 uint32_t My::Texture::getWidth() const
 {
 	return m_width;
@@ -125,48 +249,615 @@ uint32_t My::Texture::getHeight() const
 
 My::Color My::Texture::getPixelColor(const uint32_t p_x, const uint32_t p_y) const
 {
-	return m_pixels[p_y * m_width + p_x];
+	// Only the pages the sampling requested are resident, so views are only sampled
+	if (m_virtualTexture != nullptr)
+		throw std::logic_error("Virtual texture views have no pixels");
+
+	return getTexel(m_mipLevels[0], p_x, p_y);
+}
+
+void My::Texture::setPixelColor(const uint32_t p_x, const uint32_t p_y, const Color& p_c)
+{
+	if (m_virtualTexture != nullptr)
+		throw std::logic_error("Virtual texture views have no pixels");
+
+	if (m_compression != ETextureCompression::E_NONE)
+		throw std::logic_error("Compressed textures are read-only");
+
+	if (p_x < 0 || p_x >= m_width || p_y < 0 || p_y >= m_height)
+		throw std::out_of_range("Pixel at coordinates " + std::to_string(p_x) +
+			", " + std::to_string(p_y) + " is not in the texture");
+
+	m_pixels[getPixelIndex(m_layout, m_width, p_x, p_y)] = p_c;
+}
+
+My::ETextureLayout My::Texture::getLayout() const
+{
+	return m_layout;
 }
 
-My::Color My::Texture::getPixelColorBlerp(const float p_x, const float p_y,
-                                          const LibMath::Vector2 p_deltaRatio) const
+void My::Texture::setLayout(const ETextureLayout p_layout)
 {
-	if (LibMath::floatEquals(p_deltaRatio.m_x, 0)
-		|| LibMath::floatEquals(p_deltaRatio.m_y, 0)) // TODO : texture blerp delta (0,0) deal with them with lerp
-		return m_pixels[static_cast<size_t>(LibMath::round(p_y) * static_cast<float>(m_width) + LibMath::round(p_x))];
+	if (m_virtualTexture != nullptr)
+		throw std::logic_error("Virtual texture views have no pixels");
 
-	const LibMath::Vector2 deltaRatio = LibMath::Vector2(	static_cast<float>(m_width),
-	                                                        static_cast<float>(m_height)) / p_deltaRatio;
+	if (p_layout == m_layout)
+		return;
 
-	LibMath::Vector2 min(LibMath::round(p_x - deltaRatio.m_x / 2),	LibMath::round(p_y - deltaRatio.m_y / 2));
-	LibMath::Vector2 max(LibMath::round(p_x + deltaRatio.m_x / 2),	LibMath::round(p_y + deltaRatio.m_y / 2));
+	if (m_compression != ETextureCompression::E_NONE)
+		throw std::logic_error("Compressed textures are stored in blocks");
 
-	const float floatWidth = static_cast<float>(m_width);
-	const float floatHeight = static_cast<float>(m_height);
+	const size_t bufferSize = getBufferSize(m_width, m_height, p_layout);
 
-	min.m_x = min.m_x < 0 ? 0 : min.m_x;
-	min.m_y = min.m_y < 0 ? 0 : min.m_y;
-	max.m_x = max.m_x >= floatWidth ? floatWidth - 1.0f : max.m_x;
-	max.m_y = max.m_y >= floatHeight ? floatHeight - 1.0f : max.m_y;
+	Color* pixels = bufferSize == 0 ? nullptr : new Color[bufferSize]();
 
-	const Color* colorsAround[4]
+	for (uint32_t y = 0; y < m_height; y++)
 	{
-		&m_pixels[static_cast<size_t>(min.m_y * floatWidth + min.m_x)],	//top left
-		&m_pixels[static_cast<size_t>(min.m_y * floatWidth + max.m_x)],	//top right
-		&m_pixels[static_cast<size_t>(max.m_y * floatWidth + min.m_x)],	//bot left
-		&m_pixels[static_cast<size_t>(max.m_y * floatWidth + max.m_x)]	//bot right
-	};
+		for (uint32_t x = 0; x < m_width; x++)
+		{
+			pixels[getPixelIndex(p_layout, m_width, x, y)] = m_pixels[getPixelIndex(m_layout, m_width, x, y)];
+		}
+	}
+
+	if (m_isOwner)
+		delete[] m_pixels;
 
-	return Color::bLerp(colorsAround, LibMath::Vector2(p_x, p_y), min, max);
+	m_pixels = pixels;
+	m_isOwner = true;
+	m_layout = p_layout;
+
+	if (m_mipLevels.size() > 1)
+		generateMipmaps();
+	else
+		bindMipLevels(nullptr);
 }
 
-void My::Texture::setPixelColor(const uint32_t p_x, const uint32_t p_y, const Color& p_c)
+size_t My::Texture::getPixelBufferSize() const
 {
-	if (p_x < 0 || p_x >= m_width || p_y < 0 || p_y >= m_height)
-		throw std::out_of_range("Pixel at coordinates " + std::to_string(p_x) +
-			", " + std::to_string(p_y) + " is not in the texture");
+	if (m_compression != ETextureCompression::E_NONE || m_virtualTexture != nullptr)
+		return 0;
+
+	return getBufferSize(m_width, m_height, m_layout);
+}
+
+My::ETextureCompression My::Texture::getCompression() const
+{
+	return m_compression;
+}
+
+void My::Texture::compress(const ETextureCompression p_compression)
+{
+	if (m_virtualTexture != nullptr)
+		throw std::logic_error("Virtual texture views have no pixels");
+
+	if (p_compression == m_compression)
+		return;
+
+	if (m_compression != ETextureCompression::E_NONE || p_compression == ETextureCompression::E_NONE)
+		throw std::logic_error("Compressed textures can't be converted");
+
+	// Compressed textures are sampled, so they always get their mip chain
+	if (m_mipLevels.size() == 1)
+		generateMipmaps();
+
+	const size_t blockByteCount = BlockCompression::getBlockByteCount(p_compression);
+
+	std::vector<uint8_t> blockData(getBlockChainSize(m_width, m_height, p_compression));
+	uint8_t* destination = blockData.data();
+
+	Color texels[BlockCompression::BLOCK_TEXEL_COUNT];
+
+	for (const MipLevel& level : m_mipLevels)
+	{
+		for (uint32_t blockY = 0; blockY < level.m_height; blockY += BlockCompression::BLOCK_SIZE)
+		{
+			for (uint32_t blockX = 0; blockX < level.m_width; blockX += BlockCompression::BLOCK_SIZE)
+			{
+				// Blocks crossing the level's edges repeat its last row or column
+				for (uint32_t i = 0; i < BlockCompression::BLOCK_TEXEL_COUNT; i++)
+				{
+					const uint32_t x = LibMath::min(blockX + i % BlockCompression::BLOCK_SIZE, level.m_width - 1);
+					const uint32_t y = LibMath::min(blockY + i / BlockCompression::BLOCK_SIZE, level.m_height - 1);
+					texels[i] = getTexel(level, x, y);
+				}
+
+				if (p_compression == ETextureCompression::E_BC1)
+				{
+					const BC1Block block = BlockCompression::encodeBC1(texels);
+					std::memcpy(destination, &block, sizeof(block));
+				}
+				else
+				{
+					const BC3Block block = BlockCompression::encodeBC3(texels);
+					std::memcpy(destination, &block, sizeof(block));
+				}
+
+				destination += blockByteCount;
+			}
+		}
+	}
+
+	if (m_isOwner)
+		delete[] m_pixels;
+
+	m_pixels = nullptr;
+	m_isOwner = true;
+	std::vector<Color>().swap(m_mipChain);
+
+	m_compression = p_compression;
+	m_blockData = std::move(blockData);
+	bindBlockLevels(m_blockData.data());
+}
+
+const uint8_t* My::Texture::getBlocks() const
+{
+	return m_blocks;
+}
+
+size_t My::Texture::getBlockDataSize() const
+{
+	return m_compression == ETextureCompression::E_NONE ? 0 : getBlockChainSize(m_width, m_height, m_compression);
+}
+
+My::Color* My::Texture::getPixels()
+{
+	return m_pixels;
+}
+
+const My::Color* My::Texture::getPixels() const
+{
+	return m_pixels;
+}
+
+My::Color My::Texture::sampleTrilinear(const float p_u, const float p_v, const float p_lod) const
+{
+	if (m_virtualTexture != nullptr)
+		return m_virtualTexture->sampleTrilinear(p_u, p_v, p_lod);
+
+	const size_t lastLevel = m_mipLevels.size() - 1;
+
+	// Magnified textures and textures without mip chain only use their first level
+	if (!(p_lod > 0.f) || lastLevel == 0)
+		return sampleBilinear(m_mipLevels[0], p_u, p_v);
+
+	if (p_lod >= static_cast<float>(lastLevel))
+		return sampleBilinear(m_mipLevels[lastLevel], p_u, p_v);
+
+	const size_t level = static_cast<size_t>(p_lod);
+	const uint32_t weight = toWeight(p_lod - static_cast<float>(level));
+
+	if (weight == 0)
+		return sampleBilinear(m_mipLevels[level], p_u, p_v);
+
+	if (weight == WEIGHT_ONE)
+		return sampleBilinear(m_mipLevels[level + 1], p_u, p_v);
+
+	return lerpColor(sampleBilinear(m_mipLevels[level], p_u, p_v),
+		sampleBilinear(m_mipLevels[level + 1], p_u, p_v), weight);
+}
+
+void My::Texture::generateMipmaps()
+{
+	if (m_virtualTexture != nullptr)
+		throw std::logic_error("Virtual texture views have no pixels");
+
+	if (m_compression != ETextureCompression::E_NONE)
+		throw std::logic_error("Compressed textures are read-only");
+
+	size_t chainSize = 0;
+
+	for (uint32_t width = m_width, height = m_height; width > 1 || height > 1;)
+	{
+		width = LibMath::max(width / 2, 1u);
+		height = LibMath::max(height / 2, 1u);
+		chainSize += getBufferSize(width, height, m_layout);
+	}
+
+	m_mipChain.assign(chainSize, Color::black);
+	bindMipLevels(m_mipChain.empty() || m_pixels == nullptr ? nullptr : m_mipChain.data());
+
+	Color* destination = m_mipChain.data();
+
+	for (size_t i = 1; i < m_mipLevels.size(); i++)
+	{
+		const MipLevel& source = m_mipLevels[i - 1];
+		const MipLevel& level = m_mipLevels[i];
+
+		for (uint32_t y = 0; y < level.m_height; y++)
+		{
+			// Odd sizes repeat their last row or column
+			const uint32_t y0 = y * 2;
+			const uint32_t y1 = LibMath::min(y0 + 1, source.m_height - 1);
+
+			for (uint32_t x = 0; x < level.m_width; x++)
+			{
+				const uint32_t x0 = x * 2;
+				const uint32_t x1 = LibMath::min(x0 + 1, source.m_width - 1);
+
+				const Color& topLeft = source.m_pixels[getPixelIndex(m_layout, source.m_width, x0, y0)];
+				const Color& topRight = source.m_pixels[getPixelIndex(m_layout, source.m_width, x1, y0)];
+				const Color& bottomLeft = source.m_pixels[getPixelIndex(m_layout, source.m_width, x0, y1)];
+				const Color& bottomRight = source.m_pixels[getPixelIndex(m_layout, source.m_width, x1, y1)];
+
+				destination[getPixelIndex(m_layout, level.m_width, x, y)] =
+					averageTexels(topLeft, topRight, bottomLeft, bottomRight);
+			}
+		}
+
+		destination += getBufferSize(level.m_width, level.m_height, m_layout);
+	}
+}
+
+void My::Texture::dropMipLevels(const size_t p_levelCount)
+{
+	if (p_levelCount == 0)
+		return;
+
+	if (p_levelCount >= m_mipLevels.size())
+		throw std::out_of_range("A texture keeps at least its smallest mip level");
+
+	const MipLevel base = m_mipLevels[p_levelCount];
+
+	if (m_compression != ETextureCompression::E_NONE)
+	{
+		std::vector<uint8_t> blockData(base.m_blocks, m_blocks + getBlockDataSize());
+
+		m_width = base.m_width;
+		m_height = base.m_height;
+		m_blockData = std::move(blockData);
+		bindBlockLevels(m_blockData.data());
+		return;
+	}
+
+	// The new first level gets its own buffer, the smaller ones stay in the chain
+	const size_t bufferSize = getBufferSize(base.m_width, base.m_height, m_layout);
+	Color* pixels = new Color[bufferSize];
+	std::memcpy(pixels, base.m_pixels, bufferSize * sizeof(Color));
+
+	std::vector<Color> mipChain(base.m_pixels + bufferSize, getMipPixels() + getMipPixelCount());
+
+	if (m_isOwner)
+		delete[] m_pixels;
+
+	m_pixels = pixels;
+	m_isOwner = true;
+	m_width = base.m_width;
+	m_height = base.m_height;
+	m_mipChain = std::move(mipChain);
+	bindMipLevels(m_mipChain.empty() ? nullptr : m_mipChain.data());
+}
+
+void My::Texture::recordSampledLod(const float p_lod) const
+{
+	const int32_t level = static_cast<int32_t>(LibMath::floor(LibMath::max(p_lod, -32.f)));
+	int32_t finestLevel = m_finestSampledLevel.load(std::memory_order_relaxed);
+
+	// Most triangles don't refine the level, so they only read it
+	while (level < finestLevel
+		&& !m_finestSampledLevel.compare_exchange_weak(finestLevel, level, std::memory_order_relaxed))
+	{
+	}
+}
+
+bool My::Texture::takeSampledLevel(int32_t& p_level)
+{
+	p_level = m_finestSampledLevel.exchange(NOT_SAMPLED, std::memory_order_relaxed);
+
+	return p_level != NOT_SAMPLED;
+}
+
+const My::VirtualTexture* My::Texture::getVirtualTexture() const
+{
+	return m_virtualTexture;
+}
+
+My::Color My::Texture::filterBilinear(const Color p_texels[4], const float p_fractionX, const float p_fractionY)
+{
+	const uint32_t weightX = toWeight(p_fractionX);
+
+	return lerpColor(lerpColor(p_texels[0], p_texels[1], weightX), lerpColor(p_texels[2], p_texels[3], weightX),
+		toWeight(p_fractionY));
+}
+
+My::Color My::Texture::filterLinear(const Color& p_a, const Color& p_b, const float p_fraction)
+{
+	return lerpColor(p_a, p_b, toWeight(p_fraction));
+}
+
+size_t My::Texture::getMemorySize() const
+{
+	return (getPixelBufferSize() + getMipPixelCount()) * sizeof(Color) + getBlockDataSize();
+}
+
+size_t My::Texture::getMipLevelCount() const
+{
+	return m_mipLevels.size();
+}
+
+const My::Color* My::Texture::getMipPixels() const
+{
+	return m_mipLevels.size() > 1 ? m_mipLevels[1].m_pixels : nullptr;
+}
+
+size_t My::Texture::getMipPixelCount() const
+{
+	if (m_compression != ETextureCompression::E_NONE)
+		return 0;
+
+	size_t count = 0;
+
+	for (size_t i = 1; i < m_mipLevels.size(); i++)
+		count += getBufferSize(m_mipLevels[i].m_width, m_mipLevels[i].m_height, m_layout);
+
+	return count;
+}
+
+void My::Texture::bindMipLevels(const Color* p_mipPixels)
+{
+	m_mipLevels.clear();
+	m_mipLevels.push_back({ m_width, m_height, m_pixels, nullptr });
+
+	if (p_mipPixels == nullptr || m_width == 0 || m_height == 0)
+		return;
+
+	for (uint32_t width = m_width, height = m_height; width > 1 || height > 1;)
+	{
+		width = LibMath::max(width / 2, 1u);
+		height = LibMath::max(height / 2, 1u);
+
+		m_mipLevels.push_back({ width, height, p_mipPixels, nullptr });
+		p_mipPixels += getBufferSize(width, height, m_layout);
+	}
+}
+
+void My::Texture::decodeImage(const uint8_t* p_data, const size_t p_size, const std::string& p_source,
+	const size_t p_firstLevel)
+{
+	if (p_size > INT_MAX)
+		throw std::runtime_error("Image is too large to decode: " + p_source);
+
+	int width;
+	int height;
+	int channelCount;
+
+	// Decoded to RGBA8, which is laid out like Color
+	uint8_t* rgba = stbi_load_from_memory(p_data, static_cast<int>(p_size), &width, &height, &channelCount, 4);
+
+	if (rgba == nullptr)
+		throw std::runtime_error("Unable to decode image " + p_source + ": " + stbi_failure_reason());
+
+	m_width = static_cast<uint32_t>(width);
+	m_height = static_cast<uint32_t>(height);
+
+	// The skipped levels are reduced in place with the mip chain's filter, so the kept levels are the same
+	// as when the whole chain is built and only they are ever allocated
+	for (size_t level = 0; level < p_firstLevel; level++)
+	{
+		if (m_width <= 1 && m_height <= 1)
+		{
+			stbi_image_free(rgba);
+			throw std::out_of_range("A texture keeps at least its smallest mip level");
+		}
+
+		Color* pixels = reinterpret_cast<Color*>(rgba);
+		const uint32_t width = LibMath::max(m_width / 2, 1u);
+		const uint32_t height = LibMath::max(m_height / 2, 1u);
+
+		// Each texel is written before or at the first texel it is averaged from
+		for (uint32_t y = 0; y < height; y++)
+		{
+			const uint32_t y0 = y * 2;
+			const uint32_t y1 = LibMath::min(y0 + 1, m_height - 1);
+
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const uint32_t x0 = x * 2;
+				const uint32_t x1 = LibMath::min(x0 + 1, m_width - 1);
+
+				pixels[static_cast<size_t>(y) * width + x] = averageTexels(
+					pixels[static_cast<size_t>(y0) * m_width + x0], pixels[static_cast<size_t>(y0) * m_width + x1],
+					pixels[static_cast<size_t>(y1) * m_width + x0], pixels[static_cast<size_t>(y1) * m_width + x1]);
+			}
+		}
+
+		m_width = width;
+		m_height = height;
+	}
+
+	const size_t textureSize = getPixelBufferSize();
+
+	m_pixels = textureSize == 0 ? nullptr : new Color[textureSize]();
+
+	if (m_layout == ETextureLayout::E_LINEAR)
+	{
+		std::memcpy(m_pixels, rgba, static_cast<size_t>(m_width) * m_height * sizeof(Color));
+	}
+	else
+	{
+		const Color* pixels = reinterpret_cast<const Color*>(rgba);
+
+		for (uint32_t y = 0; y < m_height; y++)
+		{
+			for (uint32_t x = 0; x < m_width; x++)
+				m_pixels[getPixelIndex(m_layout, m_width, x, y)] = pixels[static_cast<size_t>(y) * m_width + x];
+		}
+	}
+
+	stbi_image_free(rgba);
+
+	generateMipmaps();
+}
+
+void My::Texture::bindBlockLevels(const uint8_t* p_blocks)
+{
+	m_blocks = p_blocks;
+	m_blockDataId = g_nextBlockDataId++;
+	m_mipLevels.clear();
+
+	for (uint32_t width = m_width, height = m_height;;)
+	{
+		m_mipLevels.push_back({ width, height, nullptr, p_blocks });
+
+		if (width <= 1 && height <= 1)
+			return;
+
+		p_blocks += getLevelBlockSize(width, height, m_compression);
+		width = LibMath::max(width / 2, 1u);
+		height = LibMath::max(height / 2, 1u);
+	}
+}
+
+void My::Texture::copyBlocks(const Texture& p_other)
+{
+	m_compression = p_other.m_compression;
+
+	if (m_compression == ETextureCompression::E_NONE)
+	{
+		std::vector<uint8_t>().swap(m_blockData);
+		m_blocks = nullptr;
+		return;
+	}
+
+	m_blockData.assign(p_other.m_blocks, p_other.m_blocks + p_other.getBlockDataSize());
+	bindBlockLevels(m_blockData.data());
+}
+
+size_t My::Texture::getLevelBlockSize(const uint32_t p_width, const uint32_t p_height,
+	const ETextureCompression p_compression)
+{
+	const size_t blockCountX = (static_cast<size_t>(p_width) + BlockCompression::BLOCK_SIZE - 1) / BlockCompression::BLOCK_SIZE;
+	const size_t blockCountY = (static_cast<size_t>(p_height) + BlockCompression::BLOCK_SIZE - 1) / BlockCompression::BLOCK_SIZE;
+
+	return blockCountX * blockCountY * BlockCompression::getBlockByteCount(p_compression);
+}
+
+size_t My::Texture::getBlockChainSize(const uint32_t p_width, const uint32_t p_height,
+	const ETextureCompression p_compression)
+{
+	size_t size = getLevelBlockSize(p_width, p_height, p_compression);
+
+	for (uint32_t width = p_width, height = p_height; width > 1 || height > 1;)
+	{
+		width = LibMath::max(width / 2, 1u);
+		height = LibMath::max(height / 2, 1u);
+		size += getLevelBlockSize(width, height, p_compression);
+	}
+
+	return size;
+}
+
+size_t My::Texture::getBufferSize(const uint32_t p_width, const uint32_t p_height, const ETextureLayout p_layout)
+{
+	if (p_layout == ETextureLayout::E_LINEAR)
+		return static_cast<size_t>(p_width) * p_height;
+
+	// Tiles are padded up to a whole number on both axes
+	const size_t paddedWidth = (static_cast<size_t>(p_width) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+	const size_t paddedHeight = (static_cast<size_t>(p_height) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+
+	return paddedWidth * paddedHeight;
+}
+
+size_t My::Texture::getPixelIndex(const ETextureLayout p_layout, const uint32_t p_levelWidth, const uint32_t p_x,
+	const uint32_t p_y)
+{
+	if (p_layout == ETextureLayout::E_LINEAR)
+		return static_cast<size_t>(p_y) * p_levelWidth + p_x;
+
+	// A row of tiles holds TILE_SIZE rows of the padded level
+	const size_t tileRowSize = static_cast<size_t>(p_levelWidth + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE * TILE_SIZE;
+
+	return (p_y / TILE_SIZE) * tileRowSize + (p_x / TILE_SIZE) * TILE_SIZE * TILE_SIZE
+		+ (p_y % TILE_SIZE) * TILE_SIZE + p_x % TILE_SIZE;
+}
+
+My::Color My::Texture::sampleBilinear(const MipLevel& p_level, const float p_u, const float p_v) const
+{
+	const int width = static_cast<int>(p_level.m_width);
+	const int height = static_cast<int>(p_level.m_height);
+
+	// Texel centers are at half coordinates
+	const float x = (p_u - LibMath::floor(p_u)) * static_cast<float>(width) - .5f;
+	const float y = (p_v - LibMath::floor(p_v)) * static_cast<float>(height) - .5f;
+	const float floorX = LibMath::floor(x);
+	const float floorY = LibMath::floor(y);
+
+	// The texture repeats but its edge texels aren't blended with the opposite edge
+	const uint32_t x0 = static_cast<uint32_t>(LibMath::max(static_cast<int>(floorX), 0));
+	const uint32_t y0 = static_cast<uint32_t>(LibMath::max(static_cast<int>(floorY), 0));
+	const uint32_t x1 = static_cast<uint32_t>(LibMath::min(static_cast<int>(floorX) + 1, width - 1));
+	const uint32_t y1 = static_cast<uint32_t>(LibMath::min(static_cast<int>(floorY) + 1, height - 1));
+
+	const uint32_t weightX = toWeight(x - floorX);
+
+	constexpr uint32_t blockSize = BlockCompression::BLOCK_SIZE;
+
+	// Most footprints fit in a single block, which is then looked up once
+	if (m_compression != ETextureCompression::E_NONE && x0 / blockSize == x1 / blockSize && y0 / blockSize == y1 / blockSize)
+	{
+		const Color* texels = decodeBlock(getBlock(p_level, x0, y0));
+		const Color* row0 = texels + (y0 % blockSize) * blockSize;
+		const Color* row1 = texels + (y1 % blockSize) * blockSize;
+
+		return lerpColor(lerpColor(row0[x0 % blockSize], row0[x1 % blockSize], weightX),
+			lerpColor(row1[x0 % blockSize], row1[x1 % blockSize], weightX), toWeight(y - floorY));
+	}
+
+	const Color topLeft = getTexel(p_level, x0, y0);
+	const Color topRight = getTexel(p_level, x1, y0);
+	const Color bottomLeft = getTexel(p_level, x0, y1);
+	const Color bottomRight = getTexel(p_level, x1, y1);
+
+	return lerpColor(lerpColor(topLeft, topRight, weightX), lerpColor(bottomLeft, bottomRight, weightX),
+		toWeight(y - floorY));
+}
+
+My::Color My::Texture::getTexel(const MipLevel& p_level, const uint32_t p_x, const uint32_t p_y) const
+{
+	if (m_compression == ETextureCompression::E_NONE)
+		return p_level.m_pixels[getPixelIndex(m_layout, p_level.m_width, p_x, p_y)];
+
+	const Color* texels = decodeBlock(getBlock(p_level, p_x, p_y));
+
+	return texels[(p_y % BlockCompression::BLOCK_SIZE) * BlockCompression::BLOCK_SIZE + p_x % BlockCompression::BLOCK_SIZE];
+}
+
+const uint8_t* My::Texture::getBlock(const MipLevel& p_level, const uint32_t p_x, const uint32_t p_y) const
+{
+	const uint32_t blockCountX = (p_level.m_width + BlockCompression::BLOCK_SIZE - 1) / BlockCompression::BLOCK_SIZE;
+	const size_t blockIndex = static_cast<size_t>(p_y / BlockCompression::BLOCK_SIZE) * blockCountX
+		+ p_x / BlockCompression::BLOCK_SIZE;
+
+	// Avoids the format lookup of BlockCompression::getBlockByteCount in the sampler
+	const size_t blockByteCount = m_compression == ETextureCompression::E_BC1 ? sizeof(BC1Block) : sizeof(BC3Block);
+
+	return p_level.m_blocks + blockIndex * blockByteCount;
+}
+
+const My::Color* My::Texture::decodeBlock(const uint8_t* p_block) const
+{
+	// Fibonacci hashing spreads the rows of blocks over the whole cache
+	const uint64_t address = reinterpret_cast<uintptr_t>(p_block) / sizeof(BC1Block);
+	DecodedBlock& entry = g_blockCache[address * 0x9E3779B97F4A7C15ull >> 58 & (BLOCK_CACHE_SIZE - 1)];
+
+	if (entry.m_block == p_block && entry.m_blockDataId == m_blockDataId)
+		return entry.m_texels;
+
+	if (m_compression == ETextureCompression::E_BC1)
+	{
+		BC1Block block;
+		std::memcpy(&block, p_block, sizeof(block));
+		BlockCompression::decodeBC1(block, entry.m_texels);
+	}
+	else
+	{
+		BC3Block block;
+		std::memcpy(&block, p_block, sizeof(block));
+		BlockCompression::decodeBC3(block, entry.m_texels);
+	}
 
-	const size_t index = p_x + p_y * this->m_width;
+	entry.m_block = p_block;
+	entry.m_blockDataId = m_blockDataId;
 
-	m_pixels[index] = p_c;
+	return entry.m_texels;
 }
@@ -0,0 +1,110 @@
+#include "TextureLoader.h"
+
+#include <exception>
+#include <utility>
+
+#include "Color.h"
+#include "MappedFile.h"
+
+namespace My
+{
+	TextureHandle::State::State() : m_texture(1, 1)
+	{
+		m_texture.setPixelColor(0, 0, Color::white);
+	}
+
+	TextureHandle::TextureHandle(std::shared_ptr<State> p_state) : m_state(std::move(p_state))
+	{
+	}
+
+	const Texture* TextureHandle::get() const
+	{
+		return m_state ? &m_state->m_texture : nullptr;
+	}
+
+	bool TextureHandle::isReady() const
+	{
+		return m_state && m_state->m_state.load(std::memory_order_acquire) == EState::E_READY;
+	}
+
+	bool TextureHandle::hasFailed() const
+	{
+		return m_state && m_state->m_state.load(std::memory_order_acquire) == EState::E_FAILED;
+	}
+
+	const std::string& TextureHandle::getError() const
+	{
+		static const std::string noError;
+
+		return hasFailed() ? m_state->m_error : noError;
+	}
+
+	TextureLoader::TextureLoader(const size_t p_threadCount) : m_pool(p_threadCount)
+	{
+	}
+
+	TextureHandle TextureLoader::load(const std::string& p_imagePath, const ETextureLayout p_layout,
+		const ETextureCompression p_compression)
+	{
+		auto state = std::make_shared<TextureHandle::State>();
+		m_pending.push_back(state);
+
+		m_pool.enqueue([state, p_imagePath, p_layout, p_compression]
+		{
+			try
+			{
+				// The file is read then decoded on the worker, the rendering thread never waits on either
+				const MappedFile file(p_imagePath);
+				state->m_decoded = std::make_unique<Texture>(Texture::decode(file.getData(), file.getSize(), p_layout));
+
+				if (p_compression != ETextureCompression::E_NONE)
+					state->m_decoded->compress(p_compression);
+
+				state->m_state.store(TextureHandle::EState::E_DECODED, std::memory_order_release);
+			}
+			catch (const std::exception& e)
+			{
+				state->m_error = e.what();
+				state->m_state.store(TextureHandle::EState::E_FAILED, std::memory_order_release);
+			}
+		});
+
+		return TextureHandle(state);
+	}
+
+	size_t TextureLoader::update()
+	{
+		size_t readyCount = 0;
+
+		for (size_t i = 0; i < m_pending.size();)
+		{
+			TextureHandle::State& state = *m_pending[i];
+			const TextureHandle::EState currentState = state.m_state.load(std::memory_order_acquire);
+
+			if (currentState == TextureHandle::EState::E_LOADING)
+			{
+				i++;
+				continue;
+			}
+
+			// Swapped here rather than on the worker so no frame ever samples a texture being replaced
+			if (currentState == TextureHandle::EState::E_DECODED)
+			{
+				state.m_texture = std::move(*state.m_decoded);
+				state.m_decoded.reset();
+				state.m_state.store(TextureHandle::EState::E_READY, std::memory_order_release);
+				readyCount++;
+			}
+
+			m_pending[i] = std::move(m_pending.back());
+			m_pending.pop_back();
+		}
+
+		return readyCount;
+	}
+
+	bool TextureLoader::isLoading() const
+	{
+		return !m_pending.empty();
+	}
+}
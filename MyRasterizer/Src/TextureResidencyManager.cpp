@@ -0,0 +1,248 @@
+#include "TextureResidencyManager.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "MappedFile.h"
+
+namespace My
+{
+	TextureResidencyManager::TextureResidencyManager(const size_t p_budget, const size_t p_threadCount) :
+		m_budget(p_budget), m_pool(p_threadCount)
+	{
+	}
+
+	void TextureResidencyManager::manage(Texture& p_texture, const std::string& p_imagePath)
+	{
+		for (const Entry& entry : m_entries)
+		{
+			if (entry.m_texture == &p_texture)
+				throw std::invalid_argument("Texture is already managed");
+		}
+
+		Entry entry;
+		entry.m_texture = &p_texture;
+		entry.m_imagePath = p_imagePath;
+		entry.m_layout = p_texture.getLayout();
+		entry.m_compression = p_texture.getCompression();
+		entry.m_levelCount = p_texture.getMipLevelCount();
+		entry.m_imageSize = static_cast<size_t>(p_texture.getWidth()) * p_texture.getHeight() * sizeof(Color);
+
+		// Until it is sampled, the texture is treated as the least recently used
+		entry.m_lastUsedFrame = m_frame;
+
+		// Forgets what was sampled before the texture was managed
+		int32_t level;
+		p_texture.takeSampledLevel(level);
+
+		m_entries.push_back(std::move(entry));
+	}
+
+	void TextureResidencyManager::release(const Texture& p_texture)
+	{
+		const size_t index = findEntry(p_texture);
+
+		// A reload still running only writes to its own texture, which is dropped once it is done
+		m_entries[index] = std::move(m_entries.back());
+		m_entries.pop_back();
+	}
+
+	size_t TextureResidencyManager::update()
+	{
+		m_frame++;
+
+		std::vector<uint8_t> hasChanged(m_entries.size(), 0);
+
+		// The sampled levels are relative to the levels resident while the frame was rendered,
+		// so they are read before the reloads are applied
+		for (Entry& entry : m_entries)
+		{
+			int32_t level;
+
+			if (!entry.m_texture->takeSampledLevel(level))
+				continue;
+
+			const int64_t wantedLevel = static_cast<int64_t>(entry.m_firstLevel) + level;
+
+			entry.m_lastUsedFrame = m_frame;
+			entry.m_wantedLevel = static_cast<size_t>(std::max<int64_t>(std::min<int64_t>(wantedLevel,
+				static_cast<int64_t>(entry.m_levelCount) - 1), 0));
+		}
+
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			Entry& entry = m_entries[i];
+
+			if (entry.m_reload == nullptr || !entry.m_reload->m_isDone.load(std::memory_order_acquire))
+				continue;
+
+			// Failed reloads leave the texture as it is, they are retried on a later update
+			if (entry.m_reload->m_texture != nullptr)
+			{
+				*entry.m_texture = std::move(*entry.m_reload->m_texture);
+				entry.m_firstLevel = entry.m_reload->m_firstLevel;
+				hasChanged[i] = 1;
+			}
+
+			entry.m_reload.reset();
+		}
+
+		size_t residentSize = getResidentSize();
+
+		// Least recently used first, then largest first
+		std::vector<size_t> order(m_entries.size());
+
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+
+		std::sort(order.begin(), order.end(), [this](const size_t p_a, const size_t p_b)
+		{
+			const Entry& a = m_entries[p_a];
+			const Entry& b = m_entries[p_b];
+
+			if (a.m_lastUsedFrame != b.m_lastUsedFrame)
+				return a.m_lastUsedFrame < b.m_lastUsedFrame;
+
+			return a.m_texture->getMemorySize() > b.m_texture->getMemorySize();
+		});
+
+		// The levels finer than sampled go first, then the textures are degraded one level at a time
+		for (int pass = 0; pass < 2 && residentSize > m_budget; pass++)
+		{
+			bool hasDropped = true;
+
+			while (hasDropped && residentSize > m_budget)
+			{
+				hasDropped = false;
+
+				for (const size_t index : order)
+				{
+					if (residentSize <= m_budget)
+						break;
+
+					Entry& entry = m_entries[index];
+					const size_t lastLevel = pass == 0 ? entry.m_wantedLevel : entry.m_levelCount - 1;
+
+					if (entry.m_firstLevel >= lastLevel)
+						continue;
+
+					const size_t size = entry.m_texture->getMemorySize();
+
+					entry.m_texture->dropMipLevels(1);
+					entry.m_firstLevel++;
+					entry.m_reload.reset();
+
+					residentSize -= size - entry.m_texture->getMemorySize();
+					hasChanged[index] = 1;
+					hasDropped = true;
+				}
+			}
+		}
+
+		// Pending reloads will take their share of the budget once applied, and hold their decoded image until then
+		size_t expectedSize = residentSize;
+
+		for (const Entry& entry : m_entries)
+		{
+			if (entry.m_reload != nullptr)
+				expectedSize += entry.m_reload->m_extraSize + entry.m_reload->m_transientSize;
+		}
+
+		// Most recently used first
+		for (auto it = order.rbegin(); it != order.rend(); ++it)
+		{
+			Entry& entry = m_entries[*it];
+
+			if (entry.m_reload != nullptr || entry.m_wantedLevel >= entry.m_firstLevel || entry.m_lastUsedFrame != m_frame)
+				continue;
+
+			// Each level is about four times the size of the next one
+			const size_t size = entry.m_texture->getMemorySize();
+			const size_t extraSize = (size << (2 * (entry.m_firstLevel - entry.m_wantedLevel))) - size;
+
+			// The full image is decoded before being reduced, and compressed textures are
+			// compressed from their uncompressed levels
+			const size_t levelsSize = (entry.m_imageSize >> (2 * entry.m_wantedLevel)) * 4 / 3;
+			const size_t transientSize = entry.m_imageSize
+				+ (entry.m_compression != ETextureCompression::E_NONE ? levelsSize : 0);
+
+			if (expectedSize + extraSize + transientSize > m_budget)
+				continue;
+
+			queueReload(entry, entry.m_wantedLevel, extraSize, transientSize);
+			expectedSize += extraSize + transientSize;
+		}
+
+		return static_cast<size_t>(std::count(hasChanged.begin(), hasChanged.end(), 1));
+	}
+
+	size_t TextureResidencyManager::getResidentSize() const
+	{
+		size_t size = 0;
+
+		for (const Entry& entry : m_entries)
+			size += entry.m_texture->getMemorySize();
+
+		return size;
+	}
+
+	size_t TextureResidencyManager::getBudget() const
+	{
+		return m_budget;
+	}
+
+	void TextureResidencyManager::setBudget(const size_t p_budget)
+	{
+		m_budget = p_budget;
+	}
+
+	size_t TextureResidencyManager::getFirstResidentLevel(const Texture& p_texture) const
+	{
+		return m_entries[findEntry(p_texture)].m_firstLevel;
+	}
+
+	size_t TextureResidencyManager::findEntry(const Texture& p_texture) const
+	{
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			if (m_entries[i].m_texture == &p_texture)
+				return i;
+		}
+
+		throw std::invalid_argument("Texture isn't managed");
+	}
+
+	void TextureResidencyManager::queueReload(Entry& p_entry, const size_t p_firstLevel, const size_t p_extraSize,
+		const size_t p_transientSize)
+	{
+		auto reload = std::make_shared<Reload>();
+		reload->m_firstLevel = p_firstLevel;
+		reload->m_extraSize = p_extraSize;
+		reload->m_transientSize = p_transientSize;
+		p_entry.m_reload = reload;
+
+		m_pool.enqueue([reload, path = p_entry.m_imagePath, layout = p_entry.m_layout,
+			compression = p_entry.m_compression]
+		{
+			try
+			{
+				const MappedFile file(path);
+				auto texture = std::make_unique<Texture>(Texture::decode(file.getData(), file.getSize(), layout,
+					reload->m_firstLevel));
+
+				if (compression != ETextureCompression::E_NONE)
+					texture->compress(compression);
+
+				reload->m_texture = std::move(texture);
+			}
+			catch (const std::exception&)
+			{
+				reload->m_texture.reset();
+			}
+
+			reload->m_isDone.store(true, std::memory_order_release);
+		});
+	}
+}
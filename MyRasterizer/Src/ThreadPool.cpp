@@ -0,0 +1,159 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace My
+{
+	ThreadPool::ThreadPool(size_t p_threadCount)
+	{
+		if (p_threadCount == 0)
+			p_threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		m_workers.reserve(p_threadCount);
+
+		for (size_t i = 0; i < p_threadCount; i++)
+			m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isStopping = true;
+		}
+
+		m_condition.notify_all();
+
+		for (auto& worker : m_workers)
+			worker.join();
+	}
+
+	size_t ThreadPool::getThreadCount() const
+	{
+		return m_workers.size();
+	}
+
+	void ThreadPool::parallelFor(const size_t p_count, const RangeFunc& p_func, const size_t p_minChunkSize)
+	{
+		if (p_count == 0)
+			return;
+
+		// A few chunks per thread to balance uneven workloads
+		const size_t maxChunkCount = (m_workers.size() + 1) * 4;
+		const size_t chunkSize = std::max(std::max<size_t>(p_minChunkSize, 1),
+			(p_count + maxChunkCount - 1) / maxChunkCount);
+		const size_t chunkCount = (p_count + chunkSize - 1) / chunkSize;
+
+		if (chunkCount == 1)
+		{
+			p_func(0, p_count);
+			return;
+		}
+
+		// Shared with the helper tasks since they can start after this call returns
+		struct Job
+		{
+			RangeFunc			m_func;
+			std::atomic<size_t>	m_nextChunk{ 0 };
+			std::atomic<size_t>	m_doneChunks{ 0 };
+			size_t				m_chunkSize = 0;
+			size_t				m_chunkCount = 0;
+			size_t				m_count = 0;
+			std::exception_ptr	m_exception;
+			std::mutex			m_mutex;
+			std::condition_variable	m_condition;
+		};
+
+		auto job = std::make_shared<Job>();
+		job->m_func = p_func;
+		job->m_chunkSize = chunkSize;
+		job->m_chunkCount = chunkCount;
+		job->m_count = p_count;
+
+		const auto runChunks = [](Job& p_job)
+		{
+			for (size_t chunk = p_job.m_nextChunk++; chunk < p_job.m_chunkCount; chunk = p_job.m_nextChunk++)
+			{
+				const size_t begin = chunk * p_job.m_chunkSize;
+				const size_t end = std::min(begin + p_job.m_chunkSize, p_job.m_count);
+
+				try
+				{
+					p_job.m_func(begin, end);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(p_job.m_mutex);
+
+					if (!p_job.m_exception)
+						p_job.m_exception = std::current_exception();
+				}
+
+				if (++p_job.m_doneChunks == p_job.m_chunkCount)
+				{
+					std::lock_guard<std::mutex> lock(p_job.m_mutex);
+					p_job.m_condition.notify_all();
+				}
+			}
+		};
+
+		const size_t helperCount = std::min(m_workers.size(), chunkCount - 1);
+
+		for (size_t i = 0; i < helperCount; i++)
+			push([job, runChunks] { runChunks(*job); });
+
+		// The calling thread works too so nested calls can't deadlock
+		runChunks(*job);
+
+		std::unique_lock<std::mutex> lock(job->m_mutex);
+		job->m_condition.wait(lock, [&job] { return job->m_doneChunks == job->m_chunkCount; });
+
+		if (job->m_exception)
+			std::rethrow_exception(job->m_exception);
+	}
+
+	void ThreadPool::enqueue(std::function<void()> p_task)
+	{
+		push(std::move(p_task));
+	}
+
+	ThreadPool& ThreadPool::getDefault()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::push(std::function<void()> p_task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.push(std::move(p_task));
+		}
+
+		m_condition.notify_one();
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this] { return m_isStopping || !m_tasks.empty(); });
+
+				if (m_isStopping && m_tasks.empty())
+					return;
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
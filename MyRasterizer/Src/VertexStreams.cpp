@@ -0,0 +1,116 @@
+#include "VertexStreams.h"
+
+namespace My
+{
+	VertexStreams::VertexStreams(const std::vector<Vertex>& p_vertices)
+	{
+		const size_t count = p_vertices.size();
+
+		if (count == 0)
+			return;
+
+		const size_t paddedCount = (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+		m_positionX.reserve(paddedCount);
+		m_positionY.reserve(paddedCount);
+		m_positionZ.reserve(paddedCount);
+		m_normalX.reserve(paddedCount);
+		m_normalY.reserve(paddedCount);
+		m_normalZ.reserve(paddedCount);
+		m_colors.reserve(count);
+		m_u.reserve(count);
+		m_v.reserve(count);
+
+		for (size_t i = 0; i < paddedCount; i++)
+		{
+			const Vertex& vertex = p_vertices[i < count ? i : count - 1];
+
+			m_positionX.push_back(vertex.m_position.m_x);
+			m_positionY.push_back(vertex.m_position.m_y);
+			m_positionZ.push_back(vertex.m_position.m_z);
+			m_normalX.push_back(vertex.m_normal.m_x);
+			m_normalY.push_back(vertex.m_normal.m_y);
+			m_normalZ.push_back(vertex.m_normal.m_z);
+
+			if (i < count)
+			{
+				m_colors.push_back(vertex.m_color);
+				m_u.push_back(vertex.m_u);
+				m_v.push_back(vertex.m_v);
+			}
+		}
+	}
+
+	size_t VertexStreams::size() const
+	{
+		return m_colors.size();
+	}
+
+	bool VertexStreams::empty() const
+	{
+		return m_colors.empty();
+	}
+
+	size_t VertexStreams::getPaddedSize() const
+	{
+		return m_positionX.size();
+	}
+
+	Vector3Streams VertexStreams::getPositions() const
+	{
+		return
+		{
+			{ m_positionX.data(), size() },
+			{ m_positionY.data(), size() },
+			{ m_positionZ.data(), size() }
+		};
+	}
+
+	Vector3Streams VertexStreams::getNormals() const
+	{
+		return
+		{
+			{ m_normalX.data(), size() },
+			{ m_normalY.data(), size() },
+			{ m_normalZ.data(), size() }
+		};
+	}
+
+	StreamView<Color> VertexStreams::getColors() const
+	{
+		return { m_colors.data(), m_colors.size() };
+	}
+
+	TexCoordStreams VertexStreams::getTexCoords() const
+	{
+		return
+		{
+			{ m_u.data(), m_u.size() },
+			{ m_v.data(), m_v.size() }
+		};
+	}
+
+	Vertex VertexStreams::getVertex(const size_t p_index) const
+	{
+		Vertex vertex;
+
+		vertex.m_position = { m_positionX[p_index], m_positionY[p_index], m_positionZ[p_index] };
+		vertex.m_normal = { m_normalX[p_index], m_normalY[p_index], m_normalZ[p_index] };
+		vertex.m_color = m_colors[p_index];
+		vertex.m_u = m_u[p_index];
+		vertex.m_v = m_v[p_index];
+
+		return vertex;
+	}
+
+	std::vector<Vertex> VertexStreams::toVertices() const
+	{
+		std::vector<Vertex> vertices;
+		vertices.reserve(size());
+
+		for (size_t i = 0; i < size(); i++)
+			vertices.push_back(getVertex(i));
+
+		return vertices;
+	}
+}
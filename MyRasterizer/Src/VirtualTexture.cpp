@@ -0,0 +1,400 @@
+#include "VirtualTexture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "Arithmetic.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+namespace My
+{
+	namespace
+	{
+		constexpr char MAGIC[4] = { 'M', 'Y', 'V', 'T' };
+		constexpr uint32_t VERSION = 1;
+
+		constexpr size_t PAGE_TEXEL_COUNT = static_cast<size_t>(VirtualTexture::PAGE_SIZE) * VirtualTexture::PAGE_SIZE;
+
+		// Marks the slots which hold no page yet
+		constexpr size_t NO_PAGE = SIZE_MAX;
+
+		struct PageFileHeader
+		{
+			char		m_magic[4];
+			uint32_t	m_version;
+			uint32_t	m_width;
+			uint32_t	m_height;
+			uint32_t	m_pageSize;
+			uint32_t	m_reserved;
+		};
+
+		/**
+		 * \brief Gives the position of the given texture coordinate in a level of the given size
+		 * \return The position in texels, with texel centers at half coordinates
+		 */
+		float toTexelPosition(const float p_coordinate, const uint32_t p_size)
+		{
+			return (p_coordinate - LibMath::floor(p_coordinate)) * static_cast<float>(p_size) - .5f;
+		}
+	}
+
+	VirtualTexture::VirtualTexture(const uint32_t p_width, const uint32_t p_height, PageLoader p_loader,
+		const size_t p_residentPageCount) :
+		m_width(p_width), m_height(p_height), m_loader(std::move(p_loader))
+	{
+		if (p_width == 0 || p_height == 0)
+			throw std::invalid_argument("Virtual textures can't be empty");
+
+		initialize(p_residentPageCount);
+	}
+
+	VirtualTexture::VirtualTexture(const std::string& p_pageFilePath, const size_t p_residentPageCount) :
+		m_width(0), m_height(0), m_pageFile(std::make_unique<MappedFile>(p_pageFilePath))
+	{
+		PageFileHeader header;
+
+		if (m_pageFile->getSize() < sizeof(header))
+			throw std::runtime_error("Invalid page file: " + p_pageFilePath);
+
+		std::memcpy(&header, m_pageFile->getData(), sizeof(header));
+
+		if (std::memcmp(header.m_magic, MAGIC, sizeof(MAGIC)) != 0 || header.m_width == 0 || header.m_height == 0)
+			throw std::runtime_error("Invalid page file: " + p_pageFilePath);
+
+		if (header.m_version != VERSION)
+			throw std::runtime_error("Unsupported page file version " + std::to_string(header.m_version)
+				+ ". Expected version " + std::to_string(VERSION));
+
+		if (header.m_pageSize != PAGE_SIZE)
+			throw std::runtime_error("Unsupported page size " + std::to_string(header.m_pageSize)
+				+ " in page file: " + p_pageFilePath + ". Expected page size " + std::to_string(PAGE_SIZE));
+
+		m_width = header.m_width;
+		m_height = header.m_height;
+
+		m_loader = [this](const uint32_t p_level, const uint32_t p_pageX, const uint32_t p_pageY, Color* p_texels)
+		{
+			const Level& level = m_levels[p_level];
+			const size_t page = level.m_firstPage + static_cast<size_t>(p_pageY) * level.m_pageCountX + p_pageX;
+			const size_t offset = sizeof(PageFileHeader) + page * PAGE_TEXEL_COUNT * sizeof(Color);
+
+			if (offset + PAGE_TEXEL_COUNT * sizeof(Color) > m_pageFile->getSize())
+				throw std::runtime_error("Invalid page file: a page lies outside of the file");
+
+			std::memcpy(p_texels, m_pageFile->getData() + offset, PAGE_TEXEL_COUNT * sizeof(Color));
+		};
+
+		initialize(p_residentPageCount);
+	}
+
+	uint32_t VirtualTexture::getWidth() const
+	{
+		return m_width;
+	}
+
+	uint32_t VirtualTexture::getHeight() const
+	{
+		return m_height;
+	}
+
+	size_t VirtualTexture::getMipLevelCount() const
+	{
+		return m_levels.size();
+	}
+
+	Color VirtualTexture::sampleTrilinear(const float p_u, const float p_v, const float p_lod) const
+	{
+		const size_t lastLevel = m_levels.size() - 1;
+
+		size_t level = 0;
+		float fraction = 0.f;
+
+		if (p_lod >= static_cast<float>(lastLevel))
+		{
+			level = lastLevel;
+		}
+		else if (p_lod > 0.f)
+		{
+			level = static_cast<size_t>(p_lod);
+			fraction = p_lod - static_cast<float>(level);
+		}
+
+		// Only the finest level is requested, the coarser one is needed by fewer pixels and its fallback is close
+		const Level& requested = m_levels[level];
+		const uint32_t pageX = static_cast<uint32_t>(toTexelPosition(p_u, requested.m_width) + .5f) / PAGE_SIZE;
+		const uint32_t pageY = static_cast<uint32_t>(toTexelPosition(p_v, requested.m_height) + .5f) / PAGE_SIZE;
+		const size_t page = requested.m_firstPage
+			+ static_cast<size_t>(LibMath::min(pageY, requested.m_pageCountY - 1)) * requested.m_pageCountX
+			+ LibMath::min(pageX, requested.m_pageCountX - 1);
+
+		// Most samples hit pages which were already requested, so they only read the flag
+		if (m_requestedPages[page].load(std::memory_order_relaxed) == 0)
+			m_requestedPages[page].store(1, std::memory_order_relaxed);
+
+		const Color color = sampleBilinear(level, p_u, p_v);
+
+		if (fraction > 0.f)
+			return Texture::filterLinear(color, sampleBilinear(level + 1, p_u, p_v), fraction);
+
+		return color;
+	}
+
+	size_t VirtualTexture::update(const size_t p_maxPageCount)
+	{
+		m_frame++;
+
+		std::vector<size_t> missingPages;
+
+		for (size_t page = 0; page < m_pageTable.size(); page++)
+		{
+			if (m_requestedPages[page].exchange(0, std::memory_order_relaxed) == 0)
+				continue;
+
+			if (m_pageTable[page] == NO_SLOT)
+				missingPages.push_back(page);
+			else
+				m_slotLastUsedFrames[m_pageTable[page]] = m_frame;
+		}
+
+		if (missingPages.empty())
+			return 0;
+
+		// Coarser levels come last in the page table. Loading them first gives a closer fallback to the finer ones
+		std::sort(missingPages.begin(), missingPages.end(), std::greater<size_t>());
+
+		// Pages requested by the last frame are kept, the others are replaced least recently used first
+		std::vector<size_t> slots;
+
+		for (size_t slot = m_pinnedSlotCount; slot < m_slotPages.size(); slot++)
+		{
+			if (m_slotLastUsedFrames[slot] != m_frame)
+				slots.push_back(slot);
+		}
+
+		std::sort(slots.begin(), slots.end(), [this](const size_t p_a, const size_t p_b)
+		{
+			return m_slotLastUsedFrames[p_a] < m_slotLastUsedFrames[p_b];
+		});
+
+		const size_t loadCount = LibMath::min(LibMath::min(missingPages.size(), slots.size()), p_maxPageCount);
+
+		missingPages.resize(loadCount);
+		slots.resize(loadCount);
+
+		for (const size_t slot : slots)
+		{
+			if (m_slotPages[slot] != NO_PAGE)
+				m_pageTable[m_slotPages[slot]] = NO_SLOT;
+		}
+
+		loadPages(missingPages, slots);
+
+		return loadCount;
+	}
+
+	size_t VirtualTexture::getResidentPageCount() const
+	{
+		return static_cast<size_t>(std::count_if(m_slotPages.begin(), m_slotPages.end(), [](const size_t p_page)
+		{
+			return p_page != NO_PAGE;
+		}));
+	}
+
+	void VirtualTexture::savePageFile(const std::string& p_path, const Texture& p_texture)
+	{
+		if (p_texture.getCompression() != ETextureCompression::E_NONE || p_texture.getVirtualTexture() != nullptr)
+			throw std::invalid_argument("Only textures with their own pixels can be split in pages");
+
+		// Linear levels are read row by row
+		Texture texture(p_texture);
+		texture.setLayout(ETextureLayout::E_LINEAR);
+
+		if (texture.getMipLevelCount() == 1)
+			texture.generateMipmaps();
+
+		std::ofstream file(p_path, std::ios::binary);
+
+		PageFileHeader header {};
+		std::memcpy(header.m_magic, MAGIC, sizeof(MAGIC));
+		header.m_version = VERSION;
+		header.m_width = texture.getWidth();
+		header.m_height = texture.getHeight();
+		header.m_pageSize = PAGE_SIZE;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<Color> page(PAGE_TEXEL_COUNT);
+		const Color* levelPixels = texture.getPixels();
+		uint32_t width = texture.getWidth();
+		uint32_t height = texture.getHeight();
+
+		for (size_t level = 0; level < texture.getMipLevelCount(); level++)
+		{
+			for (uint32_t pageY = 0; pageY < height; pageY += PAGE_SIZE)
+			{
+				for (uint32_t pageX = 0; pageX < width; pageX += PAGE_SIZE)
+				{
+					std::fill(page.begin(), page.end(), Color::black);
+
+					const uint32_t rowLength = LibMath::min(PAGE_SIZE, width - pageX);
+
+					for (uint32_t y = 0; y < PAGE_SIZE && pageY + y < height; y++)
+					{
+						std::memcpy(page.data() + static_cast<size_t>(y) * PAGE_SIZE,
+							levelPixels + static_cast<size_t>(pageY + y) * width + pageX, rowLength * sizeof(Color));
+					}
+
+					file.write(reinterpret_cast<const char*>(page.data()), static_cast<std::streamsize>(page.size() * sizeof(Color)));
+				}
+			}
+
+			// The first level is apart from its mip chain
+			levelPixels = level == 0 ? texture.getMipPixels() : levelPixels + static_cast<size_t>(width) * height;
+			width = LibMath::max(width / 2, 1u);
+			height = LibMath::max(height / 2, 1u);
+		}
+
+		if (!file)
+			throw std::runtime_error("Unable to write page file: " + p_path);
+	}
+
+	void VirtualTexture::initialize(const size_t p_residentPageCount)
+	{
+		size_t pageCount = 0;
+
+		for (uint32_t width = m_width, height = m_height;;)
+		{
+			const Level level { width, height, (width + PAGE_SIZE - 1) / PAGE_SIZE, (height + PAGE_SIZE - 1) / PAGE_SIZE, pageCount };
+
+			m_levels.push_back(level);
+			pageCount += static_cast<size_t>(level.m_pageCountX) * level.m_pageCountY;
+
+			if (width <= 1 && height <= 1)
+				break;
+
+			width = LibMath::max(width / 2, 1u);
+			height = LibMath::max(height / 2, 1u);
+		}
+
+		// The levels fitting in a single page are the last ones
+		std::vector<size_t> pinnedPages;
+
+		for (const Level& level : m_levels)
+		{
+			if (level.m_pageCountX == 1 && level.m_pageCountY == 1)
+				pinnedPages.push_back(level.m_firstPage);
+		}
+
+		m_pinnedSlotCount = pinnedPages.size();
+
+		const size_t slotCount = m_pinnedSlotCount + p_residentPageCount;
+
+		m_pageTable.assign(pageCount, NO_SLOT);
+		m_slotTexels.resize(slotCount * PAGE_TEXEL_COUNT);
+		m_slotPages.assign(slotCount, NO_PAGE);
+		m_slotLastUsedFrames.assign(slotCount, 0);
+		m_requestedPages = std::make_unique<std::atomic<uint8_t>[]>(pageCount);
+
+		std::vector<size_t> pinnedSlots(m_pinnedSlotCount);
+
+		for (size_t i = 0; i < pinnedSlots.size(); i++)
+			pinnedSlots[i] = i;
+
+		loadPages(pinnedPages, pinnedSlots);
+	}
+
+	size_t VirtualTexture::findPage(const size_t p_page, uint32_t& p_pageX, uint32_t& p_pageY) const
+	{
+		size_t level = m_levels.size() - 1;
+
+		while (m_levels[level].m_firstPage > p_page)
+			level--;
+
+		const size_t pageInLevel = p_page - m_levels[level].m_firstPage;
+
+		p_pageX = static_cast<uint32_t>(pageInLevel % m_levels[level].m_pageCountX);
+		p_pageY = static_cast<uint32_t>(pageInLevel / m_levels[level].m_pageCountX);
+
+		return level;
+	}
+
+	void VirtualTexture::loadPages(const std::vector<size_t>& p_pages, const std::vector<size_t>& p_slots)
+	{
+		// Pages are independent, so the loader's I/O and decoding overlap
+		ThreadPool::getDefault().parallelFor(p_pages.size(), [&](const size_t p_begin, const size_t p_end)
+		{
+			for (size_t i = p_begin; i < p_end; i++)
+			{
+				uint32_t pageX;
+				uint32_t pageY;
+				const size_t level = findPage(p_pages[i], pageX, pageY);
+
+				m_loader(static_cast<uint32_t>(level), pageX, pageY, m_slotTexels.data() + p_slots[i] * PAGE_TEXEL_COUNT);
+			}
+		});
+
+		for (size_t i = 0; i < p_pages.size(); i++)
+		{
+			m_pageTable[p_pages[i]] = static_cast<int32_t>(p_slots[i]);
+			m_slotPages[p_slots[i]] = p_pages[i];
+			m_slotLastUsedFrames[p_slots[i]] = m_frame;
+		}
+	}
+
+	bool VirtualTexture::trySampleBilinear(const size_t p_level, const float p_u, const float p_v, Color& p_color) const
+	{
+		const Level& level = m_levels[p_level];
+		const int width = static_cast<int>(level.m_width);
+		const int height = static_cast<int>(level.m_height);
+
+		const float x = toTexelPosition(p_u, level.m_width);
+		const float y = toTexelPosition(p_v, level.m_height);
+		const float floorX = LibMath::floor(x);
+		const float floorY = LibMath::floor(y);
+
+		// Same addressing as Texture::sampleBilinear, so a fully resident texture samples the same colors
+		const uint32_t x0 = static_cast<uint32_t>(LibMath::max(static_cast<int>(floorX), 0));
+		const uint32_t y0 = static_cast<uint32_t>(LibMath::max(static_cast<int>(floorY), 0));
+		const uint32_t x1 = static_cast<uint32_t>(LibMath::min(static_cast<int>(floorX) + 1, width - 1));
+		const uint32_t y1 = static_cast<uint32_t>(LibMath::min(static_cast<int>(floorY) + 1, height - 1));
+
+		const uint32_t xs[4] = { x0, x1, x0, x1 };
+		const uint32_t ys[4] = { y0, y0, y1, y1 };
+
+		Color texels[4];
+
+		for (int i = 0; i < 4; i++)
+		{
+			const size_t page = level.m_firstPage + static_cast<size_t>(ys[i] / PAGE_SIZE) * level.m_pageCountX
+				+ xs[i] / PAGE_SIZE;
+			const int32_t slot = m_pageTable[page];
+
+			if (slot == NO_SLOT)
+				return false;
+
+			texels[i] = m_slotTexels[static_cast<size_t>(slot) * PAGE_TEXEL_COUNT
+				+ static_cast<size_t>(ys[i] % PAGE_SIZE) * PAGE_SIZE + xs[i] % PAGE_SIZE];
+		}
+
+		p_color = Texture::filterBilinear(texels, x - floorX, y - floorY);
+
+		return true;
+	}
+
+	Color VirtualTexture::sampleBilinear(const size_t p_level, const float p_u, const float p_v) const
+	{
+		Color color = Color::black;
+
+		// The last levels are always resident, so a level is always found
+		for (size_t level = p_level; level < m_levels.size(); level++)
+		{
+			if (trySampleBilinear(level, p_u, p_v, color))
+				break;
+		}
+
+		return color;
+	}
+}